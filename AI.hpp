@@ -6,14 +6,17 @@
 #include "Systems/GameSystem.hpp"
 #include "BrainTree/BrainTree.h"
 
-class Probability : public BrainTree::Leaf
+// expeditions retarget to enemies around the last seen one
+#define AI_EXPEDITION_RADIUS 16
+
+class Probability : public BrainTree::Leaf, public GameSystem
 {
 public:
 	Probability(BrainTree::Blackboard::Ptr board, int per, int frac) : Leaf(board), per(per), frac(frac) {}
 
 	Status update() override
 	{
-		double rnd = (double)rand() / RAND_MAX;
+		double rnd = this->matchRandom().uniform();
 
 		if (rnd < (double)per / (double)frac) {
 			return Node::Status::Success;
@@ -171,7 +174,7 @@ public:
 
 		if (player.objsByType.count(name) > 0) {
 			std::vector<EntityID> explorers = player.objsByType[name];
-			std::random_shuffle ( explorers.begin(), explorers.end() );
+			this->matchRandom().shuffle(explorers.begin(), explorers.end());
 			EntityID explorer = explorers.front();
 
 			if (this->vault->registry.valid(explorer)) {
@@ -184,7 +187,7 @@ public:
 					cnt++;
 				}
 
-				if (exTile.state == "idle") {
+				if (exTile.state == TileStateStr("idle")) {
 #ifdef AI_DEBUG
 					std::cout << "AI: " << entity << " explore with " << explorer << " at " << explorePos.x << "x" << explorePos.y << std::endl;
 #endif
@@ -206,10 +209,14 @@ private:
 	sf::Vector2i getRandExplorationPos(Tile &tile) {
 		sf::Vector2i explorePos;
 
-		if (this->maxDist == -1)
-			explorePos =  sf::Vector2i(rand() % this->map->width, rand() % this->map->height);
-		else
-			explorePos = sf::Vector2i(tile.pos.x + (rand() % (this->maxDist * 2)) - this->maxDist, tile.pos.y + (rand() % (this->maxDist * 2)) - this->maxDist);
+		// x drawn before y, argument evaluation order is unspecified
+		if (this->maxDist == -1) {
+			explorePos.x = this->matchRandom().range(this->map->width);
+			explorePos.y = this->matchRandom().range(this->map->height);
+		} else {
+			explorePos.x = tile.pos.x + this->matchRandom().range(this->maxDist * 2) - this->maxDist;
+			explorePos.y = tile.pos.y + this->matchRandom().range(this->maxDist * 2) - this->maxDist;
+		}
 
 		return explorePos;
 	}
@@ -286,9 +293,9 @@ public:
 
 //			std::random_shuffle ( buildPos.begin(), buildPos.end() );
 
-				obj.mapped = true;
 				tile.pos = buildPos.front();
 				tile.ppos = sf::Vector2f(tile.pos) * 32.0f + 16.0f;
+				this->vault->factory.placeBuilding(this->vault->registry, buildingEnt);
 				player.rootConstruction = 0;
 
 #ifdef AI_DEBUG
@@ -333,7 +340,7 @@ public:
 		}
 
 		if (plantAround.size() > 0) {
-			std::random_shuffle ( plantAround.begin(), plantAround.end() );
+			this->matchRandom().shuffle(plantAround.begin(), plantAround.end());
 			if (this->vault->registry.valid(plantAround.front())) {
 				this->seedResources(name, plantAround.front());
 
@@ -364,7 +371,7 @@ public:
 		if (player.objsByType.count(parentName) > 0) {
 			std::vector<EntityID> trainAround = player.objsByType[parentName];
 
-			std::random_shuffle ( trainAround.begin(), trainAround.end() );
+			this->matchRandom().shuffle(trainAround.begin(), trainAround.end());
 			if (this->trainUnit(name, entity, trainAround.front() )) {
 #ifdef AI_DEBUG
 				std::cout << "AI: " << entity << " train " << name << " around " << trainAround.front() << std::endl;
@@ -395,11 +402,25 @@ public:
 		Player &player = vault->registry.get<Player>(entity);
 
 		if (player.enemyFound && player.objsByType.count(name) > 0) {
+			TeamID team = TeamIDStr(player.team.c_str());
+			// follow the enemy seen last, among the ones still in sight
+			sf::Vector2i enemyPos;
+			if (this->map->teamObjs.nearestEnemy(team, player.enemyPos, AI_EXPEDITION_RADIUS, [&player](const TeamObject & object) {
+				return player.fog.get(object.pos.x, object.pos.y) == FogState::InSight;
+			}, &enemyPos))
+				player.enemyPos = enemyPos;
+
+			// weakest enemy position in explored cells, or the enemy seen last
+			sf::Vector2i destPos = player.enemyPos;
+			this->map->influence.weakestEnemy(team, destPos, [&player](sf::Vector2i center) {
+				return player.fog.get(center.x, center.y) != FogState::Unvisited;
+			});
+
 			int tot = player.objsByType[name].size();
 			int perCnt = (int)((float)per / 100.0 * (float)tot);
 
 			std::vector<EntityID> attackers = player.objsByType[name];
-			std::random_shuffle ( attackers.begin(), attackers.end() );
+			this->matchRandom().shuffle(attackers.begin(), attackers.end());
 
 			std::vector<EntityID> group;
 
@@ -408,16 +429,16 @@ public:
 				if (this->vault->registry.valid(attacker)) {
 					Tile &atTile = this->vault->registry.get<Tile>(attacker);
 
-					if (atTile.state == "idle" && distance(atTile.pos, player.enemyPos) > 8) {
+					if (atTile.state == TileStateStr("idle") && distance(atTile.pos, destPos) > 8) {
 #ifdef AI_DEBUG
-						std::cout << "AI: " << entity << " launch expedition with " << attacker << " at " << player.enemyPos.x << "x" << player.enemyPos.y << std::endl;
+						std::cout << "AI: " << entity << " launch expedition with " << attacker << " at " << destPos.x << "x" << destPos.y << std::endl;
 #endif
 						group.push_back(attacker);
 //						this->goTo(attacker, player.enemyPos);
 					}
 				}
 			}
-			this->groupGoTo(group, player.enemyPos, GroupFormation::Square, North, false);
+			this->groupGoTo(group, destPos, GroupFormation::Square, North, false);
 			return Node::Status::Success;
 		} else {
 			return Node::Status::Failure;
@@ -445,7 +466,7 @@ public:
 			int perCnt = (int)((float)per / 100.0 * (float)tot);
 
 			std::vector<EntityID> attackers = player.objsByType[name];
-			std::random_shuffle ( attackers.begin(), attackers.end() );
+			this->matchRandom().shuffle(attackers.begin(), attackers.end());
 
 			std::vector<EntityID> group;
 			sf::Vector2i destPos = player.frontPoints.back().pos;
@@ -455,7 +476,7 @@ public:
 				if (this->vault->registry.valid(attacker)) {
 					Tile &atTile = this->vault->registry.get<Tile>(attacker);
 
-					if (atTile.state == "idle" && distance(atTile.pos, destPos) > 8) {
+					if (atTile.state == TileStateStr("idle") && distance(atTile.pos, destPos) > 8) {
 #ifdef AI_DEBUG
 						std::cout << "AI: " << entity << " send defense with " << attacker << " at " << destPos.x << "x" << destPos.y << std::endl;
 #endif
@@ -553,6 +574,8 @@ public:
 			std::cout << "AI: probability " << per << "/" << frac << std::endl;
 #endif
 			auto node = std::make_shared<Probability>(blackboard, per, frac);
+			node->map = this->map;
+			node->setVault(this->vault);
 			return node;
 		}
 		case AINode("HasMoreResourcesThan"): {
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+// fixed pool of threads splitting a range in chunks, the calling thread takes chunks too
+// run() returns when every chunk is done, no thread means the range is done by the caller
+class ChunkWorkers {
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable runCond;
+	std::condition_variable doneCond;
+
+	std::function<void(unsigned int, unsigned int)> task;
+	unsigned int count;
+	unsigned int chunkSize;
+	std::atomic<unsigned int> nextChunk;
+
+	unsigned long generation;
+	int running;
+	bool stopping;
+
+public:
+	ChunkWorkers() {
+		this->count = 0;
+		this->chunkSize = 1;
+		this->nextChunk = 0;
+		this->generation = 0;
+		this->running = 0;
+		this->stopping = false;
+	}
+
+	~ChunkWorkers() {
+		this->stop();
+	}
+
+	void start(int count) {
+		this->stopping = false;
+		for (int i = 0; i < count; ++i) {
+			this->threads.push_back(std::thread(&ChunkWorkers::work, this));
+		}
+	}
+
+	void stop() {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->runCond.notify_all();
+		for (std::thread &thread : this->threads) {
+			thread.join();
+		}
+		this->threads.clear();
+	}
+
+	int size() const {
+		return this->threads.size();
+	}
+
+	// call f(begin, end) on every chunk of [0, count)
+	void run(unsigned int count, unsigned int chunkSize, std::function<void(unsigned int, unsigned int)> f) {
+		if (this->threads.size() == 0 || count <= chunkSize) {
+			if (count > 0)
+				f(0, count);
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->task = f;
+			this->count = count;
+			this->chunkSize = chunkSize;
+			this->nextChunk = 0;
+			this->running = this->threads.size();
+			this->generation++;
+		}
+		this->runCond.notify_all();
+
+		this->chunks();
+
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->doneCond.wait(lock, [this] { return this->running == 0; });
+		this->task = nullptr;
+	}
+
+private:
+	void chunks() {
+		while (true) {
+			unsigned int begin = this->nextChunk.fetch_add(this->chunkSize);
+			if (begin >= this->count)
+				return;
+			this->task(begin, std::min(this->count, begin + this->chunkSize));
+		}
+	}
+
+	void work() {
+		unsigned long seen = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->runCond.wait(lock, [this, seen] { return this->stopping || this->generation != seen; });
+				if (this->stopping)
+					return;
+				seen = this->generation;
+			}
+
+			this->chunks();
+
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->running--;
+			}
+			this->doneCond.notify_all();
+		}
+	}
+};
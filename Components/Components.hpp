@@ -12,8 +12,10 @@
 #include "Options.hpp"
 
 #include "FlowField.hpp"
+#include "Steering.hpp"
 
 #include "ParticleEffect.hpp"
+#include "MatchRandom.hpp"
 
 static const sf::Vector2f directionVectors[8] = {
 	sf::Vector2f(0.0, -1.0),
@@ -33,6 +35,10 @@ struct Tile {
 	sf::Vector2f ppos; // pixel pos
 	sf::Vector2i pos; // map pos
 
+	// pixel pos before the simulation step lastStep, drawn interpolated toward ppos
+	sf::Vector2f lastPpos;
+	unsigned long lastStep;
+
 	sf::Vector2i offset; // offset
 
 	int z;
@@ -41,7 +47,7 @@ struct Tile {
 
 	sf::Sprite sprite;
 
-	std::string state;
+	TileState state;
 	unsigned int view;
 
 	bool shader;
@@ -50,21 +56,22 @@ struct Tile {
 
 	Tile() {
 		this->z = 0;
+		this->lastStep = 0;
 		this->view = 0;
-		this->state = "idle";
+		this->state = TileStateStr("idle");
 		this->shader = false;
 	}
 };
 
 struct Timer {
 	EntityID emitterEntity;
-	std::string name;
+	TimerName name;
 	bool loop; // is looping
 	float duration; // loop duration
 	float t; // current time since beginning
 	int l; // number of loop since beginning
 
-	Timer(EntityID entity, std::string n, float d, bool lo) {
+	Timer(EntityID entity, TimerName n, float d, bool lo) {
 		this->emitterEntity = entity;
 		this->name = n;
 		this->t = 0.0;
@@ -74,7 +81,7 @@ struct Timer {
 	}
 
 
-	Timer(std::string n, float d, bool lo) {
+	Timer(TimerName n, float d, bool lo) {
 		this->emitterEntity = 0;
 		this->name = n;
 		this->t = 0.0;
@@ -85,6 +92,7 @@ struct Timer {
 
 	Timer() {
 		this->emitterEntity = 0;
+		this->name = 0;
 		this->loop = true;		
 		this->t = 0.0;
 		this->l = 0;		
@@ -122,17 +130,18 @@ struct AnimatedSpriteView {
 };
 
 struct StaticSpritesheet {
-	std::map<std::string, std::vector<SpriteView>> states;
+	std::map<TileState, std::vector<SpriteView>> states;
 };
 
 struct AnimatedSpritesheet {
-	std::map<std::string, std::vector<AnimatedSpriteView>> states;
+	std::map<TileState, std::vector<AnimatedSpriteView>> states;
 };
 
 // unit or building
 struct GameObject {
 	std::string name;
 	std::string team;
+	TeamID teamId;
 
 	float life;
 	float maxLife;
@@ -141,6 +150,9 @@ struct GameObject {
 	bool mapped;
 
 	EntityID player;
+
+	// creation order in the match, replay commands refer to objects by it
+	unsigned long serial;
 };
 
 struct Attack {
@@ -193,7 +205,6 @@ struct Unit {
 	bool commanded;
 
 	unsigned int nopath;
-	unsigned int reallyNopath;
 
 	std::string sound;
 	std::map<std::string, int> soundActions;
@@ -201,6 +212,9 @@ struct Unit {
 	std::string attackSound;
 
 	FlowFieldPath flowFieldPath;
+	// shared group order field, followed until the final sector of groupDest
+	std::shared_ptr<GroupFlowField> groupField;
+	sf::Vector2i groupDest;
 
 	SpecialSkill special;
 
@@ -210,7 +224,6 @@ struct Unit {
 		this->averageVelocity = sf::Vector2f(0, 0);
 		this->direction = sf::Vector2i(0, 0);
 		this->nopath = 0;
-		this->reallyNopath = 0;
 		this->commanded = false;
 		this->pathUpdate = false;
 		this->special = SpecialSkillStr("none");
@@ -220,8 +233,6 @@ struct Unit {
 	}
 };
 
-#define MAX_FORCE 0.1f
-
 class PathfindingObject : public sf::Vector2f {
 public:
 	EntityID entity;
@@ -278,12 +289,12 @@ struct Decor {
 	bool blocking;
 };
 
+// center of a cluster of threatened cells, priority is its threat
 struct FrontPoint {
 	sf::Vector2i pos;
-	int priority;
+	float priority;
 };
 
-
 class FrontPointCompare
 {
 public:
@@ -309,7 +320,7 @@ struct Player {
 	bool enemyFound;
 	sf::Vector2i enemyPos;
 
-	std::vector<sf::Vector2i> allFrontPoints;
+	// most threatened last
 	std::vector<FrontPoint> frontPoints;
 
 	Fog fog;
@@ -369,4 +380,54 @@ struct GameController {
 		this->debugCorner = 1;
 		this->showDebugWindow = false;
 	}
-};
\ No newline at end of file
+};
+
+// fixed step simulation clock
+struct SimulationClock {
+	unsigned long steps;
+	// fraction of a step elapsed since the last one, for drawing
+	float alpha;
+
+	SimulationClock() {
+		this->steps = 0;
+		this->alpha = 1.0f;
+	}
+};
+
+// last game object serial, entity ids also count effects, which headless runs do not create
+struct GameObjectSerials {
+	unsigned long last;
+
+	GameObjectSerials() {
+		this->last = 0;
+	}
+};
+
+// pathfinding counters, shown in debug window
+struct PathfindingStats {
+	unsigned long cacheHits;
+	unsigned long cacheMisses;
+	unsigned long cacheInvalidations;
+	int cacheSize;
+
+	int queueDepth;
+	int workers;
+	unsigned long staleResults;
+	// search requests latencies percentiles, in ticks
+	unsigned int latencyP50;
+	unsigned int latencyP95;
+	unsigned int latencyP99;
+
+	PathfindingStats() {
+		this->cacheHits = 0;
+		this->cacheMisses = 0;
+		this->cacheInvalidations = 0;
+		this->cacheSize = 0;
+		this->queueDepth = 0;
+		this->workers = 0;
+		this->staleResults = 0;
+		this->latencyP50 = 0;
+		this->latencyP95 = 0;
+		this->latencyP99 = 0;
+	}
+};
@@ -4,3 +4,9 @@
 typedef uint32_t EntityID;
 typedef entt::HashedString::hash_type EntityType;
 typedef entt::HashedString EntityTypeStr;
+typedef entt::HashedString::hash_type TeamID;
+typedef entt::HashedString TeamIDStr;
+typedef entt::HashedString::hash_type TileState;
+typedef entt::HashedString TileStateStr;
+typedef entt::HashedString::hash_type TimerName;
+typedef entt::HashedString TimerNameStr;
@@ -1,4 +1,5 @@
 #include "EntityFactory.hpp"
+#include "Events.hpp"
 
 #define UNIT_FRAME_COUNT 10
 
@@ -6,10 +7,24 @@ sf::Texture &EntityFactory::getTex(std::string name) {
 	return texManager.getRef(name);
 }
 
+sf::Vector2u EntityFactory::getTexSize(std::string name) {
+	return texManager.getSize(name);
+}
+
 sf::SoundBuffer &EntityFactory::getSndBuf(std::string name) {
 	return sndManager.getRef(name);
 }
 
+void EntityFactory::setHeadless(bool headless) {
+	texManager.setHeadless(headless);
+	sndManager.setHeadless(headless);
+	shrManager.setHeadless(headless);
+}
+
+void EntityFactory::setDispatcher(entt::UnmanagedDispatcher *dispatcher) {
+	this->dispatcher = dispatcher;
+}
+
 void EntityFactory::loadInitial() {
 	fntManager.load("samos", "medias/fonts/samos.ttf");
 	texLoader.loadTextureWithWhiteMask("intro_background", "medias/interface/bgs/toile.png");
@@ -316,13 +331,15 @@ void EntityFactory::destroyEntity(entt::Registry<EntityID> &registry, EntityID e
 #ifdef FACTORY_DEBUG
 	std::cout << "EntityFactory: destroy " << entity << std::endl;
 #endif
+	if (this->dispatcher && registry.has<Tile>(entity) && (registry.has<Building>(entity) || registry.has<Decor>(entity)))
+		this->dispatcher->trigger<ObstacleRemoved>(entity);
 	registry.destroy(entity);
 }
 
-std::string EntityFactory::randGroupName(std::string name) {
+std::string EntityFactory::randGroupName(entt::Registry<EntityID> &registry, std::string name) {
 	std::vector<std::string> groupMembers = this->groups[name];
 
-	int rnd = rand() % groupMembers.size();
+	int rnd = registry.get<MatchRandom>().range(groupMembers.size());
 	return groupMembers[rnd];
 }
 
@@ -333,10 +350,10 @@ void EntityFactory::addStaticVerticalSpriteView(std::vector<SpriteView> &states,
 }
 
 void EntityFactory::setDefaultSpritesheet(StaticSpritesheet& spritesheet, Tile &tile, int y) {
-	spritesheet.states["idle"] = std::vector<SpriteView>();
+	spritesheet.states[TileStateStr("idle")] = std::vector<SpriteView>();
 	int frameCount = y / tile.psize.y;
 	for (int n = 0; n < frameCount; n++) {
-		spritesheet.states["idle"].push_back(SpriteView{sf::Vector2i(0, n)});
+		spritesheet.states[TileStateStr("idle")].push_back(SpriteView{sf::Vector2i(0, n)});
 	}
 }
 
@@ -381,9 +398,9 @@ void EntityFactory::assignSpritesheets(entt::Registry<EntityID> &registry, Entit
 	if (this->getXmlComponent(name, "spritesheets") && spritesheetsParser.parseAnimatedSpritesheets(animSpritesheet, this->getXmlComponent(name, "spritesheets"))) {
 		registry.accomodate<AnimatedSpritesheet>(entity, animSpritesheet);
 
-		if (animSpritesheet.states.count("idle") > 0) {
-			AnimatedSpriteView &view = animSpritesheet.states["idle"][0];
-			Timer timer("idle", view.duration * view.frames.size(), true);
+		if (animSpritesheet.states.count(TileStateStr("idle")) > 0) {
+			AnimatedSpriteView &view = animSpritesheet.states[TileStateStr("idle")][0];
+			Timer timer(TimerNameStr("idle"), view.duration * view.frames.size(), true);
 			registry.accomodate<Timer>(entity, timer);
 		}
 
@@ -410,6 +427,7 @@ EntityID EntityFactory::createUnit(entt::Registry<EntityID> &registry, EntityID
 
 	obj.player = playerEnt;
 	obj.mapped = true;
+	obj.serial = ++registry.get<GameObjectSerials>().last;
 
 	Unit unit;
 	unitParser.parse(unit, this->getXmlComponent(name, "unit"));
@@ -448,6 +466,7 @@ EntityID EntityFactory::startBuilding(entt::Registry<EntityID> &registry, std::s
 	obj.player = 0;
 	obj.mapped = false;
 	obj.maxLife = obj.life;
+	obj.serial = ++registry.get<GameObjectSerials>().last;
 
 	registry.assign<GameObject>(entity, obj);
 	registry.assign<Building>(entity, building);
@@ -500,6 +519,8 @@ bool EntityFactory::placeBuilding(entt::Registry<EntityID> &registry, EntityID e
 	Building &building = registry.get<Building>(entity);
 	GameObject &obj = registry.get<GameObject>(entity);
 	obj.mapped = true;
+	if (this->dispatcher)
+		this->dispatcher->trigger<ObstacleAdded>(entity);
 	if (building.constructedBy) {
 		Building &buildingBy = registry.get<Building>(building.constructedBy);
 		buildingBy.construction = 0;
@@ -531,7 +552,7 @@ EntityID EntityFactory::plantResource(entt::Registry<EntityID> &registry, std::s
 	resource.type = name;
 	resource.level = 0;
 	resource.grow = 0.0;
-	resource.growRate = 0.05 + (rand() % 5) / 100.0;
+	resource.growRate = 0.05 + registry.get<MatchRandom>().range(5) / 100.0;
 
 	registry.assign<Tile>(entity, tile);
 	registry.assign<Resource>(entity, resource);
@@ -540,7 +561,7 @@ EntityID EntityFactory::plantResource(entt::Registry<EntityID> &registry, std::s
 }
 
 EntityID EntityFactory::growedResource(entt::Registry<EntityID> &registry, std::string name, EntityID entity) {
-	std::string rname = this->randGroupName(name);
+	std::string rname = this->randGroupName(registry, name);
 	Tile &oldTile = registry.get<Tile>(entity);
 
 	Tile tile;
@@ -596,7 +617,7 @@ EntityID EntityFactory::createParticleEffect(entt::Registry<EntityID> &registry,
 }
 
 EntityID EntityFactory::createDecor(entt::Registry<EntityID> &registry, std::string name, int x, int y) {
-	std::string rname = this->randGroupName(name);
+	std::string rname = this->randGroupName(registry, name);
 
 	EntityID entity = registry.create();
 #ifdef FACTORY_DEBUG
@@ -651,7 +672,7 @@ EntityID EntityFactory::createPlayer(entt::Registry<EntityID> &registry, std::st
 	return entity;
 }
 
-EntityID EntityFactory::createTimer(entt::Registry<EntityID> &registry, EntityID emitterEnt, std::string name, float duration, bool loop) {
+EntityID EntityFactory::createTimer(entt::Registry<EntityID> &registry, EntityID emitterEnt, TimerName name, float duration, bool loop) {
 	EntityID entity = registry.create();
 	Timer timer(emitterEnt, name, duration, loop);
 	registry.assign<Timer>(entity, timer);
@@ -719,4 +740,5 @@ EntityFactory::EntityFactory() {
 	texLoader.setManager(&texManager);
 	sndLoader.setManager(&sndManager);
 	this->loaded = false;
+	this->dispatcher = nullptr;
 }
@@ -11,6 +11,7 @@
 
 #include "third_party/tinyxml2.h"
 #include "third_party/tixml2ex.h"
+#include "third_party/entt/signal/dispatcher.hpp"
 
 #include "XmlParsers/ParticleEffectParser.hpp"
 #include "XmlParsers/XmlLoaders.hpp"
@@ -67,6 +68,9 @@ class EntityFactory {
 
 	std::map<int, std::vector<sf::Color> > playerColors;
 
+	// obstacle events of placed and destroyed buildings and decors, none if null
+	entt::UnmanagedDispatcher *dispatcher;
+
 public:
 	TextureManager texManager;
 	SoundBufferManager sndManager;
@@ -88,8 +92,14 @@ public:
 	std::map<std::string, int> decorGenerator;
 
 	sf::Texture &getTex(std::string name);
+	sf::Vector2u getTexSize(std::string name);
 	sf::SoundBuffer &getSndBuf(std::string name);
 
+	// load without GL context nor audio device
+	void setHeadless(bool headless);
+
+	void setDispatcher(entt::UnmanagedDispatcher *dispatcher);
+
 	std::vector<TechNode *> getTechNodes(std::string team);
 	TechNode *getTechNode(std::string team, std::string type);
 	TechNode *getTechRoot(std::string team);
@@ -122,6 +132,7 @@ public:
 // Building
 	EntityID startBuilding(entt::Registry<EntityID> &registry, std::string name, EntityID constructedBy);
 	EntityID finishBuilding(entt::Registry<EntityID> &registry, EntityID entity, EntityID playerEnt, int x, int y, bool built);
+	// maps a finished building at its tile position, true if it was built by another building
 	bool placeBuilding(entt::Registry<EntityID> &registry, EntityID entity);
 
 	EntityID plantResource(entt::Registry<EntityID> &registry, std::string name, int x, int y);
@@ -129,7 +140,7 @@ public:
 	EntityID createParticleEffect(entt::Registry<EntityID> &registry, std::string name, ParticleEffectOptions options);
 	EntityID createDecor(entt::Registry<EntityID> &registry, std::string name, int x, int y);
 
-	EntityID createTimer(entt::Registry<EntityID> &registry, EntityID emitterEnt, std::string name, float duration, bool loop);
+	EntityID createTimer(entt::Registry<EntityID> &registry, EntityID emitterEnt, TimerName name, float duration, bool loop);
 // Player
 	EntityID createPlayer(entt::Registry<EntityID> &registry, std::string team, bool ai);
 
@@ -151,7 +162,7 @@ private:
 
 	void loadPlayerColors(std::string filename);
 	tinyxml2::XMLElement *getXmlComponent(std::string name, const char* component);
-	std::string randGroupName(std::string name);
+	std::string randGroupName(entt::Registry<EntityID> &registry, std::string name);
 	void addStaticVerticalSpriteView(std::vector<SpriteView> &states, std::initializer_list<int> frames);
 	void assignSpritesheets(entt::Registry<EntityID> &registry, EntityID entity, std::string name);
 
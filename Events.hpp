@@ -4,27 +4,28 @@
 
 #include "Entity.hpp"
 #include "Options.hpp"
+#include "Replay.hpp"
 
 #include "Stages/GameStage.hpp"
 
 struct AnimationFrameChanged {
 	EntityID entity;
-	std::string state;
+	TileState state;
 	int frame;
 };
 
 struct TimerStarted {
-	std::string name;
+	TimerName name;
 	EntityID entity; // timer entity
 };
 
 struct TimerEnded {
-	std::string name;
+	TimerName name;
 	EntityID entity; // timer entity
 };
 
 struct TimerLooped {
-	std::string name;
+	TimerName name;
 	EntityID entity; // timer entity
 	int l;
 };
@@ -32,9 +33,9 @@ struct TimerLooped {
 
 struct StateChanged {
 	EntityID entity;
-	std::string state;
+	TileState state;
 	unsigned int view;
-	std::string newState;
+	TileState newState;
 };
 
 struct EffectEnded {
@@ -65,6 +66,20 @@ struct EntityDelete {
 	EntityID entity;
 };
 
+// pathfinding obstacle (building or blocking decor) placed on or removed from map
+struct ObstacleAdded {
+	EntityID entity;
+};
+
+struct ObstacleRemoved {
+	EntityID entity;
+};
+
+// walkability changed in map rect
+struct PathfindingChanged {
+	sf::IntRect rect;
+};
+
 struct SoundPlay {
 	std::string name;
 	int priority;
@@ -72,4 +87,11 @@ struct SoundPlay {
 	sf::Vector2i pos;
 };
 
-
+// player order from the interface, queued for the next simulation step
+struct CommandIssued {
+	CommandType type;
+	EntityID player;
+	std::vector<EntityID> entities;
+	sf::Vector2i pos;
+	std::string name;
+};
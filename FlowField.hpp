@@ -1,9 +1,15 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <deque>
+#include <tuple>
 
 #include "Config.hpp"
+#include "Profiler.hpp"
 #include "Map.hpp"
+#include "SectorGraph.hpp"
+#include "Regions.hpp"
 #include "third_party/JPS.h"
 
 #include "Components/Components.hpp"
@@ -68,8 +74,16 @@ class FlowField {
 	std::vector<dir_t> _dir;
 	Grid _grid;
 
+	// build scratch buffers, grid padded with one unwalkable cell on each side so that neighbours never need bound checks
+	unsigned int _pwidth;
+	std::vector<unsigned char> _walkable;
+	std::vector<field_t> _cost;
+	std::vector<unsigned int> _visited;
+	std::vector<unsigned int> _queue;
+
 public:
 	FlowField() {
+		_pwidth = 0;
 	}
 
 	Grid *getGrid() {
@@ -77,16 +91,15 @@ public:
 	}
 
 	void resize() {
-		_fields.clear();
-		_dir.clear();
-		_fields.reserve(_grid.width * _grid.height);
-		while (_fields.size() < _grid.width * _grid.height) {
-			_fields.push_back(std::numeric_limits<field_t>::max());
-		}
-		_dir.reserve(_grid.width * _grid.height);
-		while (_dir.size() < _grid.width * _grid.height) {
-			_dir.push_back(-1);
-		}
+		unsigned int size = _grid.width * _grid.height;
+		unsigned int psize = (_grid.width + 2) * (_grid.height + 2);
+		_pwidth = _grid.width + 2;
+		_fields.resize(size);
+		_dir.resize(size);
+		_walkable.resize(psize);
+		_cost.resize(psize);
+		_visited.resize((psize + 31) / 32);
+		_queue.resize(psize);
 	}
 
 	void setGrid(Grid grid) {
@@ -108,94 +121,90 @@ public:
 		return _grid.pathAvailable(x, y);
 	}
 
-	bool checkIfContains(unsigned int idx, const std::list<unsigned int>& lst) const {
-		std::list<unsigned int>::const_iterator it = lst.begin();
-		while (it != lst.end()) {
-			if (*it == idx) {
-				return true;
+	void resetFields() {
+		this->resize();
+		std::fill(_walkable.begin(), _walkable.end(), 0);
+		std::fill(_cost.begin(), _cost.end(), std::numeric_limits<field_t>::max());
+		std::fill(_visited.begin(), _visited.end(), 0);
+		for (unsigned int y = 0; y < _grid.height; ++y) {
+			unsigned int prow = (y + 1) * _pwidth + 1;
+			for (unsigned int x = 0; x < _grid.width; ++x) {
+				_walkable[prow + x] = this->pathAvailable(x, y);
 			}
-			++it;
 		}
-		return false;
 	}
 
-// get neighbors (N, S, W and E). Will return the indices
-	int getNeighbors(int x, int y, int * ret, bool *moving) {
-		int cnt = 0;
-		if (_grid.bound(x, y - 1) && this->pathAvailable(x, y - 1)) {
-			ret[cnt++] = x + (y - 1) * _grid.width;
-		}
-		if (_grid.bound(x, y + 1) && this->pathAvailable(x, y + 1)) {
-			ret[cnt++] = x + (y + 1) * _grid.width;
-		}
-		if (_grid.bound(x - 1, y) && this->pathAvailable(x - 1, y)) {
-			ret[cnt++] = x - 1 + y * _grid.width;
-		}
-		if (_grid.bound(x + 1, y) && this->pathAvailable(x + 1, y)) {
-			ret[cnt++] = x + 1 + y * _grid.width;
-		}
-		return cnt;
-	}
-
-	int findLowestCost(int x, int y) {
-		int m = std::numeric_limits<field_t>::max();
-		int ret = 14;
-		for (int i = 0; i < 8; ++i) {
-			sf::Vector2i c = sf::Vector2i(x, y) + DIRECTIONS[i];
-			if (this->pathAvailable(c.x, c.y)) {
-				int idx = c.x + c.y * _grid.width;
-				if (_fields[idx] < m) {
-					ret = i;
-					m = _fields[idx];
-				}
-			}
-		}
-		return ret;
+	inline bool visited(unsigned int pidx) const {
+		return (_visited[pidx >> 5] >> (pidx & 31)) & 1;
 	}
 
-	void resetFields() {
-		this->resize();
+	inline void visit(unsigned int pidx) {
+		_visited[pidx >> 5] |= 1u << (pidx & 31);
 	}
 
 	void build(const sf::Vector2i & end) {
-		// simple Dijstra flood fill first
-		unsigned int targetID = end.y * _grid.width + end.x;
-//		std::cout << "BUILD " << _grid.rect.left << "x" << _grid.rect.top << " " << _grid.width << "x" << _grid.height << " " << targetID << std::endl;
+		ProfileZone zone(PROFILE_SITE("flowField", "pathfinding"));
+		Profiler::get().count(PROFILE_COUNTER("flow field builds"));
+		const field_t maxCost = std::numeric_limits<field_t>::max();
 		resetFields();
-		std::list<unsigned int> openList;
-		_fields[targetID] = 0;
-		openList.push_back(targetID);
-		int neighbors[4];
-		bool movNeighbors[4];
-		while (openList.size() > 0)	{
-			unsigned currentID = openList.front();
-			openList.pop_front();
-			unsigned short currentX = currentID % _grid.width;
-			unsigned short currentY = currentID / _grid.width;
-			int neighborCount = getNeighbors(currentX, currentY, neighbors, movNeighbors);
-//			std::cout << "GET neighbors "<<currentID << " "<<currentX<<"x"<<currentY<<" "<<neighborCount<<std::endl;
-			for (int i = 0; i < neighborCount; ++i) {
-				unsigned int endNodeCost = _fields[currentID] + 1;
-				if (endNodeCost < _fields[neighbors[i]]) {
-					if (!checkIfContains(neighbors[i], openList)) {
-						openList.push_back(neighbors[i]);
-					}
-					_fields[neighbors[i]] = endNodeCost;
-				}
-			}
 
+		if (!_grid.localBound(end.x, end.y)) {
+			std::fill(_fields.begin(), _fields.end(), maxCost);
+			for (unsigned int i = 0; i < _dir.size(); ++i)
+				_dir[i] = _walkable[(i / _grid.width + 1) * _pwidth + i % _grid.width + 1] ? 14 : 16;
+			return;
 		}
-		// now calculate the directions
-		for (int x = 0; x < _grid.width; ++x) {
-			for (int y = 0; y < _grid.height; ++y) {
-				if (this->pathAvailable(x, y)) {
-					_dir[x + _grid.width * y] = findLowestCost(x, y);
+
+		// uniform costs, breadth first flood fill gives dijkstra costs
+		const int pw = _pwidth;
+		const int neighbors[4] = { -pw, pw, -1, 1}; // N, S, W, E
+		unsigned int targetID = (end.y + 1) * pw + end.x + 1;
+		unsigned int head = 0;
+		unsigned int tail = 0;
+
+		_cost[targetID] = 0;
+		visit(targetID);
+		_queue[tail++] = targetID;
+		while (head < tail) {
+			unsigned int currentID = _queue[head++];
+			field_t cost = _cost[currentID] + 1;
+			for (int i = 0; i < 4; ++i) {
+				unsigned int n = currentID + neighbors[i];
+				if (_walkable[n] && !visited(n)) {
+					visit(n);
+					_cost[n] = cost;
+					_queue[tail++] = n;
 				}
-				else {
-					_dir[x + _grid.width * y] = 16;
+			}
+		}
+
+		// the target keeps a 0 cost even when not walkable, but cannot be chosen as a direction
+		bool targetWalkable = _walkable[targetID];
+		if (!targetWalkable)
+			_cost[targetID] = maxCost;
+
+		// now calculate the directions, first lowest neighbour in DIRECTIONS order
+		const int offsets[8] = { 1, pw + 1, pw, pw - 1, -1, -pw - 1, -pw, -pw + 1};
+		for (unsigned int y = 0; y < _grid.height; ++y) {
+			unsigned int prow = (y + 1) * pw + 1;
+			unsigned int row = y * _grid.width;
+			for (unsigned int x = 0; x < _grid.width; ++x) {
+				unsigned int pidx = prow + x;
+				int m = maxCost;
+				int ret = 14;
+				for (int i = 0; i < 8; ++i) {
+					int c = _cost[pidx + offsets[i]];
+					bool lower = c < m;
+					m = lower ? c : m;
+					ret = lower ? i : ret;
 				}
+				_dir[row + x] = _walkable[pidx] ? ret : 16;
+				_fields[row + x] = _cost[pidx];
 			}
 		}
+
+		if (!targetWalkable)
+			_fields[end.y * _grid.width + end.x] = 0;
 	}
 
 	int get(int x, int y) const {
@@ -232,12 +241,170 @@ public:
 };
 
 
-#define PER_SECTOR 12
+// group orders with less units than this use per unit paths
+#define GROUP_FLOWFIELD_MIN_UNITS 4
+
+// whole map flow field to a group order target, shared by every unit of the group
+struct GroupFlowField {
+	sf::Vector2i target;
+	// FlowFieldPathFind version the field was built on
+	unsigned long version;
+	bool built;
+	FlowField field;
+
+	GroupFlowField(sf::Vector2i target) {
+		this->target = target;
+		this->version = 0;
+		this->built = false;
+	}
+
+	void build(Map *map, unsigned long version) {
+		this->field.setGrid(map);
+		this->field.build(this->target);
+		this->version = version;
+		this->built = true;
+	}
+};
+
+
+// unused flow fields are kept this number of ticks
+#define FLOWFIELD_CACHE_TTL 16
+
+struct FlowFieldKey {
+	sf::IntRect rect;
+	sf::Vector2i target;
+
+	bool operator<(const FlowFieldKey &other) const {
+		return std::tie(rect.left, rect.top, rect.width, rect.height, target.x, target.y) <
+		       std::tie(other.rect.left, other.rect.top, other.rect.width, other.rect.height, other.target.x, other.target.y);
+	}
+};
+
+struct FlowFieldCacheEntry {
+	std::shared_ptr<FlowField> field;
+	unsigned long lastUsed;
+};
+
+// local flow fields shared between units going through the same sector to the same target
+class FlowFieldCache {
+	std::map<FlowFieldKey, FlowFieldCacheEntry> entries;
+	unsigned long ticks;
+public:
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long invalidations;
+
+	FlowFieldCache() {
+		this->ticks = 0;
+		this->hits = 0;
+		this->misses = 0;
+		this->invalidations = 0;
+	}
+
+	int size() const {
+		return this->entries.size();
+	}
+
+	void clear() {
+		this->entries.clear();
+	}
+
+	// target is local to rect
+	std::shared_ptr<FlowField> get(Map *map, sf::IntRect rect, sf::Vector2i target) {
+		FlowFieldKey key{rect, target};
+		auto it = this->entries.find(key);
+		if (it != this->entries.end()) {
+			this->hits++;
+			it->second.lastUsed = this->ticks;
+			return it->second.field;
+		}
+
+		this->misses++;
+		std::shared_ptr<FlowField> field = std::make_shared<FlowField>();
+		field->setGrid(map, rect);
+		field->build(target);
+		this->entries[key] = FlowFieldCacheEntry{field, this->ticks};
+		return field;
+	}
+
+	// drop flow fields intersecting changed rects, units still using them keep their reference until next update
+	void invalidate(const std::vector<sf::IntRect> &rects) {
+		auto it = this->entries.begin();
+		while (it != this->entries.end()) {
+			bool changed = false;
+			for (sf::IntRect const &rect : rects) {
+				if (it->first.rect.intersects(rect)) {
+					changed = true;
+					break;
+				}
+			}
+			if (changed) {
+				this->invalidations++;
+				it = this->entries.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+
+	// drop flow fields not referenced by any unit for a while
+	void update() {
+		this->ticks++;
+		auto it = this->entries.begin();
+		while (it != this->entries.end()) {
+			if (it->second.field.use_count() == 1 && this->ticks - it->second.lastUsed > FLOWFIELD_CACHE_TTL)
+				it = this->entries.erase(it);
+			else
+				++it;
+		}
+	}
+};
+
+// paths between sectors further than this are searched on the sector graph
+#define SECTOR_GRAPH_MIN_DISTANCE 2
+// free JPS cached nodes above this
+#define JPS_MAX_CACHED_NODES 16384
+// changed rects kept to check results searched on older versions
+#define FLOWFIELD_CHANGES_LOG 256
+
+// search a path on any walkable grid
+// short paths are fully searched with JPS into points, long ones return sector graph waypoints to refine
+template <typename GRID>
+bool searchPath(const GRID &grid, const SectorGraph &sectorGraph, JPS::Searcher<GRID> &searcher, sf::Vector2i start, sf::Vector2i goal,
+                std::list<sf::Vector2i> &points, std::list<sf::Vector2i> &waypoints, unsigned int &steps) {
+	if (sectorGraph.sectorDistance(start, goal) >= SECTOR_GRAPH_MIN_DISTANCE)
+		return sectorGraph.findPath(grid, waypoints, start, goal, steps);
+
+	ProfileZone zone(PROFILE_SITE("jps", "pathfinding"));
+	JPS::PathVector path;
+	bool found = searcher.findPath(path, JPS::Pos(start.x, start.y), JPS::Pos(goal.x, goal.y), 1);
+	steps = searcher.getStepsDone();
+	for (auto &p : path) {
+		points.push_back(sf::Vector2i(int(p.x), int(p.y)));
+	}
+	return found;
+}
 
 class FlowFieldPathFind {
-	JPS::Searcher<Map> *search;
+	JPS::Searcher<WalkabilityBitmap> *search;
 public:
 	Map *map;
+	SectorGraph sectorGraph;
+	RegionLabels regions;
+	FlowFieldCache cache;
+
+	// rects changed since last update
+	std::vector<sf::IntRect> changedRects;
+	// rects changed by recent versions, to check results of searches done on older ones
+	std::deque<std::pair<unsigned long, sf::IntRect>> changesLog;
+	// changes of versions after this one are all in the log
+	unsigned long loggedSince;
+
+	// nodes expanded by searches, for stats
+	unsigned long stepsDone;
+
+	// incremented each time walkability changes
+	unsigned long version;
 
 	~FlowFieldPathFind() {
 		if (search)
@@ -246,15 +413,80 @@ public:
 
 	FlowFieldPathFind() {
 		search = nullptr;
+		stepsDone = 0;
+		version = 0;
+		loggedSince = 0;
 	}
 
 	void init(Map *map) {
-		search = new JPS::Searcher<Map>(*map);
+		search = new JPS::Searcher<WalkabilityBitmap>(map->walkable);
 		this->map = map;
+		this->sectorGraph.build(*map, map->width, map->height);
+		this->regions.build(*map, map->width, map->height);
+	}
+
+	void markChanged(sf::IntRect rect) {
+		this->sectorGraph.markDirty(rect);
+		this->changedRects.push_back(rect);
+	}
+
+	// rebuild changed sectors and drop outdated flow fields
+	void update() {
+		if (this->sectorGraph.isDirty())
+			this->sectorGraph.update(*map);
+		if (this->changedRects.size() > 0) {
+			for (sf::IntRect const &rect : this->changedRects) {
+				this->regions.update(*map, rect);
+			}
+			this->version++;
+			for (sf::IntRect const &rect : this->changedRects) {
+				this->changesLog.push_back(std::make_pair(this->version, rect));
+			}
+			while (this->changesLog.size() > FLOWFIELD_CHANGES_LOG) {
+				this->loggedSince = this->changesLog.front().first;
+				this->changesLog.pop_front();
+			}
+			this->cache.invalidate(this->changedRects);
+			this->changedRects.clear();
+		}
+		this->cache.update();
+	}
+
+	// rects changed after version, false if the log does not go back that far
+	bool changedSince(unsigned long version, std::vector<sf::IntRect> &rects) const {
+		if (version < this->loggedSince)
+			return false;
+		for (auto const &change : this->changesLog) {
+			if (change.first > version)
+				rects.push_back(change.second);
+		}
+		return true;
 	}
 
 	bool find(JPS::PathVector &path, int sx, int sy, int dx, int dy) {
-		return search->findPath(path, JPS::Pos(sx, sy), JPS::Pos(dx, dy), 1);
+		if (search->getNodesExpanded() > JPS_MAX_CACHED_NODES)
+			search->freeMemory();
+		ProfileZone zone(PROFILE_SITE("jps", "pathfinding"));
+		bool found = search->findPath(path, JPS::Pos(sx, sy), JPS::Pos(dx, dy), 1);
+		stepsDone += search->getStepsDone();
+		return found;
+	}
+
+	bool findPath(std::list<sf::Vector2i> &points, std::list<sf::Vector2i> &waypoints, int sx, int sy, int dx, int dy) {
+		if (search->getNodesExpanded() > JPS_MAX_CACHED_NODES)
+			search->freeMemory();
+		unsigned int steps = 0;
+		bool found = searchPath(map->walkable, this->sectorGraph, *search, sf::Vector2i(sx, sy), sf::Vector2i(dx, dy), points, waypoints, steps);
+		stepsDone += steps;
+		return found;
+	}
+
+	// portals waypoints, each leg must be refined with find()
+	bool findWaypoints(std::list<sf::Vector2i> &waypoints, int sx, int sy, int dx, int dy) {
+		unsigned int steps = 0;
+		bool found = this->sectorGraph.findPath(map->walkable, waypoints, sf::Vector2i(sx, sy), sf::Vector2i(dx, dy), steps);
+		stepsDone += steps;
+		return found;
 	}
 };
 
@@ -262,10 +494,14 @@ class FlowFieldPath {
 	FlowFieldPathFind *pathFind;
 	std::list<sf::Vector2i> traversed;
 	std::list<sf::Vector2i> pathPoints;
+	// sector graph waypoints not yet refined
+	std::list<sf::Vector2i> waypoints;
 	sf::Vector2i cur;
 	sf::Vector2i dest;
 	bool found;
-	FlowField currentFlowField;
+	std::shared_ptr<FlowField> currentFlowField;
+	// path point after the local target, out of the sector when the target is on its border
+	sf::Vector2i beyond;
 
 	int lastCalcDest;
 public:
@@ -278,15 +514,16 @@ public:
 	}
 
 	FlowField *getCurrentFlowField() {
-		return &this->currentFlowField;
+		return this->currentFlowField.get();
 	}
 
 	sf::Vector2i offset(sf::Vector2i p) const {
 		return this->offset(p.x, p.y);
 	}
 
+	// local flow fields cover the sector of the unit, so units crossing a sector share them
 	sf::Vector2i offset(int x, int y) const {
-		return sf::Vector2i(x - PER_SECTOR / 2, y - PER_SECTOR / 2);
+		return sf::Vector2i(x / PER_SECTOR * PER_SECTOR, y / PER_SECTOR * PER_SECTOR);
 	}
 
 	sf::Vector2f seek(sf::Vector2i cpos, sf::Vector2i dpos) {
@@ -309,15 +546,18 @@ public:
 	}
 
 
+	// furthest path point in the sector, beyond is set to the path point following it
 	sf::Vector2i bestFollowingPathPoint(sf::Vector2i cpos) {
 		sf::Vector2i offset = this->offset(cpos);
 		sf::Vector2i point = cpos;
 		int bcnt = 0;
+		int ccnt = -1;
 		int pcnt = 0;
 		for (sf::Vector2i np : this->pathPoints) {
-			if (np.x >= offset.x && np.x < offset.x + PER_SECTOR &&
-			        np.y >= offset.y && np.y < offset.y + PER_SECTOR &&
-			        np != cpos) {// && this->pathFind->map->pathAvailable(np.x, np.y)) {
+			if (np == cpos) {
+				ccnt = pcnt;
+			} else if (np.x >= offset.x && np.x < offset.x + PER_SECTOR &&
+			           np.y >= offset.y && np.y < offset.y + PER_SECTOR) {// && this->pathFind->map->pathAvailable(np.x, np.y)) {
 				if (pcnt > bcnt) {
 					bcnt = pcnt;
 					point = np;
@@ -326,6 +566,21 @@ public:
 			pcnt++;
 		}
 
+		// points of the sector left are behind
+		if (ccnt > bcnt) {
+			bcnt = ccnt;
+			point = cpos;
+		}
+		this->beyond = point;
+		pcnt = 0;
+		for (sf::Vector2i np : this->pathPoints) {
+			if (pcnt == bcnt + 1) {
+				this->beyond = np;
+				break;
+			}
+			pcnt++;
+		}
+
 		sf::Vector2i bPoint = point;
 
 		std::vector<sf::Vector2i> linePoints;
@@ -405,6 +660,7 @@ public:
 
 		sf::Vector2i npos(cx, cy);
 
+		this->refinePath(cpos);
 
 		sf::Vector2i offset = this->offset(cpos);
 		sf::Vector2i cgpos = cpos - offset;
@@ -415,8 +671,6 @@ public:
 		sf::IntRect ffRect = sf::IntRect(offset.x, offset.y, PER_SECTOR, PER_SECTOR);
 //			sf::IntRect ffRect = rect(cpos, ndpos);
 
-		this->currentFlowField.setGrid(pathFind->map, ffRect);
-
 
 		if (ffRect.contains(dest)) {
 			ndpos = dest;
@@ -443,11 +697,20 @@ public:
 		}
 
 		ffDest = ndpos;
+		if (ndpos == cpos && cpos != dest) {
+			// on the sector border, step to the path in the next sector
+			sf::Vector2i delta = this->beyond - cpos;
+			sf::Vector2i step((delta.x > 0) - (delta.x < 0), (delta.y > 0) - (delta.y < 0));
+			this->currentFlowField.reset();
+			if (this->pathFind->map->pathAvailable(cpos.x + step.x, cpos.y + step.y))
+				return cpos + step;
+			return cpos;
+		}
 		ndpos -= offset;
-		this->currentFlowField.build(ndpos);
+		this->currentFlowField = pathFind->cache.get(pathFind->map, ffRect, ndpos);
 
-		if (this->currentFlowField.found(cgpos)) {
-			npos = this->currentFlowField.next(cgpos);
+		if (this->currentFlowField->found(cgpos)) {
+			npos = this->currentFlowField->next(cgpos);
 			npos += offset;
 		} else {
 			npos = cpos;
@@ -467,24 +730,15 @@ public:
 
 	bool start(int sx, int sy, int dx, int dy) {
 		sf::Vector2i newDest = sf::Vector2i(dx, dy);
-		if (newDest != dest) {
-			sf::Vector2i oldDest = dest;
-
-			dest = newDest;
-			cur = sf::Vector2i(sx, sy);
-			traversed.clear();
-
-			this->lastCalcDest = 4;
-
-			this->ffDest = dest;
-
-			JPS::PathVector path;
-			this->found = pathFind->find(path, sx, sy, dx, dy);
-
-			if (this->found) {
-				// find border pos
-				this->initPath(path);
-			}
+		if (!pathFind->regions.mayReach(sf::Vector2i(sx, sy), newDest)) {
+			// no search can succeed
+			std::list<sf::Vector2i> none;
+			this->setPath(sx, sy, dx, dy, false, none, none);
+		} else if (newDest != dest) {
+			std::list<sf::Vector2i> points;
+			std::list<sf::Vector2i> newWaypoints;
+			bool newFound = pathFind->findPath(points, newWaypoints, sx, sy, dx, dy);
+			this->setPath(sx, sy, dx, dy, newFound, points, newWaypoints);
 		} else {
 			// check if destination position is still available
 			if (this->found)
@@ -493,6 +747,28 @@ public:
 		return this->found;
 	}
 
+	// set a path searched by start() or by a pathfinding worker
+	void setPath(int sx, int sy, int dx, int dy, bool found, const std::list<sf::Vector2i> &points, const std::list<sf::Vector2i> &waypoints) {
+		dest = sf::Vector2i(dx, dy);
+		cur = sf::Vector2i(sx, sy);
+		traversed.clear();
+
+		this->lastCalcDest = 4;
+
+		this->ffDest = dest;
+
+		this->found = found;
+		this->pathPoints = points;
+		this->waypoints = waypoints;
+
+#ifdef FLOWFIELDS_DEBUG
+		std::cout << "FlowFieldPath path " << found << " (" << points.size() << " points, " << waypoints.size() << " waypoints)" << std::endl;
+#endif
+
+		if (this->found)
+			this->refinePath(cur);
+	}
+
 	void initPath(JPS::PathVector &path) {
 		pathPoints.clear();
 		for (auto &p : path) {
@@ -500,13 +776,54 @@ public:
 		}
 	}
 
+	// refine sector graph legs with JPS until the path goes out of the current flow field sector
+	void refinePath(sf::Vector2i cpos) {
+		sf::Vector2i offset = this->offset(cpos);
+		sf::IntRect ffRect = sf::IntRect(offset.x, offset.y, PER_SECTOR, PER_SECTOR);
+
+		bool researched = false;
+		while (waypoints.size() > 0) {
+			sf::Vector2i from = pathPoints.size() > 0 ? pathPoints.back() : cpos;
+			if (!ffRect.contains(from))
+				break;
+
+			sf::Vector2i to = waypoints.front();
+			waypoints.pop_front();
+
+			JPS::PathVector path;
+			if (pathFind->find(path, from.x, from.y, to.x, to.y)) {
+				for (auto &p : path) {
+					this->pathPoints.push_back(sf::Vector2i(int(p.x), int(p.y)));
+				}
+			} else {
+				// map changed since the sector graph search, search again from here
+#ifdef FLOWFIELDS_DEBUG
+				std::cout << "FlowFieldPath cannot refine " << from << " -> " << to << std::endl;
+#endif
+				waypoints.clear();
+				if (researched || !pathFind->findWaypoints(waypoints, from.x, from.y, dest.x, dest.y))
+					break;
+				researched = true;
+			}
+		}
+	}
+
 	bool pathFound() {
 		return this->found;
 	}
 
+	sf::Vector2i getDest() const {
+		return this->dest;
+	}
+
+	// forget the current path, next update searches again
+	void reset() {
+		this->dest = sf::Vector2i(-1, -1);
+		this->found = false;
+	}
+
 	void setPathFind(FlowFieldPathFind *p) {
 		pathFind = p;
-		this->currentFlowField.setGrid(pathFind->map, sf::IntRect(0, 0, 0, 0));
 	}
 
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+
+#include "Entity.hpp"
+#include "Map.hpp"
+
+// cells seen by every mapped object, counted in the fog of its player
+// an object reveals its cells again only when it changes of cell or view, objects not kept during an update are concealed
+// fogOf(player) gives the Fog of a player entity, records keep player entities as Player components may move
+class FogSight {
+	struct Record {
+		EntityID entity;
+		EntityID player;
+		sf::Vector2i pos;
+		unsigned int view;
+		unsigned long update;
+		bool tracked;
+		std::vector<sf::Vector2i> cells;
+	};
+
+	// indexed by entity index
+	std::vector<Record> records;
+	// entity indices of tracked records
+	std::vector<unsigned int> tracked;
+	unsigned long updates;
+
+public:
+	FogSight() {
+		this->updates = 0;
+	}
+
+	void clear() {
+		this->records.clear();
+		this->tracked.clear();
+		this->updates = 0;
+	}
+
+	void begin() {
+		this->updates++;
+	}
+
+	// true if the object still sees the same cells, they are kept for this update
+	bool keep(EntityID entity, EntityID player, sf::Vector2i pos, unsigned int view) {
+		Record &record = this->record(entity);
+		if (record.tracked && record.entity == entity && record.player == player && record.pos == pos && record.view == view) {
+			record.update = this->updates;
+			return true;
+		}
+		return false;
+	}
+
+	// new cells are revealed before the previous ones are concealed, cells seen by both do not flip
+	template <typename FogOf>
+	void see(EntityID entity, EntityID player, sf::Vector2i pos, unsigned int view, const std::vector<sf::Vector2i> &cells, FogOf fogOf) {
+		Record &record = this->record(entity);
+		Fog &fog = fogOf(player);
+		for (sf::Vector2i const &p : cells) {
+			fog.reveal(p.x, p.y);
+		}
+
+		if (record.tracked)
+			this->conceal(record, fogOf);
+		else
+			this->tracked.push_back(entity & entt::entt_traits<EntityID>::entity_mask);
+
+		record.entity = entity;
+		record.player = player;
+		record.pos = pos;
+		record.view = view;
+		record.update = this->updates;
+		record.tracked = true;
+		record.cells = cells;
+	}
+
+	// conceal the cells of objects neither kept nor seen since begin, destroyed or unmapped
+	template <typename FogOf>
+	void end(FogOf fogOf) {
+		for (size_t i = 0; i < this->tracked.size();) {
+			Record &record = this->records[this->tracked[i]];
+			if (record.update != this->updates) {
+				this->conceal(record, fogOf);
+				record.tracked = false;
+				record.cells.clear();
+				this->tracked[i] = this->tracked.back();
+				this->tracked.pop_back();
+			} else {
+				++i;
+			}
+		}
+	}
+
+	size_t size() const {
+		return this->tracked.size();
+	}
+
+private:
+	Record &record(EntityID entity) {
+		unsigned int idx = entity & entt::entt_traits<EntityID>::entity_mask;
+		if (idx >= this->records.size())
+			this->records.resize(idx + 1, Record{0, 0, sf::Vector2i(0, 0), 0, 0, false, std::vector<sf::Vector2i>()});
+		return this->records[idx];
+	}
+
+	template <typename FogOf>
+	void conceal(Record &record, FogOf fogOf) {
+		Fog &fog = fogOf(record.player);
+		for (sf::Vector2i const &p : record.cells) {
+			fog.conceal(p.x, p.y);
+		}
+	}
+};
@@ -49,6 +49,9 @@ public:
 
 	GameSettings settings;
 
+	// replay file written by each new game, none if empty
+	std::string replayRecord;
+
 	void registerStage(std::string name, Stage *stage) {
 		this->registeredStages[name] = stage;
 	}
@@ -200,6 +203,7 @@ public:
 		this->window.setFramerateLimit(30);
 //		this->window.setVerticalSyncEnabled(true);
 
+		// particles only, games are seeded with their own MatchRandom
 		srand (time(NULL));
 
 		ImGui::SFML::Init(window, false);
@@ -1,14 +1,27 @@
 #include "GameEngine.hpp"
 
-GameEngine::GameEngine(Game *game, unsigned int mapWidth, unsigned int mapHeight, std::string playerTeam) {
+GameEngine::GameEngine(Game *game, MatchSettings settings) {
 	this->game = game;
+	this->headless = false;
 	this->init();
-	this->generate(mapWidth, mapHeight, playerTeam);
+	this->generate(settings);
+	this->zoomLevel = 1.0;
+
+	if (this->game->replayRecord.size() > 0)
+		this->commands.startRecord(this->game->replayRecord, settings);
+}
+
+GameEngine::GameEngine(GameVault *vault, MatchSettings settings) {
+	this->game = nullptr;
+	this->headless = true;
+	this->setSize(0, 0);
+	this->setVaults(vault);
+	this->init();
+	this->generate(settings);
 	this->zoomLevel = 1.0;
 }
 
 GameEngine::~GameEngine() {
-	this->setGameSpeed(1.0);
 	// FIXME: registry must actually resides in GameEngine instead of game
 	this->vault->dispatcher.update(); // to achieve a coherent state ?
 	this->vault->registry.reset();
@@ -21,10 +34,23 @@ void GameEngine::receive(const GameStageChange &event) {
 }
 
 void GameEngine::init() {
-	this->timePerTick = 0.1;
-	this->currentTime = 0.0;
+	this->accumulator = 0.0;
 	this->ticks = 0;
+	this->turbo = false;
 	this->markUpdateLayer = false;
+	this->winner = 0;
+	this->nextStage = 0;
+	// zones of this match only
+	Profiler::get().reset();
+
+	if (this->headless) {
+		this->vault->factory.setHeadless(true);
+		this->vault->factory.loadInitial();
+		this->vault->factory.load();
+		this->gameSpeed = 1;
+		this->vault->dispatcher.connect<GameStageChange>(this);
+		return;
+	}
 
 	this->setSize(this->game->width, this->game->height);
 	this->setVaults(&(this->game->vault));
@@ -68,11 +94,6 @@ void GameEngine::init() {
 	this->gameSpeed = 1;
 
 	this->vault->dispatcher.connect<GameStageChange>(this);
-/*
-	music.openFromFile("medias/musics/ludwig_sample1.ogg");
-	music.setLoop(true);
-	music.play();
-*/
 }
 
 void GameEngine::reset() {
@@ -103,6 +124,11 @@ void GameEngine::setVaults(GameVault *vault) {
 	this->vault->registry.attach<Map>(gameEntity);
 
 	this->map = &this->vault->registry.get<Map>();
+
+	this->vault->registry.attach<PathfindingStats>(gameEntity);
+	this->vault->registry.attach<SimulationClock>(gameEntity);
+	this->vault->registry.attach<MatchRandom>(gameEntity);
+	this->vault->registry.attach<GameObjectSerials>(gameEntity);
 	//new Map();
 
 	// set shared systems
@@ -121,6 +147,7 @@ void GameEngine::setVaults(GameVault *vault) {
 	sound.setShared(vault, this->map, this->width, this->height);
 	fx.setShared(vault, this->map, this->width, this->height);
 	deletion.setShared(vault, this->map, this->width, this->height);
+	commands.setShared(vault, this->map, this->width, this->height);
 	ai.setShared(vault, this->map, this->width, this->height);
 	interface.setShared(vault, this->map, this->width, this->height);
 }
@@ -146,25 +173,38 @@ void GameEngine::setPlayerCursor() {
 	}
 }
 
-void GameEngine::generate(unsigned int mapWidth, unsigned int mapHeight, std::string playerTeam) {
-	EntityID playerEnt = gameGenerator.generate(mapWidth, mapHeight, playerTeam);
+void GameEngine::generate(MatchSettings settings) {
+	this->settings = settings;
+	this->vault->registry.get<MatchRandom>().seed(settings.seed);
+
+	Scenario scenario;
+	bool withScenario = settings.scenario.size() > 0 && scenario.load(settings.scenario);
+
+	EntityID playerEnt = gameGenerator.generate(settings.mapWidth, settings.mapHeight, settings.playerTeam, settings.aiTeams, withScenario ? &scenario : nullptr);
 
 	this->vault->registry.attach<GameController>(gameEntity);
 	GameController &controller = this->vault->registry.get<GameController>();
 	controller.currentPlayer = playerEnt;
 
 	mapLayers.init();
-	drawMap.init();
+	commands.init();
 	ai.init();
-	interface.init();
 	deletion.init();
-	minimap.init();
 	victory.init();
 	pathfinding.init();
+	steering.init();
 	combat.init();
 	tileAnim.init();
-	fx.init();
-	sound.init();
+	gameGenerator.orderScenarioUnits();
+
+	// render and audio only
+	if (!this->headless) {
+		drawMap.init();
+		interface.init();
+		minimap.init();
+		fx.init();
+		sound.init();
+	}
 
 	Player &player = this->vault->registry.get<Player>(controller.currentPlayer);
 	if (player.team != "neutral") {
@@ -196,15 +236,24 @@ sf::IntRect GameEngine::viewClip() {
 }
 
 void GameEngine::draw(float dt) {
+	ProfileZone frameZone(PROFILE_SITE("draw", "frame"));
 	GameController &controller = this->vault->registry.get<GameController>();
 
 	this->game->window.setView(this->gameView);
 	sf::IntRect clip = this->viewClip();
 
-	drawMap.draw(this->game->window, clip, dt);
-	fx.draw(this->game->window, clip, dt);
-
-	drawMap.drawFogTileMap(this->game->window, dt);
+	{
+		ProfileZone zone(PROFILE_SITE("draw:map", "draw"));
+		drawMap.draw(this->game->window, clip, dt);
+	}
+	{
+		ProfileZone zone(PROFILE_SITE("draw:fx", "draw"));
+		fx.draw(this->game->window, clip, dt);
+	}
+	{
+		ProfileZone zone(PROFILE_SITE("draw:fog", "draw"));
+		drawMap.drawFogTileMap(this->game->window, dt);
+	}
 
 	// draw selected
 	for (EntityID selectedObj : controller.selectedObjs) {
@@ -256,19 +305,25 @@ void GameEngine::draw(float dt) {
 
 	this->game->window.setView(this->guiView);
 
-	if (controller.showDebugWindow) {
-		interface.debugGui(this->game->window, this->gameView, &gameSpeed, dt);
-	}
+	{
+		ProfileZone zone(PROFILE_SITE("draw:gui", "draw"));
+		if (controller.showDebugWindow) {
+			interface.debugGui(this->game->window, this->gameView, &gameSpeed, &turbo, dt);
+		}
 
-	this->setGameSpeed(gameSpeed);
+		this->setGameSpeed(gameSpeed);
 
-	this->guiPushStyles();
-	interface.draw(this->game->window, clip, dt);
-	this->guiPopStyles();
-	ImGui::SFML::Render(this->game->window);
+		this->guiPushStyles();
+		interface.draw(this->game->window, clip, dt);
+		this->guiPopStyles();
+		ImGui::SFML::Render(this->game->window);
+	}
 
-	minimap.draw(this->game->window, dt);
-	minimap.drawClip(this->game->window, this->gameView, clip, dt);
+	{
+		ProfileZone zone(PROFILE_SITE("draw:minimap", "draw"));
+		minimap.draw(this->game->window, dt);
+		minimap.drawClip(this->game->window, this->gameView, clip, dt);
+	}
 
 	this->updateFading();
 
@@ -285,17 +340,13 @@ void GameEngine::draw(float dt) {
 	sf::Listener::setPosition(viewPos.x / 32.0, 0.f, viewPos.y / 32.0);
 }
 
-void GameEngine::setGameSpeed(float factor) {
-	if (factor == 0.0) {
-		this->game->window.setFramerateLimit(30);
-		this->timePerTick = FLT_MAX;
-	} else {
-		this->game->window.setFramerateLimit(30 * factor);
-		this->timePerTick = 0.1 / factor;
-	}
+void GameEngine::setGameSpeed(int speed) {
+	this->gameSpeed = speed;
+	this->sound.speed = std::max(1, speed);
 }
 
 void GameEngine::updatePlayers(float dt) {
+	ProfileZone zone(PROFILE_SITE("players", "system"));
 	auto playerView = this->vault->registry.view<Player>();
 
 	for (EntityID entity : playerView) {
@@ -338,6 +389,12 @@ void GameEngine::updateHundred(float dt) {
 #ifdef GAME_ENGINE_DEBUG
 			std::cout << "Player: " << entity << " WINS !" << std::endl;
 #endif
+			this->winner = entity;
+			if (this->headless) {
+				nextStage = NextStageStr("game_over");
+				continue;
+			}
+
 			GameOver *go = (GameOver *)this->game->getStage("game_over");
 
 			if (entity == controller.currentPlayer) {
@@ -355,77 +412,129 @@ void GameEngine::updateHundred(float dt) {
 }
 
 void GameEngine::updateDecade(float dt) {
-	victory.update(dt);
-	minimap.update(dt);
-	combat.updateFront(dt);
+	this->updateSystem(PROFILE_SITE("victory", "system"), victory, dt);
+	if (!this->headless)
+		this->updateSystem(PROFILE_SITE("minimap", "system"), minimap, dt);
+
+	ProfileZone zone(PROFILE_SITE("front", "system"));
+	this->combat.updateFront(dt);
+}
+
+void GameEngine::updateSystem(const ProfileZoneSite &site, GameSystem &system, float dt) {
+	ProfileZone zone(site);
+	system.update(dt);
 }
 
+// real time updates, once per frame
 void GameEngine::updateEveryFrame(float dt)
 {
-	if (this->markUpdateLayer) {
-		this->mapLayers.updateObjsLayer(0);
-		this->markUpdateLayer = false;
-	}
-
-	this->time.update(dt);
-	this->tileAnim.update(dt);
-	this->steering.update(dt);
-
-	this->sound.update(dt);
+	this->updateSystem(PROFILE_SITE("sound", "system"), this->sound, dt);
 
+	ProfileZone zone(PROFILE_SITE("input", "frame"));
 	this->setPlayerCursor();
 
 	this->updateMoveView(dt);
-
-	this->fx.update(dt);
 }
 
-void GameEngine::update(float dt) {
-	GameController &controller = this->vault->registry.get<GameController>();
-	float updateDt = dt;
+// one simulation step, every SIM_TICK_STEPS steps is also a game tick
+void GameEngine::step() {
+	ProfileZone zone(PROFILE_SITE("step", "engine"));
+	SimulationClock &clock = this->vault->registry.get<SimulationClock>();
+	clock.steps++;
 
-	if (this->timePerTick == FLT_MAX) return;
+	this->updateSystem(PROFILE_SITE("commands", "system"), this->commands, SIM_STEP);
 
-	this->updateEveryFrame(dt);
+	if (this->markUpdateLayer || this->commands.markUpdateLayer) {
+		this->mapLayers.updateObjsLayer(0);
+		this->markUpdateLayer = false;
+		this->commands.markUpdateLayer = false;
+	}
 
-	this->currentTime += dt;
+	this->updateSystem(PROFILE_SITE("time", "system"), this->time, SIM_STEP);
+	this->updateSystem(PROFILE_SITE("tileAnim", "system"), this->tileAnim, SIM_STEP);
+	this->updateSystem(PROFILE_SITE("steering", "system"), this->steering, SIM_STEP);
 
-	if (this->currentTime < this->timePerTick) return;
+	if (!this->headless)
+		this->updateSystem(PROFILE_SITE("fx", "system"), this->fx, SIM_STEP);
 
-	this->ticks++;
+	if (clock.steps % SIM_TICK_STEPS == 0)
+		this->updateTick(SIM_STEP * SIM_TICK_STEPS);
+
+	// zones of the step buffered by every thread
+	Profiler::get().flush();
+}
 
-	updateDt = this->currentTime;
-	this->currentTime = 0.0;
+void GameEngine::updateTick(float dt) {
+	ProfileZone zone(PROFILE_SITE("tick", "engine"));
+	this->ticks++;
 
 	if (this->ticks % 100 == 0) {
-		this->updateHundred(updateDt * 100);
+		this->updateHundred(dt * 100);
 	}
 
 	if (this->ticks % 10 == 0) {
-		this->updateDecade(updateDt * 10);
+		this->updateDecade(dt * 10);
 	}
 
-	this->pathfinding.update(dt);
+	this->updateSystem(PROFILE_SITE("pathfinding", "system"), this->pathfinding, dt);
 
-	this->updatePlayers(updateDt);
+	this->updatePlayers(dt);
 
-	this->construction.update(updateDt);
+	this->updateSystem(PROFILE_SITE("construction", "system"), this->construction, dt);
 
-	this->combat.update(updateDt);
+	this->updateSystem(PROFILE_SITE("combat", "system"), this->combat, dt);
 
-	this->resources.update(updateDt);
+	this->updateSystem(PROFILE_SITE("resources", "system"), this->resources, dt);
 
-	this->deletion.update(updateDt);
-	this->mapLayers.update(updateDt);
+	this->updateSystem(PROFILE_SITE("deletion", "system"), this->deletion, dt);
+	this->updateSystem(PROFILE_SITE("mapLayers", "system"), this->mapLayers, dt);
 
-	this->drawMap.update(updateDt);
+	if (!this->headless)
+		this->updateSystem(PROFILE_SITE("drawMap", "system"), this->drawMap, dt);
 	this->map->markUpdateClear();
 
-	this->mapLayers.updateFog(dt);
+	{
+		ProfileZone zone(PROFILE_SITE("fog", "system"));
+		this->mapLayers.updateFog(dt);
+	}
 
-	ai.update(updateDt);
+	this->updateSystem(PROFILE_SITE("ai", "system"), ai, dt);
 
-	interface.update(updateDt);
+	if (!this->headless)
+		this->updateSystem(PROFILE_SITE("interface", "system"), interface, dt);
+}
+
+// steps at a fixed rate, gameSpeed steps per step time, drawing interpolates between the last two steps
+void GameEngine::update(float dt) {
+	ProfileZone zone(PROFILE_SITE("frame", "frame"));
+	SimulationClock &clock = this->vault->registry.get<SimulationClock>();
+
+	this->updateEveryFrame(dt);
+
+	if (this->gameSpeed == 0)
+		return;
+
+	if (this->turbo) {
+		sf::Clock frameClock;
+		do {
+			this->step();
+		} while (!this->nextStage && frameClock.getElapsedTime().asSeconds() < SIM_TURBO_FRAME_TIME);
+		this->accumulator = 0.0;
+		clock.alpha = 1.0f;
+		return;
+	}
+
+	this->accumulator += dt * this->gameSpeed;
+	int steps = 0;
+	while (this->accumulator >= SIM_STEP && steps < SIM_MAX_FRAME_STEPS) {
+		this->step();
+		this->accumulator -= SIM_STEP;
+		steps++;
+	}
+	if (steps == SIM_MAX_FRAME_STEPS)
+		this->accumulator = 0.0;
+
+	clock.alpha = this->accumulator / SIM_STEP;
 }
 
 void GameEngine::updateMoveView(float dt) {
@@ -490,10 +599,10 @@ void GameEngine::handleEvent(sf::Event & event) {
 				// pause/unpause
 				if (this->gameSpeed == 0) {
 					this->vault->dispatcher.trigger<SoundPlay>("pause_off", 5, true, sf::Vector2i{0, 0});
-					this->gameSpeed = 1;
+					this->setGameSpeed(1);
 				} else {
 					this->vault->dispatcher.trigger<SoundPlay>("pause_on", 5, true, sf::Vector2i{0, 0});
-					this->gameSpeed = 0;
+					this->setGameSpeed(0);
 				}
 			}
 			if (event.key.code == sf::Keyboard::Left)
@@ -587,19 +696,16 @@ void GameEngine::handleEvent(sf::Event & event) {
 					if (controller.action == Action::Build)
 					{
 						if (this->canBuild(controller.currentPlayer, controller.currentBuild).size() == 0) {
-							if (!this->vault->factory.placeBuilding(this->vault->registry, controller.currentBuild)) {
-								Player &player = this->vault->registry.get<Player>(controller.currentPlayer);
-								player.rootConstruction = 0;
-							}
-
+							Tile &tile = this->vault->registry.get<Tile>(controller.currentBuild);
+							this->issueCommand(CommandType::Place, controller.currentPlayer, {controller.currentBuild}, tile.pos, "");
+							// placed at the next step
 							controller.action = Action::None;
-							controller.currentBuild = 0;
 						}
 					} else if (controller.action == Action::Attack) {
-						this->groupAttackOrBomb(controller.currentPlayer, controller.selectedObjs, sf::Vector2i(gameMapPos));
+						this->issueCommand(CommandType::Attack, controller.currentPlayer, controller.selectedObjs, sf::Vector2i(gameMapPos), "");
 						controller.action = Action::None;
 					} else if (controller.action == Action::Move) {
-						this->groupGoTo(controller.selectedObjs, sf::Vector2i(gameMapPos), GroupFormation::Square, North, true);
+						this->issueCommand(CommandType::Move, controller.currentPlayer, controller.selectedObjs, sf::Vector2i(gameMapPos), "");
 						controller.action = Action::None;
 					} else {
 						controller.action = Action::Select;
@@ -627,17 +733,15 @@ void GameEngine::handleEvent(sf::Event & event) {
 			if (event.mouseButton.button == sf::Mouse::Right) {
 				if (controller.action == Action::Build)
 				{
-					this->vault->registry.remove<Tile>(controller.currentBuild);
-					controller.currentBuild = 0;
+					this->issueCommand(CommandType::CancelPreview, controller.currentPlayer, {controller.currentBuild}, sf::Vector2i(0, 0), "");
 					controller.action = Action::None;
-					this->markUpdateLayer = true;
 				} else {
 					// right click on minimap
 					if (this->minimap.rect.contains(sf::Vector2f(mousePos))) {
 						sf::Vector2f mPos((float)(mousePos.x - this->minimap.rect.left) / (this->minimap.size / this->map->width), (float)(mousePos.y - this->minimap.rect.top) / (this->minimap.size / this->map->width));
-						this->groupAttackOrMove(controller.currentPlayer, controller.selectedObjs, sf::Vector2i(mPos));
+						this->issueCommand(CommandType::AttackOrMove, controller.currentPlayer, controller.selectedObjs, sf::Vector2i(mPos), "");
 					} else {
-						this->groupAttackOrMove(controller.currentPlayer, controller.selectedObjs, sf::Vector2i(gameMapPos));
+						this->issueCommand(CommandType::AttackOrMove, controller.currentPlayer, controller.selectedObjs, sf::Vector2i(gameMapPos), "");
 					}
 				}
 
@@ -26,20 +26,38 @@
 #include "Systems/FxSystem.hpp"
 #include "Systems/InterfaceSystem.hpp"
 #include "Systems/DeletionSystem.hpp"
+#include "Systems/CommandSystem.hpp"
 
 #include "AI.hpp"
 
+// simulation step in seconds, whatever the frame rate
+#define SIM_STEP (1.0f / 30.0f)
+// steps per game tick
+#define SIM_TICK_STEPS 3
+// steps run for a frame at most, the game slows down past it instead of catching up
+#define SIM_MAX_FRAME_STEPS 64
+// time spent stepping per frame in turbo mode
+#define SIM_TURBO_FRAME_TIME 0.03f
+
 
 class GameEngine : public GameSystem, public GameStage {
 public:
 	EntityID emptyEntity;
 	EntityID gameEntity;
 
-	float timePerTick;
-	float currentTime;
+	// game time not stepped yet
+	float accumulator;
 	unsigned long ticks;
 	bool markUpdateLayer;
 	int gameSpeed;
+	// as many steps as the frame time allows, instead of gameSpeed steps per step time
+	bool turbo;
+	// no window, textures, shaders, gui nor audio, only the simulation
+	bool headless;
+	// player who met victory conditions
+	EntityID winner;
+
+	MatchSettings settings;
 
 	GameGeneratorSystem gameGenerator;
 	ResourcesSystem resources;
@@ -56,6 +74,7 @@ public:
 	SoundSystem sound;
 	FxSystem fx;
 	DeletionSystem deletion;
+	CommandSystem commands;
 	AI ai;
 
 	InterfaceSystem interface;
@@ -65,9 +84,9 @@ public:
 
 	float zoomLevel;
 
-	sf::Music music;
-
-	GameEngine(Game *game, unsigned int mapWidth, unsigned int mapHeight, std::string playerTeam);
+	GameEngine(Game *game, MatchSettings settings);
+	// headless
+	GameEngine(GameVault *vault, MatchSettings settings);
 
 	~GameEngine();
 
@@ -83,18 +102,23 @@ public:
 
 	void setVaults(GameVault *vault);
 
-	void generate(unsigned int mapWidth, unsigned int mapHeight, std::string playerTeam);
+	void generate(MatchSettings settings);
+
+	// timed in a profiler zone of the system category
+	void updateSystem(const ProfileZoneSite &site, GameSystem &system, float dt);
 
 	void updatePlayers(float dt);
 	void updateHundred(float dt);
 	void updateDecade(float dt);
+	void updateTick(float dt);
 	void updateEveryFrame(float dt);
+	void step();
 
 	sf::IntRect viewClip();
 
 	void draw(float dt);
 
-	void setGameSpeed(float factor) ;
+	void setGameSpeed(int speed);
 
 	void update(float dt);
 	void updateMoveView(float dt);
@@ -8,4 +8,8 @@ struct GameVault {
 	entt::Registry<EntityID> registry;
 	EntityFactory factory;
 	entt::UnmanagedDispatcher dispatcher;
+
+	GameVault() {
+		this->factory.setDispatcher(&this->dispatcher);
+	}
 };
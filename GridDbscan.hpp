@@ -0,0 +1,511 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "third_party/dbscan/dbscan.h"
+
+// dbscan() with neighbourhood queries on a uniform grid of eps sized cells
+// labels are the same than third_party/dbscan: clusters from 1, -1 for noise
+// keep an instance to reuse its buffers and the clusters of the previous pass:
+// only points near cells whose points changed and the clusters they touch are expanded again
+class GridDbscan {
+	double eps;
+	int min;
+	// first cell, cells are eps multiples so a point stays in the same cell between passes
+	int originX;
+	int originY;
+	int width; // cells
+	int height;
+
+	// points of cell i are cellPoints[cellStart[i]] to cellPoints[cellStart[i + 1]]
+	std::vector<int> cellStart;
+	std::vector<int> cellPoints;
+	std::vector<int> pointCells;
+	// cells with points, the grid may be mostly empty
+	std::vector<int> occupied;
+
+	std::vector<int> neighbors;
+	// 1 for a core, 2 for a border point of a single cluster, -1 for noise, 0 if not known
+	std::vector<char> cores;
+	std::vector<int> seeds;
+	// union-find of core points, a cluster is a connected set of cores
+	std::vector<int> parents;
+	// cells next to a changed cell, their points are queried again
+	std::vector<char> dirty;
+	// cells next to no dirty cell, their points have the same neighbours with the same cores
+	std::vector<char> stable;
+	// cluster of each root point, first core of each cluster
+	std::vector<int> numbers;
+	std::vector<int> starts;
+
+	// points of the previous pass in cell order
+	struct Pass {
+		double eps;
+		int min;
+		int originX;
+		int originY;
+		int width;
+		int height;
+		int clusters;
+		std::vector<int> cellStart;
+		std::vector<int> occupied;
+		std::vector<Point> points;
+		std::vector<char> cores;
+		std::vector<int> labels;
+	} previous;
+	// previous clusters with a core in a dirty cell
+	std::vector<char> touched;
+	// cores of each previous cluster
+	std::vector<int> clusterCores;
+	// a core of each previous cluster kept as is
+	std::vector<int> representatives;
+
+	// current pass
+	const Point *points;
+	int size;
+	int *labels;
+
+public:
+	// cores of the last pass kept in their previous cluster without query
+	int reused;
+
+	GridDbscan() {
+		this->eps = 0.0;
+		this->min = 0;
+		this->points = nullptr;
+		this->size = 0;
+		this->labels = nullptr;
+		this->reused = 0;
+		this->previous.eps = 0.0;
+		this->previous.min = 0;
+		this->previous.clusters = -1;
+	}
+
+	int run(const std::vector<Point> &input, std::vector<int> &output, double eps, int min) {
+		bool reuse = this->previous.clusters >= 0 && eps == this->previous.eps && min == this->previous.min;
+		this->eps = eps;
+		this->min = min;
+		this->points = input.data();
+		this->size = input.size();
+		this->buildGrid();
+
+		output.assign(this->size, 0);
+		this->labels = output.data();
+		this->reused = 0;
+
+		// most clusters touched, expanding them again from the dirty cells costs more than a full pass
+		if (reuse)
+			reuse = this->markDirty() < 0.5f;
+
+		int clusters = 0;
+		if (reuse) {
+			this->findCores();
+			this->joinCores();
+			clusters = this->numberClusters();
+		} else {
+			this->cores.assign(this->size, 0);
+			for (int i = 0; i < this->size; i++) {
+				if (!this->labels[i]) {
+					if (this->expandCluster(i, clusters + 1))
+						clusters++;
+				}
+			}
+		}
+		this->keepPass(clusters);
+
+		this->points = nullptr;
+		this->labels = nullptr;
+		return clusters;
+	}
+
+private:
+
+	inline int cellX(double x) const {
+		return (int)std::floor(x / this->eps) - this->originX;
+	}
+
+	inline int cellY(double y) const {
+		return (int)std::floor(y / this->eps) - this->originY;
+	}
+
+	// cell of the previous pass at cell x, y of this one, -1 if out of its grid
+	inline int previousCell(int x, int y) const {
+		x += this->originX - this->previous.originX;
+		y += this->originY - this->previous.originY;
+		if (x < 0 || y < 0 || x >= this->previous.width || y >= this->previous.height)
+			return -1;
+		return x + y * this->previous.width;
+	}
+
+	// counting sort of points by cell
+	void buildGrid() {
+		int size = this->size;
+		if (size == 0) {
+			this->originX = 0;
+			this->originY = 0;
+			this->width = 0;
+			this->height = 0;
+			this->cellStart.assign(1, 0);
+			this->occupied.clear();
+			return;
+		}
+
+		double minX = this->points[0].x;
+		double minY = this->points[0].y;
+		double maxX = minX;
+		double maxY = minY;
+		for (int i = 0; i < size; ++i) {
+			const Point &p = this->points[i];
+			minX = std::min(minX, p.x);
+			minY = std::min(minY, p.y);
+			maxX = std::max(maxX, p.x);
+			maxY = std::max(maxY, p.y);
+		}
+		this->originX = 0;
+		this->originY = 0;
+		this->originX = this->cellX(minX);
+		this->originY = this->cellY(minY);
+		this->width = this->cellX(maxX) + 1;
+		this->height = this->cellY(maxY) + 1;
+
+		this->cellStart.assign(this->width * this->height + 1, 0);
+		this->pointCells.resize(size);
+		this->occupied.clear();
+		for (int i = 0; i < size; ++i) {
+			int cell = this->cellX(this->points[i].x) + this->cellY(this->points[i].y) * this->width;
+			this->pointCells[i] = cell;
+			if (this->cellStart[cell + 1]++ == 0)
+				this->occupied.push_back(cell);
+		}
+		for (unsigned int i = 1; i < this->cellStart.size(); ++i) {
+			this->cellStart[i] += this->cellStart[i - 1];
+		}
+
+		this->cellPoints.resize(size);
+		for (int i = 0; i < size; ++i) {
+			this->cellPoints[this->cellStart[this->pointCells[i]]++] = i;
+		}
+		for (int i = this->cellStart.size() - 1; i > 0; --i) {
+			this->cellStart[i] = this->cellStart[i - 1];
+		}
+		this->cellStart[0] = 0;
+	}
+
+	// a cell changed if its points are not the same, in the same order, than in the previous pass
+	// returns the share of the previous cores in touched clusters
+	float markDirty() {
+		int cells = this->width * this->height;
+		this->dirty.assign(cells, 0);
+		this->stable.assign(cells, 1);
+
+		for (int cell : this->occupied) {
+			int x = cell % this->width;
+			int y = cell / this->width;
+			if (!this->samePoints(cell, this->previousCell(x, y)))
+				this->markChanged(x, y);
+		}
+
+		// previous cells now empty or out of the grid
+		int offsetX = this->previous.originX - this->originX;
+		int offsetY = this->previous.originY - this->originY;
+		for (int prevCell : this->previous.occupied) {
+			int x = prevCell % this->previous.width + offsetX;
+			int y = prevCell / this->previous.width + offsetY;
+			if (x < 0 || y < 0 || x >= this->width || y >= this->height || this->cellStart[x + y * this->width] == this->cellStart[x + y * this->width + 1])
+				this->markChanged(x, y);
+		}
+
+		// previous clusters with a core in a dirty cell may have changed
+		this->touched.assign(this->previous.clusters + 1, 0);
+		this->clusterCores.assign(this->previous.clusters + 1, 0);
+		for (int prevCell : this->previous.occupied) {
+			int x = prevCell % this->previous.width + offsetX;
+			int y = prevCell / this->previous.width + offsetY;
+			bool dirty = x < 0 || y < 0 || x >= this->width || y >= this->height || this->dirty[x + y * this->width];
+			for (int i = this->previous.cellStart[prevCell]; i < this->previous.cellStart[prevCell + 1]; ++i) {
+				if (this->previous.cores[i] == 1) {
+					this->clusterCores[this->previous.labels[i]]++;
+					if (dirty)
+						this->touched[this->previous.labels[i]] = 1;
+				}
+			}
+		}
+
+		int cores = 0;
+		int touchedCores = 0;
+		for (int label = 1; label <= this->previous.clusters; ++label) {
+			cores += this->clusterCores[label];
+			if (this->touched[label])
+				touchedCores += this->clusterCores[label];
+		}
+		return cores > 0 ? (float)touchedCores / cores : 0.0f;
+	}
+
+	bool samePoints(int cell, int prevCell) const {
+		if (prevCell < 0)
+			return false;
+		int begin = this->cellStart[cell];
+		int prevBegin = this->previous.cellStart[prevCell];
+		int count = this->cellStart[cell + 1] - begin;
+		if (this->previous.cellStart[prevCell + 1] - prevBegin != count)
+			return false;
+		for (int i = 0; i < count; ++i) {
+			const Point &p = this->points[this->cellPoints[begin + i]];
+			const Point &q = this->previous.points[prevBegin + i];
+			if (p.x != q.x || p.y != q.y)
+				return false;
+		}
+		return true;
+	}
+
+	// cells next to a changed cell are dirty, cells two cells away are not stable
+	void markChanged(int x, int y) {
+		for (int ny = std::max(0, y - 2); ny <= std::min(this->height - 1, y + 2); ++ny) {
+			for (int nx = std::max(0, x - 2); nx <= std::min(this->width - 1, x + 2); ++nx) {
+				int cell = nx + ny * this->width;
+				this->stable[cell] = 0;
+				if (std::abs(nx - x) <= 1 && std::abs(ny - y) <= 1)
+					this->dirty[cell] = 1;
+			}
+		}
+	}
+
+	// points of clean cells have the same neighbours than in the previous pass
+	// border points of stable cells keep their previous cluster, found again in numberClusters
+	void findCores() {
+		this->cores.resize(this->size);
+		for (int cell : this->occupied) {
+			int prevBegin = this->dirty[cell] ? 0 : this->previous.cellStart[this->previousCell(cell % this->width, cell / this->width)];
+			for (int i = this->cellStart[cell]; i < this->cellStart[cell + 1]; ++i) {
+				int p = this->cellPoints[i];
+				if (this->dirty[cell]) {
+					this->cores[p] = this->coreKind(this->countQuery(p));
+				} else {
+					int prev = prevBegin + i - this->cellStart[cell];
+					this->cores[p] = this->previous.cores[prev];
+					if (this->cores[p] != 1 && !this->stable[cell])
+						this->cores[p] = 0;
+					this->labels[p] = this->previous.labels[prev];
+				}
+			}
+		}
+	}
+
+	// from the number of neighbours, p included
+	inline char coreKind(int count) const {
+		if (count >= this->min)
+			return 1;
+		return count > 1 ? 0 : -1;
+	}
+
+	// cores of an untouched previous cluster are still connected, others are joined to their neighbour cores
+	void joinCores() {
+		this->parents.resize(this->size);
+		for (int i = 0; i < this->size; ++i) {
+			this->parents[i] = i;
+		}
+		this->representatives.assign(this->previous.clusters + 1, -1);
+
+		for (int cell : this->occupied) {
+			for (int i = this->cellStart[cell]; i < this->cellStart[cell + 1]; ++i) {
+				int p = this->cellPoints[i];
+				if (this->cores[p] != 1)
+					continue;
+
+				if (!this->dirty[cell]) {
+					int label = this->labels[p];
+					if (!this->touched[label]) {
+						if (this->representatives[label] < 0)
+							this->representatives[label] = p;
+						else
+							this->unite(this->representatives[label], p);
+						this->reused++;
+						continue;
+					}
+				}
+
+				this->regionQuery(p, this->neighbors);
+				for (int q : this->neighbors) {
+					if (this->cores[q] == 1)
+						this->unite(p, q);
+				}
+			}
+		}
+	}
+
+	// same labels than the third_party/dbscan expansion:
+	// clusters are numbered in the order of their first core,
+	// each cluster labels the neighbours of its first core even if already in a cluster, then its other border points not yet in one
+	// so a border point is in the last cluster whose first core is a neighbour, else in the first cluster with a neighbour core
+	int numberClusters() {
+		this->numbers.assign(this->size, 0);
+		this->starts.clear();
+		for (int p = 0; p < this->size; ++p) {
+			if (this->cores[p] == 1) {
+				int root = this->find(p);
+				if (!this->numbers[root]) {
+					this->starts.push_back(p);
+					this->numbers[root] = this->starts.size();
+				}
+				this->labels[p] = this->numbers[root];
+			}
+		}
+
+		for (int p = 0; p < this->size; ++p) {
+			if (this->cores[p] == 1)
+				continue;
+			if (this->cores[p] < 0) {
+				this->labels[p] = -1;
+				continue;
+			}
+			// previous cluster kept as is, p has the same neighbour cores
+			if (this->cores[p] == 2 && !this->touched[this->labels[p]]) {
+				this->labels[p] = this->numbers[this->find(this->representatives[this->labels[p]])];
+				continue;
+			}
+
+			int lastStart = 0;
+			int first = 0;
+			bool single = true;
+			this->regionQuery(p, this->neighbors);
+			for (int q : this->neighbors) {
+				if (this->cores[q] == 1) {
+					int cluster = this->numbers[this->find(q)];
+					if (this->starts[cluster - 1] == q)
+						lastStart = std::max(lastStart, cluster);
+					if (first && cluster != first)
+						single = false;
+					if (!first || cluster < first)
+						first = cluster;
+				}
+			}
+			this->labels[p] = lastStart ? lastStart : (first ? first : -1);
+			this->cores[p] = first ? (single ? 2 : 0) : -1;
+		}
+		return this->starts.size();
+	}
+
+	void keepPass(int clusters) {
+		this->previous.eps = this->eps;
+		this->previous.min = this->min;
+		this->previous.originX = this->originX;
+		this->previous.originY = this->originY;
+		this->previous.width = this->width;
+		this->previous.height = this->height;
+		this->previous.clusters = clusters;
+		this->previous.cellStart.swap(this->cellStart);
+		this->previous.occupied.swap(this->occupied);
+		this->previous.points.resize(this->size);
+		this->previous.cores.resize(this->size);
+		this->previous.labels.resize(this->size);
+		for (int i = 0; i < this->size; ++i) {
+			int p = this->cellPoints[i];
+			this->previous.points[i] = this->points[p];
+			this->previous.cores[i] = this->cores[p];
+			this->previous.labels[i] = this->labels[p];
+		}
+	}
+
+	int find(int p) {
+		while (this->parents[p] != p) {
+			this->parents[p] = this->parents[this->parents[p]];
+			p = this->parents[p];
+		}
+		return p;
+	}
+
+	void unite(int p, int q) {
+		p = this->find(p);
+		q = this->find(q);
+		if (p < q)
+			this->parents[q] = p;
+		else if (q < p)
+			this->parents[p] = q;
+	}
+
+	// same expansion order than third_party/dbscan, seeds are a queue without duplicates
+	bool expandCluster(int p, int cluster) {
+		int count = this->regionQuery(p, this->seeds);
+		this->cores[p] = this->coreKind(count);
+		if (count < this->min) {
+			// this point is noise
+			this->labels[p] = -1;
+			return false;
+		}
+
+		for (int s : this->seeds) {
+			this->labels[s] = cluster;
+		}
+		this->seeds.erase(std::remove(this->seeds.begin(), this->seeds.end(), p), this->seeds.end());
+
+		for (unsigned int head = 0; head < this->seeds.size(); ++head) {
+			int cp = this->seeds[head];
+			int count = this->regionQuery(cp, this->neighbors);
+			this->cores[cp] = this->coreKind(count);
+			if (count >= this->min) {
+				for (int rp : this->neighbors) {
+					// noise or unmarked point
+					if (this->labels[rp] < 1) {
+						if (!this->labels[rp])
+							this->seeds.push_back(rp);
+						this->labels[rp] = cluster;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// neighbours up to min, enough to know if p is a core
+	int countQuery(int p) const {
+		int count = 0;
+		const Point &pp = this->points[p];
+		int cx = this->pointCells[p] % this->width;
+		int cy = this->pointCells[p] / this->width;
+		double eps2 = this->eps * this->eps;
+
+		for (int y = std::max(0, cy - 1); y <= std::min(this->height - 1, cy + 1); ++y) {
+			for (int x = std::max(0, cx - 1); x <= std::min(this->width - 1, cx + 1); ++x) {
+				int cell = x + y * this->width;
+				for (int i = this->cellStart[cell]; i < this->cellStart[cell + 1]; ++i) {
+					int q = this->cellPoints[i];
+					double dx = this->points[q].x - pp.x;
+					double dy = this->points[q].y - pp.y;
+					if (dx * dx + dy * dy < eps2 && ++count >= this->min)
+						return count;
+				}
+			}
+		}
+		return count;
+	}
+
+	// points closer than eps, p included
+	int regionQuery(int p, std::vector<int> &output) const {
+		output.clear();
+		const Point &pp = this->points[p];
+		int cx = this->pointCells[p] % this->width;
+		int cy = this->pointCells[p] / this->width;
+		double eps2 = this->eps * this->eps;
+
+		for (int y = std::max(0, cy - 1); y <= std::min(this->height - 1, cy + 1); ++y) {
+			for (int x = std::max(0, cx - 1); x <= std::min(this->width - 1, cx + 1); ++x) {
+				int cell = x + y * this->width;
+				for (int i = this->cellStart[cell]; i < this->cellStart[cell + 1]; ++i) {
+					int q = this->cellPoints[i];
+					double dx = this->points[q].x - pp.x;
+					double dy = this->points[q].y - pp.y;
+					if (dx * dx + dy * dy < eps2)
+						output.push_back(q);
+				}
+			}
+		}
+		return output.size();
+	}
+};
+
+inline int gridDbscan(const std::vector<Point> &input, std::vector<int> &labels, double eps, int min) {
+	GridDbscan dbscan;
+	return dbscan.run(input, labels, eps, min);
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+#include "GameEngine.hpp"
+#include "WorldHash.hpp"
+
+// game without window for a number of ticks, reports simulation speed, time per system and entity counts
+// AI players watched by a neutral player, or a replayed match
+class HeadlessRun {
+public:
+	MatchSettings settings;
+	unsigned long ticks;
+	// json report, none if empty
+	std::string output;
+	// replay file to write, none if empty
+	std::string record;
+	// replay file to play, settings are read from it
+	std::string replay;
+	// world state hashes file to write per tick, none if empty
+	std::string hashes;
+	// world state hashes to compare with, settings and ticks are read from it
+	std::string golden;
+	// chrome trace JSON of the run, none if empty
+	std::string trace;
+
+	HeadlessRun() {
+		this->ticks = 1000;
+	}
+
+	int run() {
+		Replay replay;
+		if (this->replay.size() > 0) {
+			if (!replay.load(this->replay))
+				return EXIT_FAILURE;
+			this->settings = replay.settings;
+		}
+
+		WorldHashStream golden;
+		if (this->golden.size() > 0) {
+			if (!golden.load(this->golden))
+				return EXIT_FAILURE;
+			if (this->replay.size() == 0)
+				this->settings = golden.settings;
+			this->ticks = golden.hashes.size() > 0 ? golden.hashes.back().tick : 0;
+		}
+
+		GameVault vault;
+		sf::Clock loadClock;
+		GameEngine *engine = new GameEngine(&vault, this->settings);
+		float loadTime = loadClock.getElapsedTime().asSeconds();
+
+		if (this->replay.size() > 0)
+			engine->commands.play(replay);
+		if (this->record.size() > 0 && !engine->commands.startRecord(this->record, this->settings)) {
+			delete engine;
+			return EXIT_FAILURE;
+		}
+
+		WorldHasher hasher(vault.registry, *engine->map);
+		std::vector<WorldHash> hashes;
+		bool hashing = this->hashes.size() > 0 || this->golden.size() > 0;
+		float hashTime = 0.0f;
+
+		if (this->trace.size() > 0)
+			Profiler::get().startTrace();
+
+		sf::Clock clock;
+		while (engine->ticks < this->ticks && !engine->nextStage) {
+			unsigned long tick = engine->ticks;
+			engine->step();
+			if (hashing && engine->ticks != tick) {
+				sf::Clock hashClock;
+				hashes.push_back(hasher.hash(engine->ticks));
+				hashTime += hashClock.getElapsedTime().asSeconds();
+			}
+		}
+		// hashing is not part of the simulation
+		float runTime = clock.getElapsedTime().asSeconds() - hashTime;
+
+		if (this->trace.size() > 0) {
+			Profiler::get().stopTrace();
+			if (!Profiler::get().writeTrace(this->trace)) {
+				delete engine;
+				return EXIT_FAILURE;
+			}
+		}
+
+		this->report(std::cout, *engine, vault, loadTime, runTime);
+
+		if (this->output.size() > 0) {
+			std::ofstream file(this->output);
+			if (!file) {
+				std::cerr << "ERROR: cannot write " << this->output << std::endl;
+				delete engine;
+				return EXIT_FAILURE;
+			}
+			this->reportJson(file, *engine, vault, loadTime, runTime);
+		}
+
+		if (this->hashes.size() > 0) {
+			std::ofstream file(this->hashes);
+			if (!file) {
+				std::cerr << "ERROR: cannot write " << this->hashes << std::endl;
+				delete engine;
+				return EXIT_FAILURE;
+			}
+			WorldHashStream::writeSettings(file, this->settings);
+			for (WorldHash const &hash : hashes) {
+				WorldHashStream::writeHash(file, hash);
+			}
+		}
+
+		delete engine;
+
+		if (this->golden.size() > 0) {
+			if (WorldHashStream::compare(golden.hashes, hashes, std::cout) >= 0)
+				return EXIT_FAILURE;
+			std::cout << "WorldHash: " << hashes.size() << " ticks match " << this->golden << std::endl;
+		}
+		return EXIT_SUCCESS;
+	}
+
+private:
+	std::map<std::string, unsigned long> entityCounts(GameVault &vault) {
+		std::map<std::string, unsigned long> counts;
+		counts["entities"] = vault.registry.size();
+		counts["units"] = vault.registry.size<Unit>();
+		counts["buildings"] = vault.registry.size<Building>();
+		counts["resources"] = vault.registry.size<Resource>();
+		counts["decors"] = vault.registry.size<Decor>();
+		counts["players"] = vault.registry.size<Player>();
+		return counts;
+	}
+
+	// seconds spent per system
+	std::map<std::string, float> systemTimes() {
+		std::map<std::string, float> times;
+		for (auto &pair : Profiler::get().zoneStats()) {
+			if (pair.second.category == "system")
+				times[pair.first] = pair.second.total;
+		}
+		return times;
+	}
+
+	float ticksPerSecond(GameEngine &engine, float runTime) {
+		return runTime > 0.0f ? engine.ticks / runTime : 0.0f;
+	}
+
+	void report(std::ostream &out, GameEngine &engine, GameVault &vault, float loadTime, float runTime) {
+		SimulationClock &clock = vault.registry.get<SimulationClock>();
+
+		out << "Headless: " << this->settings.mapWidth << "x" << this->settings.mapHeight << " seed " << this->settings.seed
+		    << (this->settings.scenario.size() > 0 ? " scenario " + this->settings.scenario : "")
+		    << " loaded in " << loadTime << "s" << std::endl;
+		out << "Headless: " << engine.ticks << " ticks " << clock.steps << " steps in " << runTime << "s, "
+		    << this->ticksPerSecond(engine, runTime) << " ticks/s" << std::endl;
+		if (engine.winner)
+			out << "Headless: player " << engine.winner << " " << vault.registry.get<Player>(engine.winner).team << " wins" << std::endl;
+
+		float systemsTime = 0.0f;
+		for (auto pair : this->systemTimes()) {
+			out << "  " << std::left << std::setw(14) << pair.first << std::right << std::setw(10) << pair.second * 1000.0f << "ms "
+			    << std::setw(10) << (engine.ticks ? pair.second * 1000.0f / engine.ticks : 0.0f) << "ms/tick" << std::endl;
+			systemsTime += pair.second;
+		}
+		out << "  " << std::left << std::setw(14) << "other" << std::right << std::setw(10) << (runTime - systemsTime) * 1000.0f << "ms" << std::endl;
+
+		for (auto pair : this->entityCounts(vault)) {
+			out << "  " << std::left << std::setw(14) << pair.first << std::right << std::setw(10) << pair.second << std::endl;
+		}
+
+		PathfindingStats &stats = vault.registry.get<PathfindingStats>();
+		out << "Headless: flow field cache " << stats.cacheHits << " hits " << stats.cacheMisses << " misses, "
+		    << this->cacheHitRate(stats) * 100.0f << "% hits" << std::endl;
+	}
+
+	float cacheHitRate(const PathfindingStats &stats) {
+		unsigned long gets = stats.cacheHits + stats.cacheMisses;
+		return gets > 0 ? (float)stats.cacheHits / gets : 0.0f;
+	}
+
+	void reportJson(std::ostream &out, GameEngine &engine, GameVault &vault, float loadTime, float runTime) {
+		SimulationClock &clock = vault.registry.get<SimulationClock>();
+
+		out << "{" << std::endl;
+		out << "  \"map\": [" << this->settings.mapWidth << ", " << this->settings.mapHeight << "]," << std::endl;
+		out << "  \"seed\": " << this->settings.seed << "," << std::endl;
+		out << "  \"scenario\": \"" << this->settings.scenario << "\"," << std::endl;
+		out << "  \"ticks\": " << engine.ticks << "," << std::endl;
+		out << "  \"steps\": " << clock.steps << "," << std::endl;
+		out << "  \"load_seconds\": " << loadTime << "," << std::endl;
+		out << "  \"run_seconds\": " << runTime << "," << std::endl;
+		out << "  \"ticks_per_second\": " << this->ticksPerSecond(engine, runTime) << "," << std::endl;
+		out << "  \"winner\": \"" << (engine.winner ? vault.registry.get<Player>(engine.winner).team : "") << "\"," << std::endl;
+
+		out << "  \"systems_ms\": {";
+		std::string sep = "";
+		for (auto pair : this->systemTimes()) {
+			out << sep << std::endl << "    \"" << pair.first << "\": " << pair.second * 1000.0f;
+			sep = ",";
+		}
+		out << std::endl << "  }," << std::endl;
+
+		out << "  \"zones\": {";
+		sep = "";
+		for (auto &pair : Profiler::get().zoneStats()) {
+			ProfileZoneStats &stats = pair.second;
+			out << sep << std::endl << "    \"" << pair.first << "\": {\"category\": \"" << stats.category << "\", \"calls\": " << stats.calls
+			    << ", \"total_ms\": " << stats.total * 1000.0 << ", \"min_ms\": " << stats.min() << ", \"avg_ms\": " << stats.avg()
+			    << ", \"p99_ms\": " << stats.percentile(0.99f) << "}";
+			sep = ",";
+		}
+		out << std::endl << "  }," << std::endl;
+
+		out << "  \"counters\": {";
+		sep = "";
+		for (auto &pair : Profiler::get().counterValues()) {
+			out << sep << std::endl << "    \"" << pair.first << "\": " << pair.second;
+			sep = ",";
+		}
+		out << std::endl << "  }," << std::endl;
+
+		PathfindingStats &stats = vault.registry.get<PathfindingStats>();
+		out << "  \"flowfield_cache\": {\"hits\": " << stats.cacheHits << ", \"misses\": " << stats.cacheMisses
+		    << ", \"hit_rate\": " << this->cacheHitRate(stats) << "}," << std::endl;
+
+		out << "  \"entities\": {";
+		sep = "";
+		for (auto pair : this->entityCounts(vault)) {
+			out << sep << std::endl << "    \"" << pair.first << "\": " << pair.second;
+			sep = ",";
+		}
+		out << std::endl << "  }" << std::endl;
+		out << "}" << std::endl;
+	}
+};
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <utility>
+#include <cmath>
+
+#include "Entity.hpp"
+#include "Helpers.hpp"
+
+// influence cell size in map cells
+#define INFLUENCE_CELL 4
+// threat kept per tick
+#define INFLUENCE_DECAY 0.99f
+// decayed threat under this is forgotten, a few hits of an usual attack
+#define INFLUENCE_MIN_THREAT 0.2f
+
+// coarse per team unit presence and threat
+// presence is updated only when a unit changes of influence cell or dies
+// threat is the damage received by a team, decayed lazily from the tick it was last written
+class InfluenceMap {
+	struct Record {
+		EntityID entity;
+		TeamID team;
+		int cell; // -1 if not tracked
+	};
+
+	struct TeamInfluence {
+		TeamID team;
+		std::vector<int> presence;
+		// units of other teams
+		std::vector<int> enemies;
+		// (enemies, cell) of cells with enemies, weakest first
+		std::set<std::pair<int, int>> enemyCells;
+
+		std::vector<float> threat;
+		std::vector<unsigned int> threatTick;
+		// uniform decay keeps the order between cells, only writes can change the hottest cell
+		int hottest;
+	};
+
+	int width; // influence cells
+	int height;
+	int mapWidth;
+	int mapHeight;
+	unsigned int ticks;
+
+	std::vector<TeamInfluence> teams;
+	// indexed by entity index
+	std::vector<Record> records;
+
+public:
+	InfluenceMap() {
+		this->width = 0;
+		this->height = 0;
+		this->mapWidth = 0;
+		this->mapHeight = 0;
+		this->ticks = 0;
+	}
+
+	void setSize(unsigned int width, unsigned int height) {
+		this->mapWidth = width;
+		this->mapHeight = height;
+		this->width = (width + INFLUENCE_CELL - 1) / INFLUENCE_CELL;
+		this->height = (height + INFLUENCE_CELL - 1) / INFLUENCE_CELL;
+		this->ticks = 0;
+		this->teams.clear();
+		this->records.clear();
+	}
+
+	void tick() {
+		this->ticks++;
+	}
+
+	// add or move a unit, does nothing while it stays in the same influence cell
+	void move(EntityID entity, TeamID team, sf::Vector2i pos) {
+		Record &record = this->record(entity);
+		int cell = this->cellIndex(pos);
+		if (record.entity == entity && record.team == team && record.cell == cell)
+			return;
+
+		if (record.cell >= 0)
+			this->addPresence(record.team, record.cell, -1);
+
+		record.entity = entity;
+		record.team = team;
+		record.cell = cell;
+		this->addPresence(team, cell, 1);
+	}
+
+	void remove(EntityID entity) {
+		unsigned int idx = entity & entt::entt_traits<EntityID>::entity_mask;
+		if (idx < this->records.size()) {
+			Record &record = this->records[idx];
+			if (record.entity == entity && record.cell >= 0) {
+				this->addPresence(record.team, record.cell, -1);
+				record.cell = -1;
+			}
+		}
+	}
+
+	// damage received by team at pos
+	void addThreat(TeamID team, sf::Vector2i pos, float amount) {
+		TeamInfluence &influence = this->team(team);
+		int cell = this->cellIndex(pos);
+		influence.threat[cell] = this->decayedThreat(influence, cell) + amount;
+		influence.threatTick[cell] = this->ticks;
+		if (influence.hottest < 0 || influence.threat[cell] > this->decayedThreat(influence, influence.hottest))
+			influence.hottest = cell;
+	}
+
+	int presence(TeamID team, sf::Vector2i pos) {
+		return this->team(team).presence[this->cellIndex(pos)];
+	}
+
+	int enemyPresence(TeamID team, sf::Vector2i pos) {
+		return this->team(team).enemies[this->cellIndex(pos)];
+	}
+
+	float threat(TeamID team, sf::Vector2i pos) {
+		TeamInfluence &influence = this->team(team);
+		return this->decayedThreat(influence, this->cellIndex(pos));
+	}
+
+	// center of the cell where team was the most attacked recently
+	bool hottestThreat(TeamID team, sf::Vector2i &pos) {
+		TeamInfluence &influence = this->team(team);
+		if (influence.hottest < 0 || this->decayedThreat(influence, influence.hottest) < INFLUENCE_MIN_THREAT)
+			return false;
+		pos = this->cellCenter(influence.hottest);
+		return true;
+	}
+
+	// center of the cell with the most units of other teams
+	bool strongestEnemy(TeamID team, sf::Vector2i &pos) {
+		TeamInfluence &influence = this->team(team);
+		if (influence.enemyCells.empty())
+			return false;
+		pos = this->cellCenter(influence.enemyCells.rbegin()->second);
+		return true;
+	}
+
+	// center of the cell with the least units of other teams, among cells holding some
+	bool weakestEnemy(TeamID team, sf::Vector2i &pos) {
+		return this->weakestEnemy(team, pos, [](sf::Vector2i center) {
+			return true;
+		});
+	}
+
+	// same among cells whose center is accepted by accept(center), as cells a player explored
+	template <typename F>
+	bool weakestEnemy(TeamID team, sf::Vector2i &pos, F accept) {
+		TeamInfluence &influence = this->team(team);
+		for (auto const &cell : influence.enemyCells) {
+			sf::Vector2i center = this->cellCenter(cell.second);
+			if (accept(center)) {
+				pos = center;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// centers and threat of the cells where team was attacked recently
+	void threatCells(TeamID team, std::vector<std::pair<sf::Vector2i, float>> &cells) {
+		TeamInfluence &influence = this->team(team);
+		cells.clear();
+		for (int cell = 0; cell < this->width * this->height; ++cell) {
+			if (influence.threat[cell] > 0.0f) {
+				float threat = this->decayedThreat(influence, cell);
+				if (threat >= INFLUENCE_MIN_THREAT)
+					cells.push_back(std::make_pair(this->cellCenter(cell), threat));
+			}
+		}
+	}
+
+private:
+	inline int cellIndex(sf::Vector2i pos) const {
+		int cx = std::min(this->width - 1, std::max(0, pos.x / INFLUENCE_CELL));
+		int cy = std::min(this->height - 1, std::max(0, pos.y / INFLUENCE_CELL));
+		return cx + cy * this->width;
+	}
+
+	inline sf::Vector2i cellCenter(int cell) const {
+		return sf::Vector2i(std::min(this->mapWidth - 1, (cell % this->width) * INFLUENCE_CELL + INFLUENCE_CELL / 2),
+		                    std::min(this->mapHeight - 1, (cell / this->width) * INFLUENCE_CELL + INFLUENCE_CELL / 2));
+	}
+
+	inline float decayedThreat(const TeamInfluence &influence, int cell) const {
+		return influence.threat[cell] * pow(INFLUENCE_DECAY, this->ticks - influence.threatTick[cell]);
+	}
+
+	Record &record(EntityID entity) {
+		unsigned int idx = entity & entt::entt_traits<EntityID>::entity_mask;
+		if (idx >= this->records.size())
+			this->records.resize(idx + 1, Record{0, 0, -1});
+		Record &record = this->records[idx];
+		// recycled entity index
+		if (record.entity != entity && record.cell >= 0) {
+			this->addPresence(record.team, record.cell, -1);
+			record.cell = -1;
+		}
+		return record;
+	}
+
+	TeamInfluence &team(TeamID team) {
+		for (TeamInfluence &influence : this->teams) {
+			if (influence.team == team)
+				return influence;
+		}
+
+		TeamInfluence influence;
+		influence.team = team;
+		influence.presence.assign(this->width * this->height, 0);
+		influence.enemies.assign(this->width * this->height, 0);
+		influence.threat.assign(this->width * this->height, 0.0f);
+		influence.threatTick.assign(this->width * this->height, 0);
+		influence.hottest = -1;
+		// units already tracked are enemies of the new team
+		for (TeamInfluence &other : this->teams) {
+			for (int cell = 0; cell < this->width * this->height; ++cell) {
+				if (other.presence[cell])
+					this->addEnemies(influence, cell, other.presence[cell]);
+			}
+		}
+		this->teams.push_back(influence);
+		return this->teams.back();
+	}
+
+	void addPresence(TeamID team, int cell, int count) {
+		this->team(team).presence[cell] += count;
+		for (TeamInfluence &influence : this->teams) {
+			if (influence.team != team)
+				this->addEnemies(influence, cell, count);
+		}
+	}
+
+	void addEnemies(TeamInfluence &influence, int cell, int count) {
+		int &enemies = influence.enemies[cell];
+		if (enemies)
+			influence.enemyCells.erase(std::make_pair(enemies, cell));
+		enemies += count;
+		if (enemies)
+			influence.enemyCells.insert(std::make_pair(enemies, cell));
+	}
+};
@@ -11,9 +11,25 @@ class ShaderManager
 private:
     std::map<std::string, sf::Shader*> shaders;
 
+    /* without GL context, shaders are registered as null */
+    bool headless;
+
 public:
+    ShaderManager() {
+        this->headless = false;
+    }
+
+    void setHeadless(bool headless) {
+        this->headless = headless;
+    }
+
     void load(std::string name, const std::string& filename)
     {
+        if (this->headless) {
+            this->shaders[name] = nullptr;
+            return;
+        }
+
         if (this->shaders.count(name) == 0) {
             sf::Shader *shader = new sf::Shader();
 #ifdef MANAGER_DEBUG
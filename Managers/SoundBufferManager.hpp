@@ -11,9 +11,23 @@ class SoundBufferManager
 private:
     std::map<std::string, sf::SoundBuffer> buffers;
 
+    /* no audio device, nothing is loaded */
+    bool headless;
+
 public:
+    SoundBufferManager() {
+        this->headless = false;
+    }
+
+    void setHeadless(bool headless) {
+        this->headless = headless;
+    }
+
     void load(std::string name, const std::string& filename)
     {
+        if (this->headless)
+            return;
+
         if (this->buffers.count(name) == 0) {
             sf::SoundBuffer buf;
 #ifdef MANAGER_DEBUG
@@ -13,13 +13,28 @@ private:
     /* Array of textures used */
     std::map<std::string, sf::Texture> textures;
 
+    /* without GL context, textures are left empty and only their sizes are kept */
+    bool headless;
+    std::map<std::string, sf::Vector2u> sizes;
+
 public:
 
+    TextureManager() {
+        this->headless = false;
+    }
+
+    void setHeadless(bool headless) {
+        this->headless = headless;
+    }
+
     void load(std::string name, int w, int h)
     {
         if (this->textures.count(name) == 0) {
             sf::Texture tex;
-            tex.create(w, h);
+            if (this->headless)
+                this->sizes[name] = sf::Vector2u(w, h);
+            else
+                tex.create(w, h);
             this->textures[name] = tex;
         }
         return;
@@ -34,7 +49,13 @@ public:
 #endif
             /* Load the texture */
             sf::Texture tex;
-            tex.loadFromFile(filename);
+            if (this->headless) {
+                sf::Image img;
+                img.loadFromFile(filename);
+                this->sizes[name] = img.getSize();
+            } else {
+                tex.loadFromFile(filename);
+            }
 
             /* Add it to the list of textures */
             this->textures[name] = tex;
@@ -55,7 +76,10 @@ public:
 #endif
             /* Load the texture */
             sf::Texture tex;
-            tex.loadFromImage(img, area);
+            if (this->headless)
+                this->sizes[name] = sf::Vector2u(area.width, area.height);
+            else
+                tex.loadFromImage(img, area);
 
             /* Add it to the list of textures */
             this->textures[name] = tex;
@@ -73,6 +97,13 @@ public:
         return this->textures.at(name);
     }
 
+    sf::Vector2u getSize(std::string name)
+    {
+        if (this->headless)
+            return this->sizes.at(name);
+        return this->textures.at(name).getSize();
+    }
+
     bool hasRef(std::string name) {
         return this->textures.count(name) > 0;
     }
@@ -30,13 +30,31 @@ void Map::setSize(unsigned int width, unsigned int height) {
 	this->staticPathfinding.setSize(width, height);
 	// buildings
 	this->pathfinding.setSize(width, height);
+	this->walkable.setSize(width, height);
+	this->obstacleField.setSize(width, height);
+	this->teamObjs.setSize(width, height);
+	this->influence.setSize(width, height);
 
-	this->units = new Quadtree<PathfindingObject>(0.0, 0.0, width * 32.0f, height * 32.0f, 16);
+	this->units = new SpatialHash<PathfindingObject>(width * 32.0f, height * 32.0f);
 
 	this->width = width;
 	this->height = height;
 }
 
+void Map::updateWalkable() {
+	this->updateWalkable(sf::IntRect(0, 0, this->width, this->height));
+}
+
+// sync walkable bitmap and obstacle field with pathfinding layers
+void Map::updateWalkable(sf::IntRect rect) {
+	for (int y = std::max(0, rect.top); y < std::min((int)this->height, rect.top + rect.height); ++y) {
+		for (int x = std::max(0, rect.left); x < std::min((int)this->width, rect.left + rect.width); ++x) {
+			this->walkable.set(x, y, this->pathAvailable(x, y));
+		}
+	}
+	this->obstacleField.update(this->walkable, rect);
+}
+
 void Map::markUpdateClear() {
 	this->markUpdateTerrainTransitions.clear();
 	this->markUpdateFogTransitions.clear();
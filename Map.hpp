@@ -6,7 +6,11 @@
 
 #include "Entity.hpp"
 #include "Helpers.hpp"
-#include "Quadtree.hpp"
+#include "SpatialHash.hpp"
+#include "TeamSpatialIndex.hpp"
+#include "InfluenceMap.hpp"
+#include "WalkabilityBitmap.hpp"
+#include "ObstacleField.hpp"
 
 #define VECTOR_LAYER
 
@@ -152,8 +156,45 @@ enum class FogState {
 	InSight
 };
 
+// a cell is InSight while objects of the player see it, counted per cell
 class Fog : public Layer<FogState, FogState::Unvisited> {
 public:
+	std::vector<unsigned short> sight;
+	// cells whose state changed since the last clearChanged, a cell flipping back and forth appears more than once
+	std::vector<int> changed;
+
+	void setSize(unsigned int w, unsigned int h) {
+		this->width = w;
+		this->height = h;
+		this->fill();
+	}
+
+	void fill() {
+		Layer<FogState, FogState::Unvisited>::fill();
+		this->sight.assign(this->width * this->height, 0);
+		this->changed.clear();
+	}
+
+	void reveal(int x, int y) {
+		int idx = this->index(x, y);
+		if (this->sight[idx]++ == 0 && this->grid[idx] != FogState::InSight) {
+			this->grid[idx] = FogState::InSight;
+			this->changed.push_back(idx);
+		}
+	}
+
+	void conceal(int x, int y) {
+		int idx = this->index(x, y);
+		if (this->sight[idx] > 0 && --this->sight[idx] == 0 && this->grid[idx] == FogState::InSight) {
+			this->grid[idx] = FogState::Hidden;
+			this->changed.push_back(idx);
+		}
+	}
+
+	void clearChanged() {
+		this->changed.clear();
+	}
+
 	int visited() {
 		int visited = 0;
 //		for (FogState st : grid) {
@@ -197,8 +238,16 @@ public:
 
 	Layer<EntityID> staticPathfinding;
 	Layer<EntityID> pathfinding;
+	// packed pathAvailable() of both pathfinding layers, for JPS searches
+	WalkabilityBitmap walkable;
+	// nearest obstacles, for steering avoidance
+	ObstacleField obstacleField;
 
-	Quadtree<PathfindingObject>* units;
+	SpatialHash<PathfindingObject>* units;
+	// game objects by team, for combat target queries
+	TeamSpatialIndex teamObjs;
+	// coarse unit presence and threat by team, for AI
+	InfluenceMap influence;
 
 	// transitions calculation optimization
 	// maintain a list of position to update instead of updating every transitions
@@ -211,6 +260,9 @@ public:
 
 	void markUpdateClear();
 
+	void updateWalkable();
+	void updateWalkable(sf::IntRect rect);
+
 
 	inline bool bound(int x, int y) const {
 		return (x >= 0 && y >= 0 && x < this->width && y < this->height);
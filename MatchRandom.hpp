@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+// per match random numbers, seeded when the match is generated
+// pcg32, the same sequence for a seed with any compiler or libc unlike rand() and std::random_shuffle
+class MatchRandom {
+	uint64_t state;
+	uint32_t seedValue;
+
+public:
+	MatchRandom() {
+		this->seed(0);
+	}
+
+	void seed(uint32_t seed) {
+		this->seedValue = seed;
+		this->state = 0;
+		this->next();
+		this->state += 0x853c49e6748fea9bULL + seed;
+		this->next();
+	}
+
+	uint32_t getSeed() const {
+		return this->seedValue;
+	}
+
+	uint32_t next() {
+		uint64_t old = this->state;
+		this->state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint32_t xorshifted = ((old >> 18u) ^ old) >> 27u;
+		uint32_t rot = old >> 59u;
+		return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+	}
+
+	// in [0, n)
+	int range(int n) {
+		if (n <= 0)
+			return 0;
+		return this->next() % (uint32_t)n;
+	}
+
+	// in [0, 1)
+	float uniform() {
+		return (this->next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	template <typename RandomIt>
+	void shuffle(RandomIt first, RandomIt last) {
+		for (int i = (int)(last - first) - 1; i > 0; --i) {
+			std::swap(first[i], first[this->range(i + 1)]);
+		}
+	}
+};
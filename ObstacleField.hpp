@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Helpers.hpp"
+#include "WalkabilityBitmap.hpp"
+
+// cells searched around each cell for the nearest obstacle, or the nearest free cell inside obstacles
+#define OBSTACLE_FIELD_RADIUS 4
+#define OBSTACLE_FIELD_NONE -1000000
+
+// nearest obstacle of every free cell and nearest free cell of every blocked cell, out of map cells are obstacles
+// only cells around a changed rect are searched again, in a bounded window
+// distance and gradient at a pixel position are then computed from the cell boxes found, without allocation
+class ObstacleField {
+	struct Cell {
+		sf::Vector2i nearest; // from the cell center
+		unsigned char around; // bit per neighbour of the other kind, exact distances under a cell
+		bool blocked;
+	};
+
+	int width;
+	int height;
+	// cell offsets by increasing distance, the first hit is the nearest
+	std::vector<sf::Vector2i> offsets;
+	std::vector<Cell> cells;
+
+public:
+	ObstacleField() {
+		this->width = 0;
+		this->height = 0;
+
+		for (int dy = -OBSTACLE_FIELD_RADIUS; dy <= OBSTACLE_FIELD_RADIUS; ++dy) {
+			for (int dx = -OBSTACLE_FIELD_RADIUS; dx <= OBSTACLE_FIELD_RADIUS; ++dx) {
+				if (dx != 0 || dy != 0)
+					this->offsets.push_back(sf::Vector2i(dx, dy));
+			}
+		}
+		std::stable_sort(this->offsets.begin(), this->offsets.end(), [](const sf::Vector2i & a, const sf::Vector2i & b) {
+			return a.x * a.x + a.y * a.y < b.x * b.x + b.y * b.y;
+		});
+	}
+
+	void setSize(unsigned int width, unsigned int height) {
+		this->width = width;
+		this->height = height;
+		this->cells.assign(width * height, Cell{sf::Vector2i(OBSTACLE_FIELD_NONE, OBSTACLE_FIELD_NONE), 0, false});
+	}
+
+	// walkable changed in rect
+	void update(const WalkabilityBitmap &walkable, sf::IntRect rect) {
+		int left = std::max(0, rect.left - OBSTACLE_FIELD_RADIUS);
+		int top = std::max(0, rect.top - OBSTACLE_FIELD_RADIUS);
+		int right = std::min(this->width, rect.left + rect.width + OBSTACLE_FIELD_RADIUS);
+		int bottom = std::min(this->height, rect.top + rect.height + OBSTACLE_FIELD_RADIUS);
+
+		for (int y = top; y < bottom; ++y) {
+			for (int x = left; x < right; ++x) {
+				Cell &cell = this->cells[x + y * this->width];
+				bool open = walkable(x, y);
+				cell.nearest = sf::Vector2i(OBSTACLE_FIELD_NONE, OBSTACLE_FIELD_NONE);
+				cell.around = 0;
+				cell.blocked = !open;
+				// out of map cells block, but are no way out of an obstacle
+				for (int i = 0; i < 8; ++i) {
+					if (open != walkable(x + this->offsets[i].x, y + this->offsets[i].y))
+						cell.around |= 1 << i;
+				}
+				for (sf::Vector2i const &offset : this->offsets) {
+					if (open != walkable(x + offset.x, y + offset.y)) {
+						cell.nearest = sf::Vector2i(x + offset.x, y + offset.y);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// dist is the distance in pixels from ppos to the nearest obstacle, gradient points away from it
+	// inside an obstacle, dist is minus the distance to the nearest free cell, gradient points toward it
+	// false if there is none in OBSTACLE_FIELD_RADIUS cells
+	bool sample(sf::Vector2f ppos, float &dist, sf::Vector2f &gradient) const {
+		if (this->width == 0 || this->height == 0)
+			return false;
+
+		int x = std::min(this->width - 1, std::max(0, (int)floor(ppos.x / 32.0f)));
+		int y = std::min(this->height - 1, std::max(0, (int)floor(ppos.y / 32.0f)));
+		const Cell &cell = this->cells[x + y * this->width];
+		if (cell.nearest.x == OBSTACLE_FIELD_NONE)
+			return false;
+
+		// closest neighbour box from ppos, or the nearest cell from the center when none
+		sf::Vector2i nearest = cell.nearest;
+		sf::Vector2f closest = this->closest(nearest, ppos);
+		if (cell.around) {
+			float best = std::numeric_limits<float>::max();
+			for (unsigned int around = cell.around; around; around &= around - 1) {
+				const sf::Vector2i &offset = this->offsets[bitmapCtz(around)];
+				sf::Vector2i n(x + offset.x, y + offset.y);
+				sf::Vector2f c = this->closest(n, ppos);
+				float d2 = (ppos.x - c.x) * (ppos.x - c.x) + (ppos.y - c.y) * (ppos.y - c.y);
+				if (d2 < best) {
+					best = d2;
+					nearest = n;
+					closest = c;
+				}
+			}
+		}
+		dist = length(ppos - closest);
+
+		sf::Vector2f away = ppos - closest;
+		float len = dist;
+		if (len == 0.0f) {
+			away = ppos - (sf::Vector2f(nearest) * 32.0f + 16.0f);
+			len = length(away);
+		}
+		gradient = len > 0.0f ? away / len : sf::Vector2f(0, 0);
+
+		if (cell.blocked) {
+			gradient = -gradient;
+			dist = -dist;
+		}
+		return true;
+	}
+
+private:
+	// closest point of the cell box
+	static inline sf::Vector2f closest(sf::Vector2i cell, sf::Vector2f ppos) {
+		return sf::Vector2f(std::min(cell.x * 32.0f + 32.0f, std::max(cell.x * 32.0f, ppos.x)),
+		                    std::min(cell.y * 32.0f + 32.0f, std::max(cell.y * 32.0f, ppos.y)));
+	}
+};
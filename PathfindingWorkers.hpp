@@ -0,0 +1,226 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include "Config.hpp"
+#include "Entity.hpp"
+#include "Map.hpp"
+#include "SectorGraph.hpp"
+#include "FlowField.hpp"
+#include "third_party/JPS.h"
+
+// immutable copy of the map walkability and sector graph, searched by workers while the game goes on
+// the graph copy shares its sectors with the live one, only sectors rebuilt since are not shared
+class WalkabilitySnapshot {
+public:
+	unsigned long version;
+	WalkabilityBitmap walkable;
+	SectorGraph sectorGraph;
+
+	WalkabilitySnapshot(const Map &map, const SectorGraph &graph, unsigned long version) : walkable(map.walkable), sectorGraph(graph) {
+		this->version = version;
+	}
+};
+
+struct PathJob {
+	EntityID entity;
+	unsigned long seq;
+	unsigned long tick;
+	// tick the result is applied at
+	unsigned long due;
+	// nodes charged to the tick budget when sent
+	unsigned int charged;
+	sf::Vector2i start;
+	sf::Vector2i dest;
+	std::shared_ptr<const WalkabilitySnapshot> snapshot;
+};
+
+struct PathResult {
+	EntityID entity;
+	unsigned long seq;
+	unsigned long tick;
+	unsigned long due;
+	unsigned int charged;
+	unsigned long version;
+	sf::Vector2i start;
+	sf::Vector2i dest;
+	bool found;
+	unsigned int steps;
+	std::list<sf::Vector2i> points;
+	std::list<sf::Vector2i> waypoints;
+
+	// check of a result searched on an older snapshot
+	// JPS segments are walked on the map, sector graph legs must not cross a rect changed since
+	bool stillValid(const Map &map, const std::vector<sf::IntRect> &changed) const {
+		sf::Vector2i cur = this->start;
+		for (sf::Vector2i const &p : this->points) {
+			if (!this->walkSegment(map, cur, p))
+				return false;
+			cur = p;
+		}
+
+		cur = this->start;
+		for (sf::Vector2i const &p : this->waypoints) {
+			// legs are refined inside the sectors of their ends
+			int left = std::min(cur.x, p.x) / PER_SECTOR * PER_SECTOR;
+			int top = std::min(cur.y, p.y) / PER_SECTOR * PER_SECTOR;
+			sf::IntRect bounds(left, top,
+			                   (std::max(cur.x, p.x) / PER_SECTOR + 1) * PER_SECTOR - left,
+			                   (std::max(cur.y, p.y) / PER_SECTOR + 1) * PER_SECTOR - top);
+			for (sf::IntRect const &rect : changed) {
+				if (bounds.intersects(rect))
+					return false;
+			}
+			cur = p;
+		}
+		return true;
+	}
+
+private:
+	// straight or diagonal line, no corner tunneling like JPS
+	bool walkSegment(const Map &map, sf::Vector2i from, sf::Vector2i to) const {
+		sf::Vector2i dir((to.x > from.x) - (to.x < from.x), (to.y > from.y) - (to.y < from.y));
+		sf::Vector2i p = from;
+		while (p != to) {
+			if (dir.x && dir.y && !map.pathAvailable(p.x + dir.x, p.y) && !map.pathAvailable(p.x, p.y + dir.y))
+				return false;
+			if (p.x != to.x)
+				p.x += dir.x;
+			if (p.y != to.y)
+				p.y += dir.y;
+			if (!map.pathAvailable(p.x, p.y))
+				return false;
+			dir = sf::Vector2i((to.x > p.x) - (to.x < p.x), (to.y > p.y) - (to.y < p.y));
+		}
+		return true;
+	}
+};
+
+// searches run on snapshots only, so results only depend on the job and not on workers count or timing
+class PathfindingWorkers {
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable jobsCond;
+	std::condition_variable doneCond;
+	std::deque<PathJob> jobs;
+	std::vector<PathResult> results;
+	// jobs still searched by due tick
+	std::map<unsigned long, int> pending;
+	bool stopping;
+
+public:
+	PathfindingWorkers() {
+		this->stopping = false;
+	}
+
+	~PathfindingWorkers() {
+		this->stop();
+	}
+
+	// no thread means jobs are searched when pushed
+	void start(int count) {
+		this->stopping = false;
+		for (int i = 0; i < count; ++i) {
+			this->threads.push_back(std::thread(&PathfindingWorkers::work, this));
+		}
+	}
+
+	void stop() {
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->jobsCond.notify_all();
+		for (std::thread &thread : this->threads) {
+			thread.join();
+		}
+		this->threads.clear();
+	}
+
+	int size() const {
+		return this->threads.size();
+	}
+
+	void push(const PathJob &job) {
+		if (this->threads.size() == 0) {
+			this->results.push_back(search(job));
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->jobs.push_back(job);
+			this->pending[job.due]++;
+		}
+		this->jobsCond.notify_one();
+	}
+
+	// get the results due at tick in push order, finished results due later stay
+	// only waits for searches due at tick and not finished yet, so results do not depend on workers count or timing
+	void drain(unsigned long tick, std::vector<PathResult> &done) {
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->doneCond.wait(lock, [this, tick] { return this->pending.size() == 0 || this->pending.begin()->first > tick; });
+		for (size_t i = 0; i < this->results.size();) {
+			if (this->results[i].due <= tick) {
+				done.push_back(std::move(this->results[i]));
+				this->results[i] = std::move(this->results.back());
+				this->results.pop_back();
+			} else {
+				++i;
+			}
+		}
+		std::sort(done.begin(), done.end(), [](const PathResult & a, const PathResult & b) { return a.seq < b.seq; });
+	}
+
+	static PathResult search(const PathJob &job) {
+		PathResult result;
+		result.entity = job.entity;
+		result.seq = job.seq;
+		result.tick = job.tick;
+		result.due = job.due;
+		result.charged = job.charged;
+		result.version = job.snapshot->version;
+		result.start = job.start;
+		result.dest = job.dest;
+		result.steps = 0;
+
+		JPS::Searcher<WalkabilityBitmap> searcher(job.snapshot->walkable);
+		result.found = searchPath(job.snapshot->walkable, job.snapshot->sectorGraph, searcher, job.start, job.dest, result.points, result.waypoints, result.steps);
+		return result;
+	}
+
+private:
+	void work() {
+		while (true) {
+			PathJob job;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->jobsCond.wait(lock, [this] { return this->stopping || this->jobs.size() > 0; });
+				if (this->stopping && this->jobs.size() == 0)
+					return;
+				job = this->jobs.front();
+				this->jobs.pop_front();
+			}
+
+			PathResult result = search(job);
+
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->results.push_back(result);
+				auto it = this->pending.find(job.due);
+				if (--it->second == 0)
+					this->pending.erase(it);
+			}
+			this->doneCond.notify_all();
+		}
+	}
+};
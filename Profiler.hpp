@@ -0,0 +1,422 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// durations kept per zone for min/avg/p99
+#define PROFILER_WINDOW 256
+// trace events kept at most, tracing stops past it
+#define PROFILER_MAX_TRACE_EVENTS 1000000
+
+struct ProfileZoneStats {
+	std::string category;
+	unsigned long calls;
+	// seconds
+	double total;
+	// last durations in milliseconds, ring buffer
+	float window[PROFILER_WINDOW];
+	int windowSize;
+	int windowPos;
+
+	ProfileZoneStats() {
+		this->calls = 0;
+		this->total = 0.0;
+		this->windowSize = 0;
+		this->windowPos = 0;
+	}
+
+	void add(float ms) {
+		this->calls++;
+		this->total += ms / 1000.0;
+		this->window[this->windowPos] = ms;
+		this->windowPos = (this->windowPos + 1) % PROFILER_WINDOW;
+		if (this->windowSize < PROFILER_WINDOW)
+			this->windowSize++;
+	}
+
+	float min() const {
+		if (this->windowSize == 0)
+			return 0.0f;
+		return *std::min_element(this->window, this->window + this->windowSize);
+	}
+
+	float avg() const {
+		if (this->windowSize == 0)
+			return 0.0f;
+		float sum = 0.0f;
+		for (int i = 0; i < this->windowSize; ++i) {
+			sum += this->window[i];
+		}
+		return sum / this->windowSize;
+	}
+
+	float percentile(float p) const {
+		if (this->windowSize == 0)
+			return 0.0f;
+		std::vector<float> sorted(this->window, this->window + this->windowSize);
+		int n = std::min(this->windowSize - 1, (int)(p * this->windowSize));
+		std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+		return sorted[n];
+	}
+};
+
+struct ProfileTraceEvent {
+	const char *name;
+	const char *category;
+	// 'X' zone, 'C' counter
+	char phase;
+	unsigned int tid;
+	// microseconds since the profiler creation
+	double ts;
+	double dur;
+	long value;
+};
+
+// counter ids at most, one per counter name
+#define PROFILER_MAX_COUNTERS 64
+
+// zones and counter changes of one thread, merged into the profiler by flush()
+// its lock is only shared with flush, so threads recording events do not wait on each other
+struct ProfileThreadBuffer {
+	struct ZoneEvent {
+		unsigned int id;
+		double start;
+		double end;
+	};
+
+	std::mutex mutex;
+	unsigned int tid;
+	// owned by a running thread
+	bool used;
+	std::vector<ZoneEvent> zones;
+	std::vector<ProfileTraceEvent> counterEvents;
+};
+
+// scoped timing zones and counters, shared by every system and worker thread
+// zones are buffered per thread and counters are atomics, both are merged at frame end by flush()
+class Profiler {
+	// zones stats, trace and registrations
+	std::mutex mutex;
+	std::chrono::steady_clock::time_point origin;
+	std::vector<std::unique_ptr<ProfileThreadBuffer>> buffers;
+	std::vector<ProfileTraceEvent> events;
+	// indexed by zone id, ids are interned once per name
+	std::map<std::string, unsigned int> zoneIds;
+	std::vector<const char *> zoneNames;
+	std::vector<const char *> zoneCategories;
+	std::vector<ProfileZoneStats> zones;
+	// indexed by counter id, ids are interned once per name
+	std::map<std::string, unsigned int> counterIds;
+	std::vector<const char *> counterNames;
+	std::atomic<long> counters[PROFILER_MAX_COUNTERS];
+	std::atomic<bool> countersUsed[PROFILER_MAX_COUNTERS];
+
+	// releases the buffer of a thread when it ends
+	struct ThreadSlot {
+		ProfileThreadBuffer *buffer;
+
+		ThreadSlot() {
+			this->buffer = nullptr;
+		}
+
+		~ThreadSlot() {
+			if (this->buffer)
+				Profiler::get().releaseBuffer(this->buffer);
+		}
+	};
+
+	Profiler() {
+		this->origin = std::chrono::steady_clock::now();
+		this->enabled = true;
+		this->tracing = false;
+		for (int i = 0; i < PROFILER_MAX_COUNTERS; ++i) {
+			this->counters[i] = 0;
+			this->countersUsed[i] = false;
+		}
+	}
+
+public:
+	std::atomic<bool> enabled;
+	// keep every zone and counter change as trace event
+	std::atomic<bool> tracing;
+
+	static Profiler &get() {
+		static Profiler profiler;
+		return profiler;
+	}
+
+	double now() {
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - this->origin).count();
+	}
+
+	// id of a zone name, zones of the same name share their stats
+	unsigned int zoneId(const char *name, const char *category) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		auto it = this->zoneIds.find(name);
+		if (it != this->zoneIds.end())
+			return it->second;
+		unsigned int id = this->zones.size();
+		this->zoneIds[name] = id;
+		this->zoneNames.push_back(name);
+		this->zoneCategories.push_back(category);
+		this->zones.push_back(ProfileZoneStats());
+		this->zones[id].category = category;
+		return id;
+	}
+
+	// id of a counter name, past PROFILER_MAX_COUNTERS names share the last id
+	unsigned int counterId(const char *name) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		auto it = this->counterIds.find(name);
+		if (it != this->counterIds.end())
+			return it->second;
+		if (this->counterNames.size() == PROFILER_MAX_COUNTERS) {
+			std::cerr << "WARNING: too many profiler counters, " << name << " is counted as " << this->counterNames.back() << std::endl;
+			return PROFILER_MAX_COUNTERS - 1;
+		}
+		unsigned int id = this->counterNames.size();
+		this->counterIds[name] = id;
+		this->counterNames.push_back(name);
+		return id;
+	}
+
+	// start and end in microseconds from now(), kept in the thread buffer until flush
+	void zone(unsigned int id, double start, double end) {
+		ProfileThreadBuffer &buffer = this->threadBuffer();
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		buffer.zones.push_back(ProfileThreadBuffer::ZoneEvent{id, start, end});
+	}
+
+	// add to a running count, as requests or builds
+	void count(unsigned int id, long n = 1) {
+		long value = this->counters[id].fetch_add(n, std::memory_order_relaxed) + n;
+		if (!this->countersUsed[id].load(std::memory_order_relaxed))
+			this->countersUsed[id] = true;
+
+		if (this->tracing)
+			this->traceCounter(id, value);
+	}
+
+	// set a sampled value, as draw calls of the last frame
+	void setCount(unsigned int id, long value) {
+		this->counters[id].store(value, std::memory_order_relaxed);
+		if (!this->countersUsed[id].load(std::memory_order_relaxed))
+			this->countersUsed[id] = true;
+
+		if (this->tracing)
+			this->traceCounter(id, value);
+	}
+
+	// merge the zones buffered by every thread, once per frame
+	void flush() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+	}
+
+	// copies of the zones called at least once, zones and counters may change from worker threads
+	std::map<std::string, ProfileZoneStats> zoneStats() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+		std::map<std::string, ProfileZoneStats> stats;
+		for (unsigned int id = 0; id < this->zones.size(); ++id) {
+			if (this->zones[id].calls > 0)
+				stats[this->zoneNames[id]] = this->zones[id];
+		}
+		return stats;
+	}
+
+	std::map<std::string, long> counterValues() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		std::map<std::string, long> values;
+		for (unsigned int id = 0; id < this->counterNames.size(); ++id) {
+			if (this->countersUsed[id])
+				values[this->counterNames[id]] = this->counters[id];
+		}
+		return values;
+	}
+
+	void startTrace() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+		this->events.clear();
+		this->tracing = true;
+	}
+
+	void stopTrace() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+		this->tracing = false;
+	}
+
+	size_t traceSize() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+		return this->events.size();
+	}
+
+	// chrome://tracing or perfetto JSON
+	void writeTrace(std::ostream &out) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+		out << "{\"traceEvents\":[";
+		for (size_t i = 0; i < this->events.size(); ++i) {
+			ProfileTraceEvent &event = this->events[i];
+			out << (i > 0 ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+			    << "\",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << event.tid << ",\"ts\":" << std::fixed << event.ts;
+			if (event.phase == 'X')
+				out << ",\"dur\":" << event.dur;
+			else
+				out << ",\"args\":{\"value\":" << event.value << "}";
+			out << "}";
+		}
+		out << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+		out.unsetf(std::ios_base::floatfield);
+	}
+
+	bool writeTrace(std::string filename) {
+		std::ofstream file(filename);
+		if (!file) {
+			std::cerr << "ERROR: cannot write trace " << filename << std::endl;
+			return false;
+		}
+		this->writeTrace(file);
+		return true;
+	}
+
+	// zone and counter ids stay valid, only their stats are cleared
+	void reset() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->merge();
+		for (ProfileZoneStats &stats : this->zones) {
+			std::string category = stats.category;
+			stats = ProfileZoneStats();
+			stats.category = category;
+		}
+		for (int i = 0; i < PROFILER_MAX_COUNTERS; ++i) {
+			this->counters[i] = 0;
+			this->countersUsed[i] = false;
+		}
+		this->events.clear();
+	}
+
+private:
+	ProfileThreadBuffer &threadBuffer() {
+		thread_local ThreadSlot slot;
+		if (!slot.buffer)
+			slot.buffer = this->acquireBuffer();
+		return *slot.buffer;
+	}
+
+	// buffers of ended threads are reused
+	ProfileThreadBuffer *acquireBuffer() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		for (std::unique_ptr<ProfileThreadBuffer> &buffer : this->buffers) {
+			if (!buffer->used) {
+				buffer->used = true;
+				return buffer.get();
+			}
+		}
+		this->buffers.push_back(std::unique_ptr<ProfileThreadBuffer>(new ProfileThreadBuffer()));
+		ProfileThreadBuffer *buffer = this->buffers.back().get();
+		buffer->tid = this->buffers.size();
+		buffer->used = true;
+		return buffer;
+	}
+
+	void releaseBuffer(ProfileThreadBuffer *buffer) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		buffer->used = false;
+	}
+
+	void traceCounter(unsigned int id, long value) {
+		ProfileThreadBuffer &buffer = this->threadBuffer();
+		std::lock_guard<std::mutex> lock(buffer.mutex);
+		buffer.counterEvents.push_back(ProfileTraceEvent{this->counterNames[id], "counter", 'C', buffer.tid, this->now(), 0, value});
+	}
+
+	// with the profiler mutex held
+	void merge() {
+		std::vector<ProfileThreadBuffer::ZoneEvent> zoneEvents;
+		std::vector<ProfileTraceEvent> counterEvents;
+		for (std::unique_ptr<ProfileThreadBuffer> &buffer : this->buffers) {
+			{
+				std::lock_guard<std::mutex> lock(buffer->mutex);
+				zoneEvents.swap(buffer->zones);
+				counterEvents.swap(buffer->counterEvents);
+			}
+
+			for (ProfileThreadBuffer::ZoneEvent const &event : zoneEvents) {
+				this->zones[event.id].add((event.end - event.start) / 1000.0);
+				if (this->tracing)
+					this->trace(ProfileTraceEvent{this->zoneNames[event.id], this->zoneCategories[event.id], 'X', buffer->tid, event.start, event.end - event.start, 0});
+			}
+			for (ProfileTraceEvent const &event : counterEvents) {
+				if (this->tracing)
+					this->trace(event);
+			}
+			zoneEvents.clear();
+			counterEvents.clear();
+		}
+	}
+
+	void trace(const ProfileTraceEvent &event) {
+		if (this->events.size() < PROFILER_MAX_TRACE_EVENTS)
+			this->events.push_back(event);
+		else
+			this->tracing = false;
+	}
+};
+
+// zone id interned once per call site
+class ProfileZoneSite {
+public:
+	unsigned int id;
+
+	ProfileZoneSite(const char *name, const char *category) {
+		this->id = Profiler::get().zoneId(name, category);
+	}
+};
+
+// static site of a zone, name and category must be string literals
+#define PROFILE_SITE(name, category) ([]() -> const ProfileZoneSite & { static const ProfileZoneSite site(name, category); return site; }())
+
+// counter id interned once per call site
+class ProfileCounterSite {
+public:
+	unsigned int id;
+
+	ProfileCounterSite(const char *name) {
+		this->id = Profiler::get().counterId(name);
+	}
+};
+
+// static site of a counter, name must be a string literal, as Profiler::get().count(PROFILE_COUNTER("path requests"))
+#define PROFILE_COUNTER(name) ([]() -> unsigned int { static const ProfileCounterSite site(name); return site.id; }())
+
+// times its scope, as ProfileZone zone(PROFILE_SITE("tick", "engine"))
+class ProfileZone {
+	unsigned int id;
+	double start;
+
+public:
+	ProfileZone(const ProfileZoneSite &site) : id(site.id) {
+		Profiler &profiler = Profiler::get();
+		this->start = profiler.enabled ? profiler.now() : -1.0;
+	}
+
+	~ProfileZone() {
+		if (this->start >= 0.0) {
+			Profiler &profiler = Profiler::get();
+			profiler.zone(this->id, this->start, profiler.now());
+		}
+	}
+};
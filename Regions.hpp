@@ -0,0 +1,297 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <limits>
+
+#include "Config.hpp"
+#include "Helpers.hpp"
+#include "SectorGraph.hpp"
+
+// no walkable cell of the region within this distance, give up the destination
+#define REGION_MAX_REDIRECT 32
+
+// connected walkable regions labelling
+// JPS only moves diagonally if an orthogonal neighbour is free, so 4-connectivity gives the same regions
+// cells keep the label they got when last flooded, labels of joined regions are merged by union-find
+class RegionLabels {
+	std::vector<unsigned int> labels;
+	// union-find of labels, a region is its root label, flattened after each update
+	std::vector<unsigned int> parents;
+	// flood fill stamp, avoid clearing a visited array on each relabel
+	std::vector<unsigned int> stamps;
+	std::vector<unsigned int> stack;
+	unsigned int stamp;
+	// components of the window before and after the change, 0 if not walkable
+	std::vector<int> oldComps;
+	std::vector<int> newComps;
+
+public:
+	int width;
+	int height;
+	// regions flooded again because a change may have split them
+	unsigned long splits;
+
+	RegionLabels() {
+		this->width = 0;
+		this->height = 0;
+		this->stamp = 0;
+		this->splits = 0;
+	}
+
+	// 0 if not walkable
+	inline unsigned int get(int x, int y) const {
+		if (x >= 0 && y >= 0 && x < this->width && y < this->height)
+			return this->parents[this->labels[x + y * this->width]];
+		return 0;
+	}
+
+	inline unsigned int get(sf::Vector2i p) const {
+		return this->get(p.x, p.y);
+	}
+
+	inline bool sameRegion(sf::Vector2i a, sf::Vector2i b) const {
+		unsigned int label = this->get(a);
+		return label != 0 && label == this->get(b);
+	}
+
+	// false only if no search from a to b can succeed, from an obstacle the search decides
+	inline bool mayReach(sf::Vector2i a, sf::Vector2i b) const {
+		unsigned int label = this->get(a);
+		return label == 0 || label == this->get(b);
+	}
+
+	template <typename GRID>
+	void build(const GRID &grid, int width, int height) {
+		this->width = width;
+		this->height = height;
+		this->labels.assign(width * height, 0);
+		this->stamps.assign(width * height, 0);
+		this->stamp = 1;
+		this->parents.assign(1, 0);
+
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				int idx = x + y * width;
+				if (this->stamps[idx] != this->stamp && grid(x, y))
+					this->fill(grid, idx, this->newLabel());
+			}
+		}
+	}
+
+	// relabel the sectors around the changed rect, regions outside the window are only merged through it
+	// two cells of a region outside the window stay connected if the path between them through the window still exists,
+	// so a region is only flooded again when window cells it was connected through are not connected anymore
+	template <typename GRID>
+	void update(const GRID &grid, sf::IntRect rect) {
+		// labels are never reused
+		if (this->parents.size() > (size_t)(this->width * this->height)) {
+			this->build(grid, this->width, this->height);
+			return;
+		}
+
+		// whole sectors around the rect and its border
+		int left = std::max(0, rect.left - 1) / PER_SECTOR * PER_SECTOR;
+		int top = std::max(0, rect.top - 1) / PER_SECTOR * PER_SECTOR;
+		int right = std::min(this->width, (std::min(this->width - 1, rect.left + rect.width) / PER_SECTOR + 1) * PER_SECTOR);
+		int bottom = std::min(this->height, (std::min(this->height - 1, rect.top + rect.height) / PER_SECTOR + 1) * PER_SECTOR);
+		sf::IntRect window(left, top, right - left, bottom - top);
+
+		// cells labelled before the change were walkable
+		int oldCount = this->windowComponents(window, [this](int x, int y) {
+			return this->labels[x + y * this->width] != 0;
+		}, this->oldComps);
+		int newCount = this->windowComponents(window, [&grid](int x, int y) {
+			return (bool)grid(x, y);
+		}, this->newComps);
+
+		std::vector<unsigned int> compLabels(newCount + 1, 0);
+		for (int c = 1; c <= newCount; ++c) {
+			compLabels[c] = this->newLabel();
+		}
+
+		// new component next to the border cells of each old component, -1 if none yet
+		std::vector<int> joined(oldCount + 1, -1);
+		// old components whose border cells are not connected through the window anymore
+		std::vector<bool> cut(oldCount + 1, false);
+		// old component and index of the cells outside the window next to it
+		std::vector<std::pair<int, int>> borders;
+
+		auto attach = [&](int wx, int wy, int bx, int by) {
+			if (bx < 0 || by < 0 || bx >= this->width || by >= this->height)
+				return;
+			// cells outside the window did not change
+			unsigned int outside = this->labels[bx + by * this->width];
+			if (outside == 0)
+				return;
+			int local = (wx - window.left) + (wy - window.top) * window.width;
+			int oldComp = this->oldComps[local];
+			int newComp = this->newComps[local];
+			if (newComp)
+				this->unite(compLabels[newComp], outside);
+			if (oldComp) {
+				if (joined[oldComp] == -1)
+					joined[oldComp] = newComp;
+				else if (joined[oldComp] != newComp || newComp == 0)
+					cut[oldComp] = true;
+				borders.push_back(std::make_pair(oldComp, bx + by * this->width));
+			}
+		};
+
+		for (int x = left; x < right; ++x) {
+			attach(x, top, x, top - 1);
+			attach(x, bottom - 1, x, bottom);
+		}
+		for (int y = top; y < bottom; ++y) {
+			attach(left, y, left - 1, y);
+			attach(right - 1, y, right, y);
+		}
+
+		for (int y = top; y < bottom; ++y) {
+			for (int x = left; x < right; ++x) {
+				this->labels[x + y * this->width] = compLabels[this->newComps[(x - left) + (y - top) * window.width]];
+			}
+		}
+
+		// the region may be split, flood from its border cells, each piece gets its own label
+		this->nextStamp();
+		for (std::pair<int, int> const &border : borders) {
+			if (cut[border.first] && this->stamps[border.second] != this->stamp) {
+				this->fill(grid, border.second, this->newLabel());
+				this->splits++;
+			}
+		}
+
+		// roots are older than their labels, so parents are flattened first
+		for (size_t label = 1; label < this->parents.size(); ++label) {
+			this->parents[label] = this->parents[this->parents[label]];
+		}
+
+#ifdef PATHFINDING_DEBUG
+		std::cout << "RegionLabels: relabel " << window.left << "x" << window.top << " " << window.width << "x" << window.height << ", " << this->parents.size() << " labels, " << this->splits << " splits" << std::endl;
+#endif
+	}
+
+	// nearest cell of region from pos, pos itself if none within maxDist
+	sf::Vector2i nearest(unsigned int label, sf::Vector2i pos, int maxDist) const {
+		if (this->get(pos) == label)
+			return pos;
+
+		for (int dist = 1; dist <= maxDist; ++dist) {
+			sf::Vector2i best = pos;
+			int bestDist = std::numeric_limits<int>::max();
+			for (int w = -dist; w < dist + 1; ++w) {
+				for (int h = -dist; h < dist + 1; ++h) {
+					if (w == -dist || h == -dist || w == dist || h == dist) {
+						// prefer the closest cell of the ring
+						int d = w * w + h * h;
+						if (d < bestDist && this->get(pos.x + w, pos.y + h) == label) {
+							bestDist = d;
+							best = sf::Vector2i(pos.x + w, pos.y + h);
+						}
+					}
+				}
+			}
+			if (best != pos)
+				return best;
+		}
+		return pos;
+	}
+
+private:
+	unsigned int newLabel() {
+		unsigned int label = this->parents.size();
+		this->parents.push_back(label);
+		return label;
+	}
+
+	unsigned int find(unsigned int label) {
+		while (this->parents[label] != label) {
+			this->parents[label] = this->parents[this->parents[label]];
+			label = this->parents[label];
+		}
+		return label;
+	}
+
+	// the oldest label stays the root
+	void unite(unsigned int a, unsigned int b) {
+		a = this->find(a);
+		b = this->find(b);
+		if (a < b)
+			this->parents[b] = a;
+		else if (b < a)
+			this->parents[a] = b;
+	}
+
+	// 4-connected components of the window cells, numbered from 1 in comps
+	template <typename WALKABLE>
+	int windowComponents(sf::IntRect window, WALKABLE walkable, std::vector<int> &comps) {
+		comps.assign(window.width * window.height, 0);
+		int count = 0;
+		for (int i = 0; i < (int)comps.size(); ++i) {
+			if (comps[i] || !walkable(window.left + i % window.width, window.top + i / window.width))
+				continue;
+			count++;
+			comps[i] = count;
+			this->stack.clear();
+			this->stack.push_back(i);
+			while (this->stack.size() > 0) {
+				int cur = this->stack.back();
+				this->stack.pop_back();
+				int x = cur % window.width;
+				int y = cur / window.width;
+				const int dirs[4][2] = {{ -1, 0}, {1, 0}, {0, -1}, {0, 1}};
+				for (int d = 0; d < 4; ++d) {
+					int nx = x + dirs[d][0];
+					int ny = y + dirs[d][1];
+					int next = nx + ny * window.width;
+					if (nx >= 0 && ny >= 0 && nx < window.width && ny < window.height && !comps[next] && walkable(window.left + nx, window.top + ny)) {
+						comps[next] = count;
+						this->stack.push_back(next);
+					}
+				}
+			}
+		}
+		return count;
+	}
+
+	void nextStamp() {
+		this->stamp++;
+		if (this->stamp == 0) {
+			std::fill(this->stamps.begin(), this->stamps.end(), 0);
+			this->stamp = 1;
+		}
+	}
+
+	template <typename GRID>
+	void fill(const GRID &grid, int idx, unsigned int label) {
+		this->stack.clear();
+		this->stack.push_back(idx);
+		this->stamps[idx] = this->stamp;
+
+		while (this->stack.size() > 0) {
+			int cur = this->stack.back();
+			this->stack.pop_back();
+			this->labels[cur] = label;
+
+			int x = cur % this->width;
+			int y = cur / this->width;
+
+			this->push(grid, x - 1, y);
+			this->push(grid, x + 1, y);
+			this->push(grid, x, y - 1);
+			this->push(grid, x, y + 1);
+		}
+	}
+
+	template <typename GRID>
+	inline void push(const GRID &grid, int x, int y) {
+		if (x < 0 || y < 0 || x >= this->width || y >= this->height)
+			return;
+		int idx = x + y * this->width;
+		if (this->stamps[idx] != this->stamp && grid(x, y)) {
+			this->stamps[idx] = this->stamp;
+			this->stack.push_back(idx);
+		}
+	}
+};
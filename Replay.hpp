@@ -0,0 +1,190 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cctype>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "Entity.hpp"
+
+#define REPLAY_VERSION 1
+
+// everything a match is generated from
+struct MatchSettings {
+	unsigned int mapWidth;
+	unsigned int mapHeight;
+	std::string playerTeam;
+	// neutral player only, rebel and neonaz twice if empty
+	std::vector<std::string> aiTeams;
+	unsigned int seed;
+	// scenario file placing the players objects, map, seed and AI teams come from it, none if empty
+	std::string scenario;
+
+	MatchSettings() {
+		this->mapWidth = 64;
+		this->mapHeight = 64;
+		this->playerTeam = "neutral";
+		this->seed = 0;
+	}
+
+	void write(std::ostream &out) const {
+		out << "map " << this->mapWidth << " " << this->mapHeight << std::endl;
+		out << "seed " << this->seed << std::endl;
+		out << "player " << this->playerTeam << std::endl;
+		if (this->scenario.size() > 0)
+			out << "scenario " << this->scenario << std::endl;
+		out << "ai";
+		for (std::string const &team : this->aiTeams) {
+			out << " " << team;
+		}
+		out << std::endl;
+	}
+
+	// settings line, false if key is not a setting
+	bool read(const std::string &key, std::istream &in) {
+		if (key == "map") {
+			in >> this->mapWidth >> this->mapHeight;
+		} else if (key == "seed") {
+			in >> this->seed;
+		} else if (key == "player") {
+			in >> this->playerTeam;
+		} else if (key == "scenario") {
+			in >> this->scenario;
+		} else if (key == "ai") {
+			this->aiTeams.clear();
+			std::string team;
+			while (in >> team)
+				this->aiTeams.push_back(team);
+		} else {
+			return false;
+		}
+		return true;
+	}
+};
+
+enum class CommandType {
+	Move,
+	Attack,
+	AttackOrMove,
+	Build, // start a construction in a building, or the root construction
+	CancelBuild,
+	Preview, // finished construction waiting to be placed
+	CancelPreview,
+	Place,
+	Train,
+	Seed
+};
+
+static const char *commandTypeNames[] = {
+	"move",
+	"attack",
+	"attack_or_move",
+	"build",
+	"cancel_build",
+	"preview",
+	"cancel_preview",
+	"place",
+	"train",
+	"seed"
+};
+
+// player order, applied at the start of a simulation step
+struct Command {
+	unsigned long step;
+	CommandType type;
+	EntityID player;
+	// game object serials, units ordered or the building concerned
+	std::vector<unsigned long> objs;
+	sf::Vector2i pos;
+	std::string name;
+};
+
+// match settings and commands, one text line per command
+// <step> <type> <player> <x> <y> <name or -> <objs count> <objs serials...>
+class Replay {
+public:
+	MatchSettings settings;
+	std::vector<Command> commands;
+
+	bool load(std::string filename) {
+		std::ifstream file(filename);
+		if (!file) {
+			std::cerr << "ERROR: cannot read replay " << filename << std::endl;
+			return false;
+		}
+
+		std::string magic;
+		int version;
+		file >> magic >> version;
+		if (magic != "bfr_replay" || version != REPLAY_VERSION) {
+			std::cerr << "ERROR: " << filename << " is not a version " << REPLAY_VERSION << " replay" << std::endl;
+			return false;
+		}
+
+		this->commands.clear();
+
+		std::string line;
+		while (std::getline(file, line)) {
+			std::istringstream in(line);
+			std::string key;
+			if (!(in >> key))
+				continue;
+
+			if (this->settings.read(key, in)) {
+				continue;
+			} else if (isdigit(key[0])) {
+				Command command;
+				std::string type;
+				unsigned long count;
+				command.step = std::stoul(key);
+				in >> type >> command.player >> command.pos.x >> command.pos.y >> command.name >> count;
+				if (!in || !this->parseType(type, command.type)) {
+					std::cerr << "ERROR: invalid replay command " << line << std::endl;
+					return false;
+				}
+				if (command.name == "-")
+					command.name = "";
+				for (unsigned long i = 0; i < count; ++i) {
+					unsigned long serial;
+					in >> serial;
+					command.objs.push_back(serial);
+				}
+				this->commands.push_back(command);
+			} else {
+				std::cerr << "ERROR: unknown replay line " << line << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void writeSettings(std::ostream &out, const MatchSettings &settings) {
+		out << "bfr_replay " << REPLAY_VERSION << std::endl;
+		settings.write(out);
+	}
+
+	static void writeCommand(std::ostream &out, const Command &command) {
+		out << command.step << " " << commandTypeNames[(int)command.type] << " " << command.player
+		    << " " << command.pos.x << " " << command.pos.y << " " << (command.name.size() > 0 ? command.name : "-")
+		    << " " << command.objs.size();
+		for (unsigned long serial : command.objs) {
+			out << " " << serial;
+		}
+		out << std::endl;
+	}
+
+private:
+	bool parseType(std::string name, CommandType &type) {
+		for (int i = 0; i <= (int)CommandType::Seed; ++i) {
+			if (name == commandTypeNames[i]) {
+				type = (CommandType)i;
+				return true;
+			}
+		}
+		return false;
+	}
+};
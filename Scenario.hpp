@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <SFML/System.hpp>
+
+#include "third_party/tinyxml2.h"
+#include "third_party/tixml2ex.h"
+
+#include "Replay.hpp"
+
+// players in a scenario, their starting position is a corner when not given
+#define SCENARIO_MAX_PLAYERS 8
+#define SCENARIO_CORNER_PLAYERS 4
+
+// order given to the units of a group once every system is initialized
+struct ScenarioOrder {
+	// none if empty, move, attack or attack_or_move
+	std::string type;
+	sf::Vector2i pos;
+};
+
+// units or buildings of the same name placed around the player position
+struct ScenarioGroup {
+	bool building;
+	std::string name;
+	unsigned int count;
+	// count is shared between clusters, each centered at most spread tiles away from the player position
+	unsigned int clusters;
+	int spread;
+	ScenarioOrder order;
+};
+
+struct ScenarioPlayer {
+	std::string team;
+	// corner position if unset
+	bool hasPos;
+	sf::Vector2i pos;
+	std::vector<ScenarioGroup> groups;
+};
+
+// map, seed and players with their units, buildings and orders, as in scenarios/stress_500.xml
+// <scenario width="96" height="96" seed="1">
+//   <player team="rebel" x="12" y="12">
+//     <units name="zork" count="250" clusters="5" spread="10"><order type="attack_or_move" x="84" y="84"/></units>
+//     <buildings name="taverne" count="1"/>
+//   </player>
+// </scenario>
+class Scenario {
+public:
+	unsigned int mapWidth;
+	unsigned int mapHeight;
+	unsigned int seed;
+	std::vector<ScenarioPlayer> players;
+
+	Scenario() {
+		this->mapWidth = 64;
+		this->mapHeight = 64;
+		this->seed = 0;
+	}
+
+	bool load(std::string filename) {
+		tinyxml2::XMLDocument doc;
+		if (doc.LoadFile(filename.c_str()) != tinyxml2::XML_SUCCESS || !doc.RootElement()
+		        || std::string(doc.RootElement()->Name()) != "scenario") {
+			std::cerr << "ERROR: cannot read scenario " << filename << std::endl;
+			return false;
+		}
+
+		tinyxml2::XMLElement *root = doc.RootElement();
+		this->mapWidth = root->UnsignedAttribute("width", 64);
+		this->mapHeight = root->UnsignedAttribute("height", 64);
+		this->seed = root->UnsignedAttribute("seed", 0);
+		this->players.clear();
+
+		if (this->mapWidth < 32 || this->mapHeight < 32) {
+			std::cerr << "ERROR: scenario " << filename << " map must be at least 32x32" << std::endl;
+			return false;
+		}
+
+		for (tinyxml2::XMLElement *playerEl : root) {
+			ScenarioPlayer player;
+			player.team = playerEl->Attribute("team") ? playerEl->Attribute("team") : "";
+			if (std::string(playerEl->Name()) != "player" || (player.team != "rebel" && player.team != "neonaz")) {
+				std::cerr << "ERROR: scenario " << filename << " expects players of team rebel or neonaz" << std::endl;
+				return false;
+			}
+			player.hasPos = playerEl->Attribute("x") && playerEl->Attribute("y");
+			player.pos = sf::Vector2i(playerEl->IntAttribute("x"), playerEl->IntAttribute("y"));
+			if (player.hasPos && (player.pos.x < 0 || player.pos.y < 0 || player.pos.x >= (int)this->mapWidth || player.pos.y >= (int)this->mapHeight)) {
+				std::cerr << "ERROR: scenario " << filename << " player position out of map" << std::endl;
+				return false;
+			}
+
+			for (tinyxml2::XMLElement *groupEl : playerEl) {
+				ScenarioGroup group;
+				std::string element = groupEl->Name();
+				if ((element != "units" && element != "buildings") || !groupEl->Attribute("name")) {
+					std::cerr << "ERROR: scenario " << filename << " expects named units or buildings" << std::endl;
+					return false;
+				}
+				group.building = element == "buildings";
+				group.name = groupEl->Attribute("name");
+				group.count = groupEl->UnsignedAttribute("count", 1);
+				group.clusters = std::max(1u, groupEl->UnsignedAttribute("clusters", 1));
+				group.spread = std::max(0, groupEl->IntAttribute("spread", 0));
+
+				tinyxml2::XMLElement *orderEl = groupEl->FirstChildElement("order");
+				if (orderEl) {
+					group.order.type = orderEl->Attribute("type") ? orderEl->Attribute("type") : "";
+					group.order.pos = sf::Vector2i(orderEl->IntAttribute("x"), orderEl->IntAttribute("y"));
+					if (group.order.type != "move" && group.order.type != "attack" && group.order.type != "attack_or_move") {
+						std::cerr << "ERROR: scenario " << filename << " unknown order " << group.order.type << std::endl;
+						return false;
+					}
+				}
+				player.groups.push_back(group);
+			}
+			this->players.push_back(player);
+		}
+
+		if (this->players.size() == 0 || this->players.size() > SCENARIO_MAX_PLAYERS) {
+			std::cerr << "ERROR: scenario " << filename << " expects 1 to " << SCENARIO_MAX_PLAYERS << " players" << std::endl;
+			return false;
+		}
+		int corners = 0;
+		for (ScenarioPlayer const &player : this->players) {
+			if (!player.hasPos)
+				corners++;
+		}
+		if (corners > SCENARIO_CORNER_PLAYERS) {
+			std::cerr << "ERROR: scenario " << filename << " players past the fourth need a position" << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	// map, seed and AI teams of the scenario, the scenario file is kept to be loaded again by the generator
+	void apply(MatchSettings &settings, std::string filename) const {
+		settings.scenario = filename;
+		settings.mapWidth = this->mapWidth;
+		settings.mapHeight = this->mapHeight;
+		settings.seed = this->seed;
+		settings.aiTeams.clear();
+		for (ScenarioPlayer const &player : this->players) {
+			settings.aiTeams.push_back(player.team);
+		}
+	}
+};
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <queue>
+#include <functional>
+#include <memory>
+#include <cstdlib>
+
+#include "Config.hpp"
+#include "Helpers.hpp"
+
+#define PER_SECTOR 12
+
+// same straight/diagonal ratio than JPS
+#define SECTOR_STRAIGHT_COST 10
+#define SECTOR_DIAGONAL_COST 14
+
+// entrances longer than this get a portal on each end instead of one in the middle
+#define SECTOR_LONG_ENTRANCE 6
+
+struct SectorPortal {
+	sf::Vector2i pos; // entrance cell inside the sector
+	sf::Vector2i twin; // matching entrance cell in the neighbour sector
+};
+
+struct Sector {
+	sf::IntRect rect;
+	std::vector<SectorPortal> portals;
+	// portals x portals costs inside the sector, -1 if not connected
+	std::vector<int> costs;
+};
+
+// HPA* like abstract graph
+// the map is cut into PER_SECTOR x PER_SECTOR sectors, connected by portals on their borders
+// long paths are searched on portals only, legs between portals are refined later with JPS
+// sectors are immutable once built, copies of the graph share them and a rebuild replaces the changed ones only
+class SectorGraph {
+	std::vector<std::shared_ptr<const Sector>> sectors;
+	std::set<int> dirtySectors;
+
+public:
+	// sectors count
+	int width;
+	int height;
+
+	int mapWidth;
+	int mapHeight;
+
+	SectorGraph() {
+		this->width = 0;
+		this->height = 0;
+		this->mapWidth = 0;
+		this->mapHeight = 0;
+	}
+
+	inline int sectorIndex(int x, int y) const {
+		return (x / PER_SECTOR) + (y / PER_SECTOR) * this->width;
+	}
+
+	inline sf::Vector2i sectorPos(int x, int y) const {
+		return sf::Vector2i(x / PER_SECTOR, y / PER_SECTOR);
+	}
+
+	// distance in sectors (chebyshev)
+	int sectorDistance(sf::Vector2i a, sf::Vector2i b) const {
+		sf::Vector2i sa = this->sectorPos(a.x, a.y);
+		sf::Vector2i sb = this->sectorPos(b.x, b.y);
+		return std::max(abs(sa.x - sb.x), abs(sa.y - sb.y));
+	}
+
+	const Sector &getSector(int idx) const {
+		return *this->sectors[idx];
+	}
+
+	int size() const {
+		return this->sectors.size();
+	}
+
+	void markDirty(int x, int y) {
+		if (x >= 0 && y >= 0 && x < this->mapWidth && y < this->mapHeight)
+			this->dirtySectors.insert(this->sectorIndex(x, y));
+	}
+
+	void markDirty(sf::IntRect rect) {
+		int left = std::max(0, rect.left);
+		int top = std::max(0, rect.top);
+		int right = std::min(this->mapWidth - 1, rect.left + rect.width - 1);
+		int bottom = std::min(this->mapHeight - 1, rect.top + rect.height - 1);
+		for (int sy = top / PER_SECTOR; sy <= bottom / PER_SECTOR; ++sy) {
+			for (int sx = left / PER_SECTOR; sx <= right / PER_SECTOR; ++sx) {
+				this->dirtySectors.insert(sx + sy * this->width);
+			}
+		}
+	}
+
+	bool isDirty() const {
+		return this->dirtySectors.size() > 0;
+	}
+
+	template <typename GRID>
+	void build(const GRID &grid, int mapWidth, int mapHeight) {
+		this->mapWidth = mapWidth;
+		this->mapHeight = mapHeight;
+		this->width = (mapWidth + PER_SECTOR - 1) / PER_SECTOR;
+		this->height = (mapHeight + PER_SECTOR - 1) / PER_SECTOR;
+
+		this->sectors.clear();
+		this->dirtySectors.clear();
+		for (int sy = 0; sy < this->height; ++sy) {
+			for (int sx = 0; sx < this->width; ++sx) {
+				std::shared_ptr<Sector> sector = std::make_shared<Sector>();
+				sector->rect = sf::IntRect(sx * PER_SECTOR, sy * PER_SECTOR,
+				                          std::min(PER_SECTOR, mapWidth - sx * PER_SECTOR),
+				                          std::min(PER_SECTOR, mapHeight - sy * PER_SECTOR));
+				this->sectors.push_back(sector);
+			}
+		}
+
+		for (int i = 0; i < this->sectors.size(); ++i) {
+			this->rebuildSector(grid, i);
+		}
+	}
+
+	// rebuild dirty sectors only, neighbours are rebuilt too since they share border portals
+	template <typename GRID>
+	void update(const GRID &grid) {
+		std::set<int> rebuild;
+		for (int idx : this->dirtySectors) {
+			int sx = idx % this->width;
+			int sy = idx / this->width;
+			rebuild.insert(idx);
+			if (sx > 0)
+				rebuild.insert(idx - 1);
+			if (sx < this->width - 1)
+				rebuild.insert(idx + 1);
+			if (sy > 0)
+				rebuild.insert(idx - this->width);
+			if (sy < this->height - 1)
+				rebuild.insert(idx + this->width);
+		}
+
+#ifdef PATHFINDING_DEBUG
+		std::cout << "SectorGraph: rebuild " << rebuild.size() << " sectors" << std::endl;
+#endif
+
+		for (int idx : rebuild) {
+			this->rebuildSector(grid, idx);
+		}
+		this->dirtySectors.clear();
+	}
+
+	// search portals path from start to goal, waypoints do not include start
+	// steps is the number of abstract nodes expanded
+	template <typename GRID>
+	bool findPath(const GRID &grid, std::list<sf::Vector2i> &waypoints, sf::Vector2i start, sf::Vector2i goal, unsigned int &steps) const {
+		steps = 0;
+
+		if (!grid(start.x, start.y) || !grid(goal.x, goal.y))
+			return false;
+
+		int startIdx = this->sectorIndex(start.x, start.y);
+		int goalIdx = this->sectorIndex(goal.x, goal.y);
+		const Sector &startSector = *this->sectors[startIdx];
+		const Sector &goalSector = *this->sectors[goalIdx];
+
+		std::vector<int> startCosts;
+		std::vector<int> goalCosts;
+		this->localCosts(grid, startSector.rect, start, startCosts);
+		this->localCosts(grid, goalSector.rect, goal, goalCosts);
+
+		typedef std::pair<int, int> OpenNode; // f, cell index
+		std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> open;
+		std::unordered_map<int, int> gCosts;
+		std::unordered_map<int, int> parents;
+
+		int startCell = this->cellIndex(start);
+		int goalCell = this->cellIndex(goal);
+
+		gCosts[startCell] = 0;
+		parents[startCell] = -1;
+		open.push(OpenNode(this->heuristic(start, goal), startCell));
+
+		while (!open.empty()) {
+			OpenNode cur = open.top();
+			open.pop();
+
+			int cell = cur.second;
+			int g = gCosts[cell];
+			if (cur.first > g + this->heuristic(this->cellPos(cell), goal))
+				continue; // outdated entry
+
+			steps++;
+
+			if (cell == goalCell) {
+				waypoints.clear();
+				while (parents[cell] != -1) {
+					waypoints.push_front(this->cellPos(cell));
+					cell = parents[cell];
+				}
+				return true;
+			}
+
+			sf::Vector2i pos = this->cellPos(cell);
+			int sectorIdx = this->sectorIndex(pos.x, pos.y);
+			const Sector &sector = *this->sectors[sectorIdx];
+
+			std::vector<std::pair<int, int>> edges; // cell index, cost
+
+			if (cell == startCell) {
+				for (const SectorPortal &portal : sector.portals) {
+					int c = startCosts[this->localIndex(sector.rect, portal.pos)];
+					if (c >= 0)
+						edges.push_back(std::make_pair(this->cellIndex(portal.pos), c));
+				}
+				if (startIdx == goalIdx) {
+					int c = startCosts[this->localIndex(sector.rect, goal)];
+					if (c >= 0)
+						edges.push_back(std::make_pair(goalCell, c));
+				}
+			} else if (sectorIdx == goalIdx) {
+				int c = goalCosts[this->localIndex(sector.rect, pos)];
+				if (c >= 0)
+					edges.push_back(std::make_pair(goalCell, c));
+			}
+
+			// a portal cell (start included) leads to its twins and to the other portals of its sector
+			int row = -1;
+			for (int i = 0; i < sector.portals.size(); ++i) {
+				const SectorPortal &portal = sector.portals[i];
+				if (portal.pos == pos) {
+					if (row < 0)
+						row = i;
+					edges.push_back(std::make_pair(this->cellIndex(portal.twin), SECTOR_STRAIGHT_COST));
+				}
+			}
+			if (row >= 0) {
+				for (int i = 0; i < sector.portals.size(); ++i) {
+					int c = sector.costs[row * sector.portals.size() + i];
+					if (c > 0)
+						edges.push_back(std::make_pair(this->cellIndex(sector.portals[i].pos), c));
+				}
+			}
+
+			for (auto &edge : edges) {
+				int ng = g + edge.second;
+				auto it = gCosts.find(edge.first);
+				if (it == gCosts.end() || ng < it->second) {
+					gCosts[edge.first] = ng;
+					parents[edge.first] = cell;
+					open.push(OpenNode(ng + this->heuristic(this->cellPos(edge.first), goal), edge.first));
+				}
+			}
+		}
+
+		return false;
+	}
+
+private:
+	inline int cellIndex(sf::Vector2i p) const {
+		return p.x + p.y * this->mapWidth;
+	}
+
+	inline sf::Vector2i cellPos(int idx) const {
+		return sf::Vector2i(idx % this->mapWidth, idx / this->mapWidth);
+	}
+
+	inline int localIndex(const sf::IntRect &rect, sf::Vector2i p) const {
+		return (p.x - rect.left) + (p.y - rect.top) * rect.width;
+	}
+
+	// octile distance
+	inline int heuristic(sf::Vector2i a, sf::Vector2i b) const {
+		int dx = abs(a.x - b.x);
+		int dy = abs(a.y - b.y);
+		return SECTOR_STRAIGHT_COST * (dx + dy) + (SECTOR_DIAGONAL_COST - 2 * SECTOR_STRAIGHT_COST) * std::min(dx, dy);
+	}
+
+	// dijkstra costs from a cell to every cell of the sector, moves are restricted to the sector
+	template <typename GRID>
+	void localCosts(const GRID &grid, const sf::IntRect &rect, sf::Vector2i from, std::vector<int> &costs) const {
+		costs.assign(rect.width * rect.height, -1);
+		if (!grid(from.x, from.y))
+			return;
+
+		typedef std::pair<int, int> OpenNode; // cost, local index
+		std::priority_queue<OpenNode, std::vector<OpenNode>, std::greater<OpenNode>> open;
+
+		int startIdx = this->localIndex(rect, from);
+		costs[startIdx] = 0;
+		open.push(OpenNode(0, startIdx));
+
+		while (!open.empty()) {
+			OpenNode cur = open.top();
+			open.pop();
+			if (cur.first > costs[cur.second])
+				continue;
+
+			int cx = cur.second % rect.width + rect.left;
+			int cy = cur.second / rect.width + rect.top;
+
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					if (!dx && !dy)
+						continue;
+					int nx = cx + dx;
+					int ny = cy + dy;
+					if (!rect.contains(nx, ny) || !grid(nx, ny))
+						continue;
+
+					int cost = SECTOR_STRAIGHT_COST;
+					if (dx && dy) {
+						// no corner tunneling, like JPS
+						if (!grid(cx + dx, cy) && !grid(cx, cy + dy))
+							continue;
+						cost = SECTOR_DIAGONAL_COST;
+					}
+
+					int nidx = this->localIndex(rect, sf::Vector2i(nx, ny));
+					int ncost = cur.first + cost;
+					if (costs[nidx] < 0 || ncost < costs[nidx]) {
+						costs[nidx] = ncost;
+						open.push(OpenNode(ncost, nidx));
+					}
+				}
+			}
+		}
+	}
+
+	// entrances between two cells lines of neighbour sectors
+	template <typename GRID>
+	void addEntrances(const GRID &grid, Sector &sector, sf::Vector2i from, sf::Vector2i step, sf::Vector2i across, int len) {
+		int runStart = -1;
+		for (int i = 0; i <= len; ++i) {
+			sf::Vector2i p = from + step * i;
+			bool open = i < len && grid(p.x, p.y) && grid(p.x + across.x, p.y + across.y);
+			if (open) {
+				if (runStart < 0)
+					runStart = i;
+			} else if (runStart >= 0) {
+				int runEnd = i - 1;
+				if (runEnd - runStart + 1 < SECTOR_LONG_ENTRANCE) {
+					sf::Vector2i mid = from + step * ((runStart + runEnd) / 2);
+					sector.portals.push_back(SectorPortal{mid, mid + across});
+				} else {
+					sf::Vector2i first = from + step * runStart;
+					sf::Vector2i last = from + step * runEnd;
+					sector.portals.push_back(SectorPortal{first, first + across});
+					sector.portals.push_back(SectorPortal{last, last + across});
+				}
+				runStart = -1;
+			}
+		}
+	}
+
+	// copy on write, graphs sharing the previous sector keep it
+	template <typename GRID>
+	void rebuildSector(const GRID &grid, int idx) {
+		std::shared_ptr<Sector> rebuilt = std::make_shared<Sector>();
+		Sector &sector = *rebuilt;
+		sector.rect = this->sectors[idx]->rect;
+		int sx = idx % this->width;
+		int sy = idx / this->width;
+		const sf::IntRect &r = sector.rect;
+
+		// entrances are computed the same way from both sides, so twins always match
+		if (sx > 0)
+			this->addEntrances(grid, sector, sf::Vector2i(r.left, r.top), sf::Vector2i(0, 1), sf::Vector2i(-1, 0), r.height);
+		if (sx < this->width - 1)
+			this->addEntrances(grid, sector, sf::Vector2i(r.left + r.width - 1, r.top), sf::Vector2i(0, 1), sf::Vector2i(1, 0), r.height);
+		if (sy > 0)
+			this->addEntrances(grid, sector, sf::Vector2i(r.left, r.top), sf::Vector2i(1, 0), sf::Vector2i(0, -1), r.width);
+		if (sy < this->height - 1)
+			this->addEntrances(grid, sector, sf::Vector2i(r.left, r.top + r.height - 1), sf::Vector2i(1, 0), sf::Vector2i(0, 1), r.width);
+
+		int count = sector.portals.size();
+		sector.costs.assign(count * count, -1);
+		std::vector<int> costs;
+		for (int i = 0; i < count; ++i) {
+			this->localCosts(grid, r, sector.portals[i].pos, costs);
+			for (int j = 0; j < count; ++j) {
+				sector.costs[i * count + j] = costs[this->localIndex(r, sector.portals[j].pos)];
+			}
+		}
+		this->sectors[idx] = rebuilt;
+	}
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#define SPATIAL_HASH_CELL 32.0f
+
+// uniform grid of buckets, objects are counting sorted by cell into one contiguous array
+// rebuilt each frame in linear time without allocation once vectors reached their size
+template <typename T>
+class SpatialHash {
+	float cellSize;
+	float invCellSize;
+	int width; // cells
+	int height;
+
+	// objects of cell i are objects[cellStart[i]] to objects[cellStart[i + 1]]
+	std::vector<unsigned int> cellStart;
+	std::vector<T> objects;
+
+	// added since last build
+	std::vector<T> pending;
+	std::vector<unsigned int> pendingCells;
+
+public:
+	SpatialHash(float _width, float _height, float _cellSize = SPATIAL_HASH_CELL) {
+		this->cellSize = _cellSize;
+		this->invCellSize = 1.0f / _cellSize;
+		this->width = std::max(1, (int)ceil(_width / _cellSize));
+		this->height = std::max(1, (int)ceil(_height / _cellSize));
+		this->cellStart.assign(this->width * this->height + 1, 0);
+	}
+
+	void clear() {
+		this->pending.clear();
+		this->pendingCells.clear();
+		this->objects.clear();
+		std::fill(this->cellStart.begin(), this->cellStart.end(), 0);
+	}
+
+	// out of grid objects are kept in border cells
+	void add(const T &object) {
+		this->pending.push_back(object);
+		this->pendingCells.push_back(this->cellIndex(this->cellX(object.x), this->cellY(object.y)));
+	}
+
+	// counting sort of added objects
+	void build() {
+		std::fill(this->cellStart.begin(), this->cellStart.end(), 0);
+		for (unsigned int cell : this->pendingCells) {
+			this->cellStart[cell + 1]++;
+		}
+		for (unsigned int i = 1; i < this->cellStart.size(); ++i) {
+			this->cellStart[i] += this->cellStart[i - 1];
+		}
+
+		// every slot is overwritten below, only grown slots are filled
+		if (this->objects.size() > this->pending.size())
+			this->objects.erase(this->objects.begin() + this->pending.size(), this->objects.end());
+		else if (!this->pending.empty())
+			this->objects.resize(this->pending.size(), this->pending.front());
+
+		// cellStart[cell] is used as insert cursor and ends at the start of the next cell,
+		// starts are shifted back by one cell afterwards
+		for (unsigned int i = 0; i < this->pending.size(); ++i) {
+			unsigned int cell = this->pendingCells[i];
+			this->objects[this->cellStart[cell]++] = this->pending[i];
+		}
+		for (int i = this->cellStart.size() - 1; i > 0; --i) {
+			this->cellStart[i] = this->cellStart[i - 1];
+		}
+		this->cellStart[0] = 0;
+
+		this->pending.clear();
+		this->pendingCells.clear();
+	}
+
+	unsigned int size() const {
+		return this->objects.size();
+	}
+
+	// call f on every object of cells intersecting the rect
+	template <typename F>
+	void forEach(float _x, float _y, float _width, float _height, F f) const {
+		int minX = this->cellX(_x);
+		int minY = this->cellY(_y);
+		int maxX = this->cellX(_x + _width);
+		int maxY = this->cellY(_y + _height);
+
+		for (int cy = minY; cy <= maxY; ++cy) {
+			for (int cx = minX; cx <= maxX; ++cx) {
+				int cell = this->cellIndex(cx, cy);
+				for (unsigned int i = this->cellStart[cell]; i < this->cellStart[cell + 1]; ++i) {
+					f(this->objects[i]);
+				}
+			}
+		}
+	}
+
+	// vector inserting, same than Quadtree::retrieve
+	void retrieve(std::vector<T> &v, float _x, float _y, float _width, float _height) const {
+		this->forEach(_x, _y, _width, _height, [&v](const T & object) {
+			v.push_back(object);
+		});
+	}
+
+private:
+	inline int cellX(float x) const {
+		return std::min(this->width - 1, std::max(0, (int)floor(x * this->invCellSize)));
+	}
+
+	inline int cellY(float y) const {
+		return std::min(this->height - 1, std::max(0, (int)floor(y * this->invCellSize)));
+	}
+
+	inline int cellIndex(int cx, int cy) const {
+		return cx + cy * this->width;
+	}
+};
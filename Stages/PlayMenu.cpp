@@ -127,7 +127,12 @@ void PlayMenu::fadeOutCallback() {
 			this->game->unregisterStage("game");
 		}
 
-		this->game->registerStage("game", new GameEngine(this->game, mapWidth, mapHeight, playerTeam));
+		MatchSettings settings;
+		settings.mapWidth = mapWidth;
+		settings.mapHeight = mapHeight;
+		settings.playerTeam = playerTeam;
+		settings.seed = time(NULL);
+		this->game->registerStage("game", new GameEngine(this->game, settings));
 		this->game->pushRegisteredStage("game");
 	}
 	break;
@@ -4,6 +4,7 @@
 
 #define MAX_SEE_AHEAD 32.0f
 #define MAX_AVOID_FORCE 1.0f
+#define MAX_FORCE 0.1f
 #define OBJ_RADIUS 20.0f
 
 #define MAX_QUEUE_AHEAD 16.0f
@@ -34,7 +35,7 @@ public:
 //	}
 
 	sf::Vector2f seek(const T &currentObject, const sf::Vector2f &dpos) {
-		this->seek(currentObject, dpos, currentObject.maxSpeed);
+		return this->seek(currentObject, dpos, currentObject.maxSpeed);
 	}
 
 	sf::Vector2f seek(const T &currentObject, const sf::Vector2f &dpos, float speed) {
@@ -124,36 +125,21 @@ public:
 		return seek(currentObject, path[index]);
 	}
 
-//	// same than separate ?
-	sf::Vector2f avoid(const T &currentObject, std::vector<sf::Vector2f> &cases) {
-		sf::Vector2f steer(0, 0);
-		int count = 0;
-		sf::Vector2f pos = currentObject.pos;
-		for (sf::Vector2f &c : cases)
-		{
-			float d = distance(currentObject.pos, c);
-			if (d <= AVOID_DIST) {
-				steer += normalize(currentObject.pos - c);
-				count++;
-			}
-		}
-		if (count > 0) {
-			steer /= (float)count;
-			steer = normalize(steer);
-			steer *= currentObject.maxSpeed;
+	// away is the obstacle field gradient
+	sf::Vector2f avoid(const T &currentObject, const sf::Vector2f &away) {
+		if (away == sf::Vector2f(0, 0))
+			return sf::Vector2f(0, 0);
 
-			steer -= currentObject.velocity;
-			steer = limit(steer, currentObject.maxForce);
+		sf::Vector2f steer = normalize(away) * currentObject.maxSpeed;
+		steer -= currentObject.velocity;
+		steer = limit(steer, currentObject.maxForce);
 
 #ifdef STEERING_DEBUG
-			if (steer != sf::Vector2f(0, 0))
-				std::cout << "Steering: avoid " << currentObject.entity << " " << steer << std::endl;
+		if (steer != sf::Vector2f(0, 0))
+			std::cout << "Steering: avoid " << currentObject.entity << " " << steer << std::endl;
 #endif
 
-			return steer;
-		} else {
-			return sf::Vector2f(0, 0);
-		}
+		return steer;
 	}
 
 	sf::Vector2f separate(const T &currentObject, std::vector<T> &others) {
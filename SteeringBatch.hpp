@@ -0,0 +1,398 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "Helpers.hpp"
+#include "Steering.hpp"
+#include "ChunkWorkers.hpp"
+
+#define MIN_VELOCITY 0.01f
+
+#define AVOID_WEIGHT 1.0f
+#define SEPARATE_WEIGHT 2.0f
+
+// float lanes used by the batch kernels, the same kernel code is instanciated for each
+namespace SteeringLanes {
+
+struct Scalar {
+	typedef float V;
+	typedef bool M;
+	static const int width = 1;
+
+	static inline V load(const float *p) { return *p; }
+	static inline void store(float *p, V v) { *p = v; }
+	static inline V set1(float f) { return f; }
+	static inline V add(V a, V b) { return a + b; }
+	static inline V sub(V a, V b) { return a - b; }
+	static inline V mul(V a, V b) { return a * b; }
+	static inline V div(V a, V b) { return a / b; }
+	static inline V sqrt(V a) { return ::sqrtf(a); }
+	static inline M lt(V a, V b) { return a < b; }
+	static inline M le(V a, V b) { return a <= b; }
+	static inline M gt(V a, V b) { return a > b; }
+	static inline M eq(V a, V b) { return a == b; }
+	static inline M andm(M a, M b) { return a && b; }
+	static inline V select(M m, V a, V b) { return m ? a : b; }
+};
+
+#if defined(__SSE2__)
+struct Sse {
+	typedef __m128 V;
+	typedef __m128 M;
+	static const int width = 4;
+
+	static inline V load(const float *p) { return _mm_loadu_ps(p); }
+	static inline void store(float *p, V v) { _mm_storeu_ps(p, v); }
+	static inline V set1(float f) { return _mm_set1_ps(f); }
+	static inline V add(V a, V b) { return _mm_add_ps(a, b); }
+	static inline V sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static inline V mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static inline V div(V a, V b) { return _mm_div_ps(a, b); }
+	static inline V sqrt(V a) { return _mm_sqrt_ps(a); }
+	static inline M lt(V a, V b) { return _mm_cmplt_ps(a, b); }
+	static inline M le(V a, V b) { return _mm_cmple_ps(a, b); }
+	static inline M gt(V a, V b) { return _mm_cmpgt_ps(a, b); }
+	static inline M eq(V a, V b) { return _mm_cmpeq_ps(a, b); }
+	static inline M andm(M a, M b) { return _mm_and_ps(a, b); }
+	static inline V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
+#endif
+
+#if defined(__AVX__)
+struct Avx {
+	typedef __m256 V;
+	typedef __m256 M;
+	static const int width = 8;
+
+	static inline V load(const float *p) { return _mm256_loadu_ps(p); }
+	static inline void store(float *p, V v) { _mm256_storeu_ps(p, v); }
+	static inline V set1(float f) { return _mm256_set1_ps(f); }
+	static inline V add(V a, V b) { return _mm256_add_ps(a, b); }
+	static inline V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static inline V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static inline V div(V a, V b) { return _mm256_div_ps(a, b); }
+	static inline V sqrt(V a) { return _mm256_sqrt_ps(a); }
+	static inline M lt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static inline M le(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static inline M gt(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static inline M eq(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static inline M andm(M a, M b) { return _mm256_and_ps(a, b); }
+	static inline V select(M m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+};
+#endif
+
+#if defined(__AVX__)
+typedef Avx Best;
+#elif defined(__SSE2__)
+typedef Sse Best;
+#else
+typedef Scalar Best;
+#endif
+
+}
+
+// neighbours of a chunk of units, relative to their unit
+// pairs of the k-th unit of the chunk are *[start[k]] to *[start[k + 1]]
+class SteeringPairs {
+	float ux;
+	float uy;
+
+public:
+	std::vector<unsigned int> neighborStart;
+	std::vector<float> neighborDx; // unit pos - neighbour pos
+	std::vector<float> neighborDy;
+	std::vector<float> neighborFx; // kernel output
+	std::vector<float> neighborFy;
+	std::vector<float> neighborCount;
+
+	void clear() {
+		this->neighborStart.assign(1, 0);
+		this->neighborDx.clear();
+		this->neighborDy.clear();
+	}
+
+	// pairs added next belong to the unit at pos
+	void next(float x, float y) {
+		this->ux = x;
+		this->uy = y;
+		this->neighborStart.push_back(this->neighborDx.size());
+	}
+
+	inline void addNeighbor(sf::Vector2f pos) {
+		this->neighborDx.push_back(this->ux - pos.x);
+		this->neighborDy.push_back(this->uy - pos.y);
+		this->neighborStart.back()++;
+	}
+};
+
+// units per chunk, a multiple of the widest lanes
+#define STEERING_BATCH_CHUNK 256
+
+// steering of many units at once, in structure of arrays
+// units are added serially, then chunks of units gather their pairs and run the kernels in parallel
+// the compute phase only reads the snapshot taken when units are added and writes to the out arrays
+// so units see each other before their move, whatever the workers count
+// separation, avoidance, flow following and the velocity integration run in SIMD kernels, other forces are added per unit as extra
+// avoidance comes from the obstacle field gradient, set per unit
+// same formulas than Steering<T>
+class SteeringBatch {
+	bool simd;
+
+	// per unit
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> vx;
+	std::vector<float> vy;
+	std::vector<float> maxSpeed;
+	std::vector<float> flowX;
+	std::vector<float> flowY;
+	std::vector<float> flowWeight;
+	std::vector<float> extraX;
+	std::vector<float> extraY;
+	std::vector<float> avoidX;
+	std::vector<float> avoidY;
+	std::vector<float> avoidCount;
+
+	// sums of neighbours forces
+	std::vector<float> separateX;
+	std::vector<float> separateY;
+	std::vector<float> separateCount;
+
+	std::vector<SteeringPairs> chunks;
+
+public:
+	// results
+	std::vector<float> outX;
+	std::vector<float> outY;
+	std::vector<float> outVx;
+	std::vector<float> outVy;
+
+	SteeringBatch() {
+		this->simd = true;
+	}
+
+	// scalar kernels when false, for comparison
+	void setSimd(bool simd) {
+		this->simd = simd;
+	}
+
+	unsigned int size() const {
+		return this->x.size();
+	}
+
+	void clear() {
+		this->x.clear();
+		this->y.clear();
+		this->vx.clear();
+		this->vy.clear();
+		this->maxSpeed.clear();
+		this->flowX.clear();
+		this->flowY.clear();
+		this->flowWeight.clear();
+		this->extraX.clear();
+		this->extraY.clear();
+		this->avoidX.clear();
+		this->avoidY.clear();
+		this->avoidCount.clear();
+	}
+
+	unsigned int add(sf::Vector2f pos, sf::Vector2f velocity, float speed) {
+		this->x.push_back(pos.x);
+		this->y.push_back(pos.y);
+		this->vx.push_back(velocity.x);
+		this->vy.push_back(velocity.y);
+		this->maxSpeed.push_back(speed);
+		this->flowX.push_back(0.0f);
+		this->flowY.push_back(0.0f);
+		this->flowWeight.push_back(0.0f);
+		this->extraX.push_back(0.0f);
+		this->extraY.push_back(0.0f);
+		this->avoidX.push_back(0.0f);
+		this->avoidY.push_back(0.0f);
+		this->avoidCount.push_back(0.0f);
+		return this->x.size() - 1;
+	}
+
+	// Steering::avoid, from the gather of unit i only
+	void setAvoid(unsigned int i, sf::Vector2f away) {
+		this->avoidX[i] = away.x;
+		this->avoidY[i] = away.y;
+		this->avoidCount[i] = 1.0f;
+	}
+
+	// Steering::followFlowField, from the gather of unit i only
+	void setFlow(unsigned int i, sf::Vector2f direction, float weight) {
+		this->flowX[i] = direction.x;
+		this->flowY[i] = direction.y;
+		this->flowWeight[i] = weight;
+	}
+
+	// forces computed per unit, from the gather of unit i only
+	void addExtra(unsigned int i, sf::Vector2f force) {
+		this->extraX[i] += force.x;
+		this->extraY[i] += force.y;
+	}
+
+	// gather(i, pairs) adds neighbours of unit i, it runs in workers and must only read shared state
+	template <typename F>
+	void run(ChunkWorkers &workers, F gather) {
+		unsigned int units = this->size();
+		this->separateX.resize(units);
+		this->separateY.resize(units);
+		this->separateCount.resize(units);
+		this->outX.resize(units);
+		this->outY.resize(units);
+		this->outVx.resize(units);
+		this->outVy.resize(units);
+		this->chunks.resize((units + STEERING_BATCH_CHUNK - 1) / STEERING_BATCH_CHUNK);
+
+		workers.run(units, STEERING_BATCH_CHUNK, [this, &gather](unsigned int begin, unsigned int end) {
+			SteeringPairs &pairs = this->chunks[begin / STEERING_BATCH_CHUNK];
+			pairs.clear();
+			for (unsigned int i = begin; i < end; ++i) {
+				pairs.next(this->x[i], this->y[i]);
+				gather(i, pairs);
+			}
+
+			if (this->simd)
+				this->compute<SteeringLanes::Best>(pairs, begin, end);
+			else
+				this->compute<SteeringLanes::Scalar>(pairs, begin, end);
+		});
+	}
+
+private:
+	template <typename L>
+	void compute(SteeringPairs &pairs, unsigned int begin, unsigned int end) {
+		pairs.neighborFx.resize(pairs.neighborDx.size());
+		pairs.neighborFy.resize(pairs.neighborDx.size());
+		pairs.neighborCount.resize(pairs.neighborDx.size());
+
+		unsigned int done = this->forces<L>(pairs.neighborDx.data(), pairs.neighborDy.data(), pairs.neighborFx.data(), pairs.neighborFy.data(), pairs.neighborCount.data(), 0, pairs.neighborDx.size());
+		this->forces<SteeringLanes::Scalar>(pairs.neighborDx.data(), pairs.neighborDy.data(), pairs.neighborFx.data(), pairs.neighborFy.data(), pairs.neighborCount.data(), done, pairs.neighborDx.size());
+
+		this->sum(pairs.neighborStart, pairs.neighborFx, pairs.neighborFy, pairs.neighborCount, begin, end, this->separateX, this->separateY, this->separateCount);
+
+		done = this->integrate<L>(begin, end);
+		this->integrate<SteeringLanes::Scalar>(done, end);
+	}
+
+	// per pair separate force, returns the first pair not done
+	template <typename L>
+	static unsigned int forces(const float *dxs, const float *dys, float *fxs, float *fys, float *counts, unsigned int begin, unsigned int end) {
+		const typename L::V zero = L::set1(0.0f);
+		const typename L::V one = L::set1(1.0f);
+		const typename L::V separationDist = L::set1(SEPARATION_DIST);
+
+		unsigned int i = begin;
+		for (; i + L::width <= end; i += L::width) {
+			typename L::V dx = L::load(dxs + i);
+			typename L::V dy = L::load(dys + i);
+			typename L::V d = L::sqrt(L::add(L::mul(dx, dx), L::mul(dy, dy)));
+			typename L::V safe = L::select(L::eq(d, zero), one, d);
+			// normalize(pos - other) / d
+			typename L::V fx = L::div(L::div(dx, safe), safe);
+			typename L::V fy = L::div(L::div(dy, safe), safe);
+			typename L::M in = L::andm(L::gt(d, zero), L::lt(d, separationDist));
+			L::store(fxs + i, L::select(in, fx, zero));
+			L::store(fys + i, L::select(in, fy, zero));
+			L::store(counts + i, L::select(in, one, zero));
+		}
+		return i;
+	}
+
+	static void sum(const std::vector<unsigned int> &starts, const std::vector<float> &fxs, const std::vector<float> &fys, const std::vector<float> &counts,
+	                unsigned int begin, unsigned int end, std::vector<float> &sumX, std::vector<float> &sumY, std::vector<float> &sumCount) {
+		for (unsigned int u = begin; u < end; ++u) {
+			float sx = 0.0f, sy = 0.0f, count = 0.0f;
+			for (unsigned int i = starts[u - begin]; i < starts[u - begin + 1]; ++i) {
+				sx += fxs[i];
+				sy += fys[i];
+				count += counts[i];
+			}
+			sumX[u] = sx;
+			sumY[u] = sy;
+			sumCount[u] = count;
+		}
+	}
+
+	// limit(normalize(desired) * maxSpeed - velocity, MAX_FORCE)
+	template <typename L>
+	static inline void steer(typename L::V dx, typename L::V dy, typename L::V vx, typename L::V vy, typename L::V speed,
+	                         typename L::V &sx, typename L::V &sy) {
+		const typename L::V zero = L::set1(0.0f);
+		const typename L::V one = L::set1(1.0f);
+		const typename L::V maxForce = L::set1(MAX_FORCE);
+
+		typename L::V len = L::sqrt(L::add(L::mul(dx, dx), L::mul(dy, dy)));
+		len = L::select(L::eq(len, zero), one, len);
+		sx = L::sub(L::mul(L::div(dx, len), speed), vx);
+		sy = L::sub(L::mul(L::div(dy, len), speed), vy);
+
+		typename L::V s2 = L::add(L::mul(sx, sx), L::mul(sy, sy));
+		typename L::V slen = L::sqrt(s2);
+		typename L::V scale = L::select(L::gt(s2, L::mul(maxForce, maxForce)), L::div(maxForce, slen), one);
+		sx = L::mul(sx, scale);
+		sy = L::mul(sy, scale);
+	}
+
+	// sum forces, limit velocity and move, returns the first unit not done
+	template <typename L>
+	unsigned int integrate(unsigned int begin, unsigned int end) {
+		const typename L::V zero = L::set1(0.0f);
+		const typename L::V one = L::set1(1.0f);
+		const typename L::V minVelocity = L::set1(MIN_VELOCITY);
+		const typename L::V avoidWeight = L::set1(AVOID_WEIGHT);
+		const typename L::V separateWeight = L::set1(SEPARATE_WEIGHT);
+
+		unsigned int i = begin;
+		for (; i + L::width <= end; i += L::width) {
+			typename L::V vx = L::load(&this->vx[i]);
+			typename L::V vy = L::load(&this->vy[i]);
+			typename L::V speed = L::load(&this->maxSpeed[i]);
+			typename L::V ax = L::load(&this->extraX[i]);
+			typename L::V ay = L::load(&this->extraY[i]);
+			typename L::V sx, sy;
+
+			// avoid
+			typename L::V count = L::load(&this->avoidCount[i]);
+			this->steer<L>(L::load(&this->avoidX[i]), L::load(&this->avoidY[i]), vx, vy, speed, sx, sy);
+			typename L::M some = L::gt(count, zero);
+			ax = L::add(ax, L::select(some, L::mul(sx, avoidWeight), zero));
+			ay = L::add(ay, L::select(some, L::mul(sy, avoidWeight), zero));
+
+			// flow field
+			typename L::V weight = L::load(&this->flowWeight[i]);
+			this->steer<L>(L::load(&this->flowX[i]), L::load(&this->flowY[i]), vx, vy, speed, sx, sy);
+			ax = L::add(ax, L::mul(sx, weight));
+			ay = L::add(ay, L::mul(sy, weight));
+
+			// separate
+			count = L::load(&this->separateCount[i]);
+			this->steer<L>(L::load(&this->separateX[i]), L::load(&this->separateY[i]), vx, vy, speed, sx, sy);
+			some = L::gt(count, zero);
+			ax = L::add(ax, L::select(some, L::mul(sx, separateWeight), zero));
+			ay = L::add(ay, L::select(some, L::mul(sy, separateWeight), zero));
+
+			// limit(velocity + accel, maxSpeed * MIN_VELOCITY, maxSpeed)
+			vx = L::add(vx, ax);
+			vy = L::add(vy, ay);
+			typename L::V v2 = L::add(L::mul(vx, vx), L::mul(vy, vy));
+			typename L::V scale = L::select(L::gt(v2, L::mul(speed, speed)), L::div(speed, L::sqrt(v2)),
+			                                L::select(L::lt(v2, L::mul(speed, minVelocity)), zero, one));
+			vx = L::mul(vx, scale);
+			vy = L::mul(vy, scale);
+
+			L::store(&this->outVx[i], vx);
+			L::store(&this->outVy[i], vy);
+			L::store(&this->outX[i], L::add(L::load(&this->x[i]), vx));
+			L::store(&this->outY[i], L::add(L::load(&this->y[i]), vy));
+		}
+		return i;
+	}
+};
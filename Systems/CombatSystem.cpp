@@ -9,7 +9,7 @@ void CombatSystem::init() {
 void CombatSystem::attacking(EntityID entity) {
 	if (this->vault->registry.has<Unit>(entity)) {
 		Tile &tile = vault->registry.get<Tile>(entity);
-		if (tile.state == "attack") {
+		if (tile.state == TileStateStr("attack")) {
 			Unit &unit = vault->registry.get<Unit>(entity);
 
 #ifdef COMBAT_DEBUG
@@ -38,7 +38,7 @@ void CombatSystem::attacking(EntityID entity) {
 			} else if (unit.targetType == TargetType::Bomb) {
 				projTargetPos = sf::Vector2f(unit.targetPos * 32);
 			} else {
-				this->changeState(entity, "idle");
+				this->changeState(entity, TileStateStr("idle"));
 				unit.targetType = TargetType::None;
 				unit.targetEnt = 0;
 //				unit.destpos = tile.pos;
@@ -55,7 +55,7 @@ void CombatSystem::attacking(EntityID entity) {
 						this->vault->dispatcher.trigger<EffectCreate>("projectile", entity, tile.ppos, projOptions);
 
 						float expectedDuration = length(projTargetPos - tile.ppos) / 80.0f;
-						this->vault->factory.createTimer(this->vault->registry, entity, "projectile_arrival", expectedDuration, false);
+						this->vault->factory.createTimer(this->vault->registry, entity, TimerNameStr("projectile_arrival"), expectedDuration, false);
 					}
 				}
 			}
@@ -65,17 +65,17 @@ void CombatSystem::attacking(EntityID entity) {
 
 // frame changed
 void CombatSystem::receive(const TimerLooped & event) {
-	if (event.name == "attack")
+	if (event.name == TimerNameStr("attack"))
 		this->attacking(event.entity);
 }
 
 void CombatSystem::receive(const TimerStarted & event) {
-	if (event.name == "attack")
+	if (event.name == TimerNameStr("attack"))
 		this->attacking(event.entity);
 }
 
 void CombatSystem::receive(const TimerEnded & event) {
-	if (event.name == "projectile_arrival") {
+	if (event.name == TimerNameStr("projectile_arrival")) {
 		if (this->vault->registry.has<Timer>(event.entity)) {
 			Timer &timer = this->vault->registry.get<Timer>(event.entity);
 			if (this->vault->registry.has<Unit>(timer.emitterEntity)) {
@@ -109,7 +109,7 @@ void CombatSystem::receive(const TimerEnded & event) {
 				break;
 				case SpecialSkillStr("seed_nature"): {
 					if (!this->map->resources.get(projDestPos.x, projDestPos.y) && this->map->staticBuildable.get(projDestPos.x, projDestPos.y) == 0) {
-						if ((rand() % 4) == 0) {
+						if (this->matchRandom().range(4) == 0) {
 							EntityID resEnt = this->vault->factory.plantResource(this->vault->registry, "nature", projDestPos.x, projDestPos.y);
 							this->map->resources.set(projDestPos.x, projDestPos.y, resEnt);
 #ifdef COMBAT_DEBUG
@@ -143,7 +143,7 @@ void CombatSystem::receive(const TimerEnded & event) {
 
 			}
 		}
-	} else if (event.name == "delayed_destroy") {
+	} else if (event.name == TimerNameStr("delayed_destroy")) {
 		if (this->vault->registry.has<Timer>(event.entity)) {
 			Timer &timer = this->vault->registry.get<Timer>(event.entity);
 			this->vault->dispatcher.trigger<EntityDelete>(timer.emitterEntity);
@@ -151,47 +151,40 @@ void CombatSystem::receive(const TimerEnded & event) {
 	}
 }
 
+// threatened influence cells of each player clustered, adjacent cells make one front
 void CombatSystem::updateFront(float dt) {
-	// player
 	auto playerView = this->vault->registry.view<Player>();
 	for (EntityID entity : playerView) {
 		Player &player = playerView.get(entity);
+		player.frontPoints.clear();
+
+		this->map->influence.threatCells(TeamIDStr(player.team.c_str()), this->threatCells);
+		if (this->threatCells.size() == 0)
+			continue;
 
 		std::vector<Point> points;
-		for (auto &p : player.allFrontPoints) {
-			points.push_back(Point{(double)p.x, (double)p.y});
+		for (auto &cell : this->threatCells) {
+			points.push_back(Point{(double)cell.first.x, (double)cell.first.y});
 		}
-		player.allFrontPoints.clear();
-		player.frontPoints.clear();
 
 		std::vector<int> labels;
+		int num = this->frontDbscans[entity].run(points, labels, INFLUENCE_CELL * 1.5, 1);
 
-		int num = dbscan(points, labels, 10.0, 3);
-
-//			std::cout << player.team << " cluster size is " << num << "/" << points.size() << std::endl;
-
-		std::map<int, Point> points_map;
-		std::map<int, int> points_map_size;
+		// threat weighted center of each cluster
+		std::vector<FrontPoint> fronts(num, FrontPoint{sf::Vector2i(0, 0), 0.0f});
+		std::vector<sf::Vector2f> sums(num, sf::Vector2f(0.0f, 0.0f));
 		for (int i = 0; i < (int)points.size(); i++) {
-			if (points_map.count(labels[i]) == 0) {
-				points_map[labels[i]] = points[i];
-				points_map_size[labels[i]] = 1;
-			} else {
-				points_map[labels[i]].x = points_map[labels[i]].x + points[i].x;
-				points_map[labels[i]].y = points_map[labels[i]].y + points[i].y;
-				points_map_size[labels[i]] = points_map_size[labels[i]] + 1;
-			}
-//				std::cout << "Point(" << points[i].x << ", " << points[i].y << "): " << labels[i] << std::endl;
+			int cluster = labels[i] - 1;
+			float threat = this->threatCells[i].second;
+			sums[cluster] += sf::Vector2f(this->threatCells[i].first) * threat;
+			fronts[cluster].priority += threat;
 		}
-
-		for (auto pair : points_map) {
-			player.frontPoints.push_back(FrontPoint{sf::Vector2i(pair.second.x / points_map_size[pair.first], pair.second.y / points_map_size[pair.first]), points_map_size[pair.first]});
+		for (int i = 0; i < num; i++) {
+			fronts[i].pos = sf::Vector2i(sums[i] / fronts[i].priority);
+			player.frontPoints.push_back(fronts[i]);
 		}
 
-		std::sort (player.frontPoints.begin(), player.frontPoints.end(), FrontPointCompare());
-//			for (FrontPoint &p : player.frontPoints) {
-//				std::cout << player.team << " front point " << p.pos.x << "x" << p.pos.y << " " << p.priority << std::endl;
-//			}
+		std::sort(player.frontPoints.begin(), player.frontPoints.end(), FrontPointCompare());
 	}
 }
 
@@ -212,7 +205,23 @@ bool CombatSystem::ennemyInRange(Tile & tile, Tile & destTile, int dist, int max
 	return false;
 }
 
+void CombatSystem::updateTeamObjs() {
+	auto view = this->vault->registry.persistent<Tile, GameObject>();
+	for (EntityID entity : view) {
+		Tile &tile = view.get<Tile>(entity);
+		GameObject &obj = view.get<GameObject>(entity);
+		if (obj.life > 0 && obj.mapped) {
+			for (sf::Vector2i const &p : this->tileSurface(tile)) {
+				this->map->teamObjs.add(obj.teamId, entity, p);
+			}
+		}
+	}
+	this->map->teamObjs.build();
+}
+
 void CombatSystem::update(float dt) {
+	this->updateTeamObjs();
+	this->map->influence.tick();
 
 	// pass 1, if an ennemy is in sight, then attack / respond to attack
 	auto view = this->vault->registry.persistent<Tile, GameObject, Unit>();
@@ -231,14 +240,14 @@ void CombatSystem::update(float dt) {
 				if (destObj.life > 0) {
 					if (this->vault->registry.has<Unit>(unit.targetEnt)) {
 						Unit &destUnit = this->vault->registry.get<Unit>(unit.targetEnt);
-						if (destTile.state == "idle") {
+						if (destTile.state == TileStateStr("idle")) {
 							// if ennemy is idle, he will fight back
 							this->attack(destUnit, entity);
 							destUnit.destpos = destTile.pos;
-						} else if (destTile.state == "move") {
+						} else if (destTile.state == TileStateStr("move")) {
 							this->attack(destUnit, entity);
 							destUnit.destpos = destTile.pos;
-						} else if (destTile.state == "attack" && destUnit.targetEnt) {
+						} else if (destTile.state == TileStateStr("attack") && destUnit.targetEnt) {
 							// if ennemy is attacking a building, he will fight back
 							if (this->vault->registry.has<Building>(destUnit.targetEnt)) {
 								this->attack(destUnit, entity);
@@ -257,57 +266,29 @@ void CombatSystem::update(float dt) {
 		GameObject &obj = view.get<GameObject>(entity);
 		Unit &unit = view.get<Unit>(entity);
 		if (!unit.targetEnt) {
-			EntityID finalTargetEnt = 0;
-			float dist = std::numeric_limits<float>::max();
-
-			for (sf::Vector2i const &p : this->tileSurfaceExtended(tile, obj.view)) {
-				EntityID pEnt = this->map->objs.get(p.x, p.y);
-				if (pEnt) {
-					if (this->vault->registry.has<GameObject>(pEnt)) {
-						Tile &pTile = this->vault->registry.get<Tile>(pEnt);
-						GameObject &pObj = this->vault->registry.get<GameObject>(pEnt);
-						if (pObj.team != obj.team) {
-							// TODO: optimize
-							Player &player = this->vault->registry.get<Player>(obj.player);
-							player.enemyFound = true;
-							player.enemyPos = p;
-
-							if (distance(pTile.ppos, tile.ppos) < dist) {
-								dist = distance(pTile.ppos, tile.ppos);
-								finalTargetEnt = pEnt;
-							}
-
-						}
-					}
-				}
-			}
+			sf::Vector2i enemyPos;
+			EntityID finalTargetEnt = this->map->teamObjs.nearestEnemy(obj.teamId, tile.pos, obj.view, &enemyPos);
 
 			if (finalTargetEnt) {
+				Player &player = this->vault->registry.get<Player>(obj.player);
+				player.enemyFound = true;
+				player.enemyPos = enemyPos;
+
 				this->attack(unit, finalTargetEnt);
 				unit.destpos = tile.pos;
 			}
 		} else {
 			// change target if somebody nearer attack
 			Tile &cpTile = this->vault->registry.get<Tile>(unit.targetEnt);
-			EntityID finalTargetEnt = 0;
-			float dist = std::numeric_limits<float>::max();
-
-			for (sf::Vector2i const &p : this->tileSurfaceExtended(tile, obj.view)) {
-				EntityID pEnt = this->map->objs.get(p.x, p.y);
-				if (pEnt) {
-					if (this->vault->registry.has<Unit>(pEnt)) {
-						Tile &pTile = this->vault->registry.get<Tile>(pEnt);
-						GameObject &pObj = this->vault->registry.get<GameObject>(pEnt);
-						Unit &pUnit = this->vault->registry.get<Unit>(pEnt);
-						if (pObj.team != obj.team && pUnit.targetEnt == entity && distance(pTile.ppos, tile.ppos) < distance(cpTile.ppos, tile.ppos)) {
-							if (distance(pTile.ppos, tile.ppos) < dist) {
-								dist = distance(pTile.ppos, tile.ppos);
-								finalTargetEnt = pEnt;
-							}
-						}
-					}
-				}
-			}
+			sf::Vector2i cpDiff = cpTile.pos - tile.pos;
+			int cpDist2 = cpDiff.x * cpDiff.x + cpDiff.y * cpDiff.y;
+
+			EntityID finalTargetEnt = this->map->teamObjs.nearestEnemy(obj.teamId, tile.pos, obj.view, [this, entity, &tile, cpDist2](const TeamObject & object) {
+				sf::Vector2i d = object.pos - tile.pos;
+				return d.x * d.x + d.y * d.y < cpDist2 &&
+				       this->vault->registry.has<Unit>(object.entity) &&
+				       this->vault->registry.get<Unit>(object.entity).targetEnt == entity;
+			});
 
 			if (finalTargetEnt) {
 				this->attack(unit, finalTargetEnt);
@@ -379,19 +360,19 @@ void CombatSystem::update(float dt) {
 						}
 
 						if (destObj.player) {
-							this->addPlayerFrontPoint(destObj.player, unit.targetEnt, destTile.pos);
+							this->addThreat(destObj.player, unit.targetEnt, destTile.pos, damage);
 						}
 
 						// start/continue attacking
-						this->changeState(entity, "attack");
+						this->changeState(entity, TileStateStr("attack"));
 						unit.velocity = sf::Vector2f(0, 0);
 						unit.destpos = tile.pos;
 
 					} else {
 						sf::Vector2i dpos = destTile.pos;
 
-						if (tile.state == "attack") // change to idle if attacking and out of range
-							this->changeState(entity, "idle");
+						if (tile.state == TileStateStr("attack")) // change to idle if attacking and out of range
+							this->changeState(entity, TileStateStr("idle"));
 
 						this->goTo(unit, dpos);
 
@@ -409,7 +390,7 @@ void CombatSystem::update(float dt) {
 
 					bool inRange = this->targetInRange(tile, unit.targetPos, dist, maxDist);
 					if (inRange) {
-						this->changeState(entity, "attack");
+						this->changeState(entity, TileStateStr("attack"));
 						unit.velocity = sf::Vector2f(0, 0);
 						unit.destpos = tile.pos;
 					} else {
@@ -419,7 +400,7 @@ void CombatSystem::update(float dt) {
 					// no distance attack, just go to target
 					bool inRange = this->targetInRange(tile, unit.targetPos, 1, 1);
 					if (inRange) {
-						this->changeState(entity, "idle");
+						this->changeState(entity, TileStateStr("idle"));
 						unit.targetType = TargetType::None;
 						unit.targetEnt = 0;
 						unit.destpos = tile.pos;
@@ -442,8 +423,8 @@ void CombatSystem::update(float dt) {
 		GameObject &obj = view.get<GameObject>(entity);
 
 		if (obj.life <= 0) {
-			if (tile.state != "die") {
-				if ((rand() % 16) == 0 && this->vault->registry.has<Effects>(entity) && this->vault->registry.get<Effects>(entity).effects.count("alt_die")) {
+			if (tile.state != TileStateStr("die")) {
+				if (this->matchRandom().range(16) == 0 && this->vault->registry.has<Effects>(entity) && this->vault->registry.get<Effects>(entity).effects.count("alt_die")) {
 					// alt die FX
 					ParticleEffectOptions altOptions;
 					altOptions.destPos = tile.ppos;
@@ -457,38 +438,38 @@ void CombatSystem::update(float dt) {
 
 					this->vault->dispatcher.trigger<EffectCreate>("alt_die", entity, tile.ppos, altOptions);
 
-					this->vault->factory.createTimer(this->vault->registry, entity, "delayed_destroy", 5.0, false);
+					this->vault->factory.createTimer(this->vault->registry, entity, TimerNameStr("delayed_destroy"), 5.0, false);
 
 				} else {
 					// unit died, destroy after playing anim
 					if (this->vault->registry.has<AnimatedSpritesheet>(entity))
 					{
 						AnimatedSpritesheet &anim = this->vault->registry.get<AnimatedSpritesheet>(entity);
-						if (anim.states.count("die") > 0) {
-							AnimatedSpriteView &view = anim.states["die"][0];
+						if (anim.states.count(TileStateStr("die")) > 0) {
+							AnimatedSpriteView &view = anim.states[TileStateStr("die")][0];
 
-							this->vault->factory.createTimer(this->vault->registry, entity, "delayed_destroy", view.duration * view.frames.size(), false);
+							this->vault->factory.createTimer(this->vault->registry, entity, TimerNameStr("delayed_destroy"), view.duration * view.frames.size(), false);
 						} else {
 							this->vault->dispatcher.trigger<EntityDelete>(entity);
 						}
 					}
 				}
 
-				this->changeState(entity, "die");
+				this->changeState(entity, TileStateStr("die"));
 				unit.targetType = TargetType::None;
 				unit.targetEnt = 0;
 				unit.destpos = tile.pos;
 			}
 		}
 
-		if (tile.state == "attack" && unit.targetType == TargetType::Attack) {
+		if (tile.state == TileStateStr("attack") && unit.targetType == TargetType::Attack) {
 			// attacked obj does not exists anymore, stop attacking
 			if (!unit.targetEnt) {
 #ifdef COMBAT_DEBUG
 				std::cout << "CombatSystem: " << entity << "enemy target does not exists anymore " << unit.targetEnt << std::endl;
 #endif
 
-				this->changeState(entity, "idle");
+				this->changeState(entity, TileStateStr("idle"));
 				unit.targetType = TargetType::None;
 				unit.targetEnt = 0;
 				unit.destpos = tile.pos;
@@ -504,7 +485,7 @@ void CombatSystem::update(float dt) {
 		GameObject &obj = buildingView.get<GameObject>(entity);
 
 		if (obj.life <= 0) {
-			if (tile.state != "destroy") {
+			if (tile.state != TileStateStr("destroy")) {
 				ParticleEffectOptions projOptions;
 				projOptions.destPos = tile.ppos;
 				projOptions.direction = 0;
@@ -512,9 +493,9 @@ void CombatSystem::update(float dt) {
 				this->vault->dispatcher.trigger<EffectCreate>("destroy", entity, tile.ppos, projOptions);
 				this->vault->dispatcher.trigger<SoundPlay>("explosion", 2, true, tile.pos);
 
-				this->vault->factory.createTimer(this->vault->registry, entity, "delayed_destroy", 1.0f, false);
+				this->vault->factory.createTimer(this->vault->registry, entity, TimerNameStr("delayed_destroy"), 1.0f, false);
 
-				tile.state = "destroy";
+				tile.state = TileStateStr("destroy");
 			}
 		} else {
 			// change tile view to show damages
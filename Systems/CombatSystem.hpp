@@ -2,11 +2,15 @@
 
 #include "GameSystem.hpp"
 
-#include "third_party/dbscan/dbscan.h"
+#include "GridDbscan.hpp"
 
 #define RANGE_RADIUS 32.0f
 
 class CombatSystem : public GameSystem {
+	// per player, keep buffers between passes
+	std::map<EntityID, GridDbscan> frontDbscans;
+	std::vector<std::pair<sf::Vector2i, float>> threatCells;
+
 public:
 	void init() override;
 	void update(float dt) override;
@@ -19,6 +23,7 @@ public:
 	void receive(const TimerEnded &event);
 
 private:
+	void updateTeamObjs();
 	void attacking(EntityID entity);
 	bool posInRange(Tile & tile, sf::Vector2f & destPos, int dist, int maxDist);
 	bool ennemyInRange(Tile & tile, Tile & destTile, int dist, int maxDist);
@@ -0,0 +1,194 @@
+#include "CommandSystem.hpp"
+
+CommandSystem::CommandSystem() {
+	this->playing = false;
+	this->markUpdateLayer = false;
+}
+
+void CommandSystem::init() {
+	this->vault->dispatcher.connect<CommandIssued>(this);
+}
+
+bool CommandSystem::startRecord(std::string filename, const MatchSettings &settings) {
+	this->record.open(filename);
+	if (!this->record) {
+		std::cerr << "ERROR: cannot write replay " << filename << std::endl;
+		return false;
+	}
+	Replay::writeSettings(this->record, settings);
+	this->record.flush();
+	return true;
+}
+
+void CommandSystem::play(const Replay &replay) {
+	this->playing = true;
+	this->queue.clear();
+	for (Command const &command : replay.commands) {
+		this->queue.push_back(command);
+	}
+}
+
+void CommandSystem::receive(const CommandIssued &event) {
+	if (this->playing)
+		return;
+
+	SimulationClock &clock = this->vault->registry.get<SimulationClock>();
+
+	Command command;
+	command.step = clock.steps + 1;
+	command.type = event.type;
+	command.player = event.player;
+	command.objs = this->serials(event.entities);
+	command.pos = event.pos;
+	command.name = event.name;
+	this->queue.push_back(command);
+}
+
+void CommandSystem::update(float dt) {
+	SimulationClock &clock = this->vault->registry.get<SimulationClock>();
+
+	while (this->queue.size() > 0 && this->queue.front().step <= clock.steps) {
+		Command command = this->queue.front();
+		this->queue.pop_front();
+		command.step = clock.steps;
+
+#ifdef COMMAND_DEBUG
+		std::cout << "CommandSystem: " << command.step << " " << commandTypeNames[(int)command.type] << " player " << command.player << std::endl;
+#endif
+		if (this->record.is_open()) {
+			Replay::writeCommand(this->record, command);
+			this->record.flush();
+		}
+
+		this->apply(command);
+	}
+}
+
+std::vector<unsigned long> CommandSystem::serials(const std::vector<EntityID> &entities) {
+	std::vector<unsigned long> serials;
+	for (EntityID entity : entities) {
+		if (this->vault->registry.valid(entity) && this->vault->registry.has<GameObject>(entity))
+			serials.push_back(this->vault->registry.get<GameObject>(entity).serial);
+	}
+	return serials;
+}
+
+// objects destroyed since the command was issued are left out
+std::vector<EntityID> CommandSystem::entities(const std::vector<unsigned long> &serials) {
+	std::vector<EntityID> entities;
+	if (serials.size() == 0)
+		return entities;
+
+	std::map<unsigned long, EntityID> bySerial;
+	auto view = this->vault->registry.view<GameObject>();
+	for (EntityID entity : view) {
+		bySerial[view.get(entity).serial] = entity;
+	}
+
+	for (unsigned long serial : serials) {
+		if (bySerial.count(serial))
+			entities.push_back(bySerial[serial]);
+	}
+	return entities;
+}
+
+void CommandSystem::resetController(EntityID playerEnt, EntityID entity, Action action) {
+	GameController &controller = this->vault->registry.get<GameController>();
+	if (controller.currentPlayer == playerEnt && controller.currentBuild == entity) {
+		controller.action = action;
+		if (action == Action::None)
+			controller.currentBuild = 0;
+	}
+}
+
+void CommandSystem::apply(const Command &command) {
+	if (!this->vault->registry.valid(command.player) || !this->vault->registry.has<Player>(command.player))
+		return;
+
+	Player &player = this->vault->registry.get<Player>(command.player);
+	std::vector<EntityID> objs = this->entities(command.objs);
+	// the building or construction concerned, none for the player root construction
+	EntityID entity = objs.size() > 0 ? objs.front() : 0;
+
+	switch (command.type) {
+	case CommandType::Move:
+		this->groupGoTo(objs, command.pos, GroupFormation::Square, North, true);
+		break;
+	case CommandType::Attack:
+		this->groupAttackOrBomb(command.player, objs, command.pos);
+		break;
+	case CommandType::AttackOrMove:
+		this->groupAttackOrMove(command.player, objs, command.pos);
+		break;
+	case CommandType::Build:
+		if (entity) {
+			if (this->vault->registry.has<Building>(entity) && !this->vault->registry.get<Building>(entity).construction) {
+				EntityID consEnt = this->vault->factory.startBuilding(this->vault->registry, command.name, entity);
+				// need to reload the parent building to assign construction
+				this->vault->registry.get<Building>(entity).construction = consEnt;
+			}
+		} else if (command.objs.size() == 0 && !player.rootConstruction) {
+			player.rootConstruction = this->vault->factory.startBuilding(this->vault->registry, command.name, 0);
+		}
+		break;
+	case CommandType::CancelBuild:
+		if (entity) {
+			if (this->vault->registry.has<Building>(entity)) {
+				Building &building = this->vault->registry.get<Building>(entity);
+				if (building.construction) {
+					this->vault->factory.destroyEntity(this->vault->registry, building.construction);
+					building.construction = 0;
+				}
+			}
+		} else if (command.objs.size() == 0 && player.rootConstruction) {
+			this->vault->factory.destroyEntity(this->vault->registry, player.rootConstruction);
+			player.rootConstruction = 0;
+		}
+		break;
+	case CommandType::Preview:
+		if (entity && !this->vault->registry.has<Tile>(entity)) {
+			this->vault->factory.finishBuilding(this->vault->registry, entity, command.player, command.pos.x, command.pos.y, false);
+			GameController &controller = this->vault->registry.get<GameController>();
+			if (controller.currentPlayer == command.player && !controller.currentBuild) {
+				controller.action = Action::Build;
+				controller.currentBuild = entity;
+			}
+		}
+		break;
+	case CommandType::CancelPreview:
+		if (entity && this->vault->registry.has<Tile>(entity) && !this->vault->registry.get<GameObject>(entity).mapped) {
+			this->vault->registry.remove<Tile>(entity);
+			this->resetController(command.player, entity, Action::None);
+			this->markUpdateLayer = true;
+		}
+		break;
+	case CommandType::Place:
+		if (entity && !this->vault->registry.get<GameObject>(entity).mapped) {
+			if (!this->vault->registry.has<Tile>(entity))
+				this->vault->factory.finishBuilding(this->vault->registry, entity, command.player, command.pos.x, command.pos.y, false);
+
+			Tile &tile = this->vault->registry.get<Tile>(entity);
+			tile.pos = command.pos;
+			tile.ppos = sf::Vector2f(tile.pos) * 32.0f + 16.0f;
+
+			if (this->canBuild(command.player, entity).size() == 0) {
+				if (!this->vault->factory.placeBuilding(this->vault->registry, entity)) {
+					player.rootConstruction = 0;
+				}
+				this->resetController(command.player, entity, Action::None);
+			} else {
+				// placed while the position got blocked, back to placing
+				this->resetController(command.player, entity, Action::Build);
+			}
+		}
+		break;
+	case CommandType::Train:
+		if (entity)
+			this->trainUnit(command.name, command.player, entity);
+		break;
+	case CommandType::Seed:
+		if (entity)
+			this->seedResources(player.resourceType, entity);
+		break;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <deque>
+#include <fstream>
+
+#include "GameSystem.hpp"
+#include "Replay.hpp"
+
+// player commands from the interface or from a replay, applied at the start of the next simulation step
+// commands refer to game objects by serial, entity ids depend on effects created when drawing
+class CommandSystem : public GameSystem {
+	std::deque<Command> queue;
+	std::ofstream record;
+	// interface commands are ignored while a replay plays
+	bool playing;
+
+public:
+	// a preview was removed from map, objects layer must be updated
+	bool markUpdateLayer;
+
+	CommandSystem();
+
+	void init() override;
+	void update(float dt) override;
+
+	bool startRecord(std::string filename, const MatchSettings &settings);
+	void play(const Replay &replay);
+
+	void receive(const CommandIssued &event);
+
+private:
+	void apply(const Command &command);
+
+	std::vector<unsigned long> serials(const std::vector<EntityID> &entities);
+	std::vector<EntityID> entities(const std::vector<unsigned long> &serials);
+	void resetController(EntityID playerEnt, EntityID entity, Action action);
+};
@@ -21,6 +21,7 @@ void DeletionSystem::update(float dt) {
 
 				if (this->vault->registry.has<Unit>(entity)) {
 					Unit &unit = this->vault->registry.get<Unit>(entity);
+					this->map->influence.remove(entity);
 					EntityID corpseEnt = corpses_and_ruins[obj.name + "_corpse_" + std::to_string(obj.player)];
 //					std::cout << "DeletionSystem: set corpse " << obj.name + "_corpse" << " " << corpseEnt << " at " << tile.pos.x << " " << tile.pos.y << std::endl;
 					this->map->corpses.set(tile.pos.x, tile.pos.y, corpseEnt);
@@ -64,11 +65,11 @@ void DeletionSystem::initCorpse(std::string name, EntityID playerEnt) {
 	tile.z = 0;
 
 	tile.sprite.setTexture(this->vault->factory.getTex(name));
-	tile.state = "die";
+	tile.state = TileStateStr("die");
 	tile.shader = false;
 	this->vault->factory.setColorSwapShader(this->vault->registry, tile, playerEnt);
 
-	tile.sprite.setTextureRect(sf::IntRect(0, ((this->vault->factory.getTex(name).getSize().y / tile.psize.y) - 1)*tile.psize.y, tile.psize.x, tile.psize.y)); // texture need to be updated
+	tile.sprite.setTextureRect(sf::IntRect(0, ((this->vault->factory.getTexSize(name).y / tile.psize.y) - 1)*tile.psize.y, tile.psize.x, tile.psize.y)); // texture need to be updated
 
 	tile.centerRect = this->vault->factory.getCenterRect(name);
 
@@ -79,17 +80,17 @@ void DeletionSystem::initCorpse(std::string name, EntityID playerEnt) {
 
 void DeletionSystem::initRuin(std::string team, int i) {
 	EntityID ruinEnt;
-	int ruinHeight = this->vault->factory.getTex("ruin").getSize().y / 2;
+	int ruinHeight = this->vault->factory.getTexSize("ruin").y / 2;
 	Tile ruinTile;
 	ruinTile.pos = sf::Vector2i(0, 0);
 	ruinTile.ppos = sf::Vector2f(ruinTile.pos) * (float)32.0;
 	ruinTile.shader = false;
-	ruinTile.psize = sf::Vector2f(this->vault->factory.getTex("ruin").getSize().x, ruinHeight);
+	ruinTile.psize = sf::Vector2f(this->vault->factory.getTexSize("ruin").x, ruinHeight);
 	ruinTile.sprite.setTexture(this->vault->factory.getTex("ruin"));
 	ruinTile.centerRect = this->vault->factory.getCenterRect("ruin");
 	ruinTile.sprite.setTextureRect(sf::IntRect(0, i * ruinHeight, ruinTile.psize.x, ruinTile.psize.y)); // texture need to be updated
 
-	ruinTile.state = "idle";
+	ruinTile.state = TileStateStr("idle");
 	ruinEnt = this->vault->registry.create();
 	this->vault->registry.assign<Tile>(ruinEnt, ruinTile);
 	corpses_and_ruins[team + "_ruin"] = ruinEnt;
@@ -1,6 +1,7 @@
 #include "DrawMapSystem.hpp"
 
 DrawMapSystem::DrawMapSystem() {
+	this->drawCalls = 0;
 }
 
 void DrawMapSystem::init() {
@@ -9,6 +10,7 @@ void DrawMapSystem::init() {
 }
 
 void DrawMapSystem::draw(sf::RenderWindow &window, sf::IntRect clip, float dt) {
+	this->drawCalls = 0;
 	this->drawTerrainTileMap(window, dt);
 	this->drawTileLayers(window, clip, dt);
 	this->drawObjLayer(window, clip, dt);
@@ -51,6 +53,7 @@ void DrawMapSystem::drawEntityLayer(sf::RenderTarget & target, Layer<EntityID> &
 #else
 				target.draw(tile.sprite);
 #endif
+				this->drawCalls++;
 			}
 		}
 
@@ -63,6 +66,7 @@ void DrawMapSystem::drawTileLayers(sf::RenderTarget & target, sf::IntRect clip,
 
 // reduce object list to visible entities
 void DrawMapSystem::updateObjsDrawList(sf::RenderWindow & window, sf::IntRect clip, float dt) {
+	ProfileZone zone(PROFILE_SITE("objsDrawList", "draw"));
 	this->entitiesDrawList.clear();
 
 	// resources draw list
@@ -174,6 +178,7 @@ void DrawMapSystem::drawObjLayer(sf::RenderWindow & window, sf::IntRect clip, fl
 
 				shadow.setPosition(spos);
 				window.draw(shadow);
+				this->drawCalls++;
 			}
 
 			sf::Vector2f pos = this->tileDrawPosition(tile);
@@ -195,6 +200,7 @@ void DrawMapSystem::drawObjLayer(sf::RenderWindow & window, sf::IntRect clip, fl
 			} else {
 				window.draw(tile.sprite);
 			}
+			this->drawCalls++;
 
 			// life bar
 			if (this->vault->registry.has<GameObject>(ent)) {
@@ -232,6 +238,7 @@ void DrawMapSystem::drawObjLayer(sf::RenderWindow & window, sf::IntRect clip, fl
 					lifeBar.setPosition(lpos);
 
 					window.draw(lifeBar);
+					this->drawCalls += 2;
 				}
 			}
 		}
@@ -342,12 +349,16 @@ void DrawMapSystem::drawTerrainTileMap(sf::RenderWindow &window, float dt) {
 	for (auto &layer : terrainsTileMap.layers) {
 		window.draw(layer);
 	}
+	this->drawCalls += terrainsTileMap.layers.size();
 }
 
+// fog is drawn last
 void DrawMapSystem::drawFogTileMap(sf::RenderWindow &window, float dt) {
 	for (auto &layer : fogTileMap.layers) {
 		window.draw(layer);
 	}
+	this->drawCalls += fogTileMap.layers.size();
+	Profiler::get().setCount(PROFILE_COUNTER("map draw calls"), this->drawCalls);
 }
 
 void DrawMapSystem::update(float dt) {
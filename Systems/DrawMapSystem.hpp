@@ -8,6 +8,8 @@ public:
 	std::vector<EntityID> entitiesDrawList;
 	TileMap terrainsTileMap;
 	TileMap fogTileMap;
+	// sprites and tile maps drawn this frame, debug drawing left out
+	unsigned int drawCalls;
 
 	DrawMapSystem();
 
@@ -38,7 +38,7 @@ void FxSystem::createEffect(const EffectCreate &event) {
 
 				this->vault->dispatcher.trigger<EffectCreated>(event.name, entity);
 
-				Timer timer(name, effect.lifetime, false);
+				Timer timer(TimerNameStr(name.c_str()), effect.lifetime, false);
 				this->vault->registry.assign<Timer>(entity, timer);
 			}
 		}
@@ -52,7 +52,7 @@ void FxSystem::createEffect(const EffectCreate &event) {
 
 		this->vault->dispatcher.trigger<EffectCreated>(event.name, entity);
 
-		Timer timer(name, effect.lifetime, false);
+		Timer timer(TimerNameStr(name.c_str()), effect.lifetime, false);
 		this->vault->registry.assign<Timer>(entity, timer);
 	}
 #endif
@@ -84,11 +84,10 @@ void FxSystem::destroyEffects(float dt) {
 }
 
 void FxSystem::update(float dt) {
-	float gameDt = 0.033 / dt * 0.033;
-
-	this->createEffects(gameDt);
-	this->destroyEffects(gameDt);
+	this->createEffects(dt);
+	this->destroyEffects(dt);
 
+	long particles = 0;
 	auto view = this->vault->registry.persistent<ParticleEffect, Timer>();
 	for (EntityID entity : view) {
 		ParticleEffect &effect = view.get<ParticleEffect>(entity);
@@ -104,8 +103,10 @@ void FxSystem::update(float dt) {
 			this->vault->dispatcher.trigger<EffectDestroy>(entity);
 		} else {
 			effect.particleSystem->update(dt);
+			particles += effect.particleSystem->countAlive();
 		}
 	}
+	Profiler::get().setCount(PROFILE_COUNTER("live particles"), particles);
 }
 
 void FxSystem::clear() {
@@ -1,10 +1,12 @@
 #include "GameGeneratorSystem.hpp"
 
 void GameGeneratorSystem::generateMap(unsigned int width, unsigned int height) {
+	MatchRandom &random = this->matchRandom();
+
 	this->map->setSize(width, height);
 
-	float random_w = ((float) rand()) / (float) RAND_MAX;
-	float random_h = ((float) rand()) / (float) RAND_MAX;
+	float random_w = random.uniform();
+	float random_h = random.uniform();
 
 	SimplexNoise simpl(width / 64.0, height / 64.0, 2.0, 0.5);
 
@@ -14,19 +16,19 @@ void GameGeneratorSystem::generateMap(unsigned int width, unsigned int height) {
 
 			EntityID t;
 
-			t = Dirt + (rand() % ALT_TILES);
+			t = Dirt + random.range(ALT_TILES);
 			this->map->terrainsForTransitions.set(x, y, Dirt);
 
 			// sand
 			if (res < -0.2) {
-				t = Sand + (rand() % ALT_TILES);
+				t = Sand + random.range(ALT_TILES);
 				this->map->staticBuildable.set(x, y, t);
 				this->map->terrainsForTransitions.set(x, y, Sand);
 			}
 
 			// water
 			if (res < -0.4) {
-				t = Water + (rand() % ALT_TILES);
+				t = Water + random.range(ALT_TILES);
 
 				this->map->staticBuildable.set(x, y, t);
 				this->map->staticPathfinding.set(x, y, t);
@@ -37,7 +39,7 @@ void GameGeneratorSystem::generateMap(unsigned int width, unsigned int height) {
 
 			// add some random ressources
 			if (res > 0.6 && res < 0.61) {
-				float rnd = ((float) rand()) / (float) RAND_MAX;
+				float rnd = random.uniform();
 				if (rnd > 0.5) {
 					this->vault->factory.plantResource(this->vault->registry, "nature", x, y);
 				} else {
@@ -49,8 +51,8 @@ void GameGeneratorSystem::generateMap(unsigned int width, unsigned int height) {
 
 	for (auto pair : this->vault->factory.decorGenerator) {
 		for (int i = 0; i < (this->map->width * this->map->height) / pair.second; i++) {
-			int rx = rand() % this->map->width;
-			int ry = rand() % this->map->height;
+			int rx = random.range(this->map->width);
+			int ry = random.range(this->map->height);
 			if (this->map->terrainsForTransitions.get(rx, ry) != Water) {
 				this->vault->factory.createDecor(this->vault->registry, pair.first, rx, ry);
 			}
@@ -74,15 +76,31 @@ void GameGeneratorSystem::generateMap(unsigned int width, unsigned int height) {
 	}
 }
 
-EntityID GameGeneratorSystem::generate(int mapWidth, int mapHeight, std::string playerTeam) {
-	EntityID currentPlayer;
+EntityID GameGeneratorSystem::generate(int mapWidth, int mapHeight, std::string playerTeam, std::vector<std::string> aiTeams, const Scenario *scenario) {
+	EntityID currentPlayer = 0;
+	std::vector<EntityID> scenarioPlayers;
 
 	this->generateMap(mapWidth, mapHeight);
 
 	std::vector<int> colorIndices = this->generateColorIndices();
 	std::vector<sf::Vector2i> initialPositions = this->generateInitialPositions();
 
-	if (playerTeam == "rebel") {
+	if (scenario) {
+		if (playerTeam == "neutral")
+			currentPlayer = this->vault->factory.createPlayer(this->vault->registry, "neutral", false);
+
+		for (ScenarioPlayer const &scenarioPlayer : scenario->players) {
+			bool human = !currentPlayer && scenarioPlayer.team == playerTeam;
+			EntityID playerEnt = this->vault->factory.createPlayer(this->vault->registry, scenarioPlayer.team, !human);
+			if (human)
+				currentPlayer = playerEnt;
+			scenarioPlayers.push_back(playerEnt);
+		}
+
+		// no scenario player of the team, watch them
+		if (!currentPlayer)
+			currentPlayer = this->vault->factory.createPlayer(this->vault->registry, "neutral", false);
+	} else if (playerTeam == "rebel") {
 		currentPlayer = this->vault->factory.createPlayer(this->vault->registry, "rebel", false);
 		this->vault->factory.createPlayer(this->vault->registry, "neonaz", true);
 	} else if (playerTeam == "neonaz") {
@@ -90,11 +108,17 @@ EntityID GameGeneratorSystem::generate(int mapWidth, int mapHeight, std::string
 		this->vault->factory.createPlayer(this->vault->registry, "rebel", true);
 	} else {
 		currentPlayer = this->vault->factory.createPlayer(this->vault->registry, "neutral", false);
-		this->vault->factory.createPlayer(this->vault->registry, "rebel", true);
-		this->vault->factory.createPlayer(this->vault->registry, "neonaz", true);
+		if (aiTeams.size() == 0) {
+			aiTeams.push_back("rebel");
+			aiTeams.push_back("neonaz");
 
-		this->vault->factory.createPlayer(this->vault->registry, "rebel", true);
-		this->vault->factory.createPlayer(this->vault->registry, "neonaz", true);
+			aiTeams.push_back("rebel");
+			aiTeams.push_back("neonaz");
+		}
+
+		for (std::string const &team : aiTeams) {
+			this->vault->factory.createPlayer(this->vault->registry, team, true);
+		}
 	}
 
 	auto view = this->vault->registry.view<Player>();
@@ -106,7 +130,9 @@ EntityID GameGeneratorSystem::generate(int mapWidth, int mapHeight, std::string
 		player.color = this->vault->factory.getPlayerColor(refCol, player.colorIdx);
 		colorIndices.pop_back();
 
-		if (player.team == "rebel")
+		if (scenario) {
+			// placed by populate
+		} else if (player.team == "rebel")
 		{
 			player.initialPos = initialPositions.back();
 			initialPositions.pop_back();
@@ -135,6 +161,9 @@ EntityID GameGeneratorSystem::generate(int mapWidth, int mapHeight, std::string
 		player.fog.fill();
 	}
 
+	if (scenario)
+		this->populate(*scenario, scenarioPlayers, initialPositions);
+
 	return currentPlayer;
 }
 
@@ -143,7 +172,7 @@ std::vector<int> GameGeneratorSystem::generateColorIndices() {
 	for (int i = 0; i < 12; i++ ) {
 		colorIndices.push_back(i);
 	}
-	std::random_shuffle ( colorIndices.begin(), colorIndices.end() );
+	this->matchRandom().shuffle(colorIndices.begin(), colorIndices.end());
 	return colorIndices;
 }
 
@@ -157,6 +186,126 @@ std::vector<sf::Vector2i> GameGeneratorSystem::generateInitialPositions() {
 	initialPositions.push_back(this->getInitialPosition(sf::Vector2i(10, this->map->width - 10)));
 	initialPositions.push_back(this->getInitialPosition(sf::Vector2i(this->map->height - 10, 10)));
 	initialPositions.push_back(this->getInitialPosition(sf::Vector2i(this->map->width - 10, this->map->height - 10)));
-	std::random_shuffle ( initialPositions.begin(), initialPositions.end() );
+	this->matchRandom().shuffle(initialPositions.begin(), initialPositions.end());
 	return initialPositions;
 }
+
+void GameGeneratorSystem::populate(const Scenario &scenario, const std::vector<EntityID> &players, std::vector<sf::Vector2i> initialPositions) {
+	this->scenarioOrders.clear();
+
+	for (size_t i = 0; i < players.size(); ++i) {
+		ScenarioPlayer const &scenarioPlayer = scenario.players[i];
+		sf::Vector2i initialPos = scenarioPlayer.pos;
+		if (!scenarioPlayer.hasPos) {
+			initialPos = initialPositions.back();
+			initialPositions.pop_back();
+		}
+		this->vault->registry.get<Player>(players[i]).initialPos = initialPos;
+
+		for (ScenarioGroup const &group : scenarioPlayer.groups) {
+			ScenarioOrderedUnits ordered;
+			ordered.player = players[i];
+			ordered.order = group.order;
+
+			unsigned int placed = 0;
+			for (unsigned int cluster = 0; cluster < group.clusters; ++cluster) {
+				sf::Vector2i center = this->clusterCenter(initialPos, group.spread);
+				// first clusters take the remainder
+				unsigned int count = group.count / group.clusters + (cluster < group.count % group.clusters ? 1 : 0);
+
+				for (unsigned int n = 0; n < count; ++n) {
+					EntityID entity = group.building ? this->placeBuilding(players[i], group.name, center) : this->placeUnit(players[i], group.name, center);
+					if (!entity)
+						break;
+					if (!group.building)
+						ordered.units.push_back(entity);
+					placed++;
+				}
+			}
+
+			if (placed < group.count)
+				std::cout << "Scenario: only " << placed << "/" << group.count << " " << group.name << " placed for player " << players[i] << std::endl;
+
+			if (ordered.order.type.size() > 0 && ordered.units.size() > 0)
+				this->scenarioOrders.push_back(ordered);
+		}
+	}
+}
+
+void GameGeneratorSystem::orderScenarioUnits() {
+	for (ScenarioOrderedUnits &ordered : this->scenarioOrders) {
+		sf::Vector2i pos = ordered.order.pos;
+		pos.x = std::max(0, std::min(pos.x, (int)this->map->width - 1));
+		pos.y = std::max(0, std::min(pos.y, (int)this->map->height - 1));
+
+		if (ordered.order.type == "move") {
+			this->groupGoTo(ordered.units, pos, GroupFormation::Square, North, false);
+		} else if (ordered.order.type == "attack") {
+			this->groupAttackOrBomb(ordered.player, ordered.units, pos);
+		} else {
+			this->groupAttackOrMove(ordered.player, ordered.units, pos);
+		}
+	}
+	this->scenarioOrders.clear();
+}
+
+sf::Vector2i GameGeneratorSystem::clusterCenter(sf::Vector2i pos, int spread) {
+	MatchRandom &random = this->matchRandom();
+	sf::Vector2i center(pos.x + random.range(spread * 2 + 1) - spread, pos.y + random.range(spread * 2 + 1) - spread);
+	center.x = std::max(0, std::min(center.x, (int)this->map->width - 1));
+	center.y = std::max(0, std::min(center.y, (int)this->map->height - 1));
+	return center;
+}
+
+// objs layer is only built on the first update, placed objects are marked on it to keep them apart
+EntityID GameGeneratorSystem::placeUnit(EntityID playerEnt, std::string name, sf::Vector2i center) {
+	sf::Vector2i pos = this->firstAvailablePosition(center, 0, std::max(this->map->width, this->map->height));
+	if (!this->map->positionAvailable(pos.x, pos.y))
+		return 0;
+
+	EntityID entity = this->vault->factory.createUnit(this->vault->registry, playerEnt, name, pos.x, pos.y);
+	this->map->objs.set(pos.x, pos.y, entity);
+	return entity;
+}
+
+EntityID GameGeneratorSystem::placeBuilding(EntityID playerEnt, std::string name, sf::Vector2i center) {
+	EntityID entity = this->vault->factory.startBuilding(this->vault->registry, name, 0);
+	this->vault->factory.finishBuilding(this->vault->registry, entity, playerEnt, center.x, center.y, false);
+	// already built
+	this->vault->registry.get<Building>(entity).buildTime = 0;
+
+	Tile &tile = this->vault->registry.get<Tile>(entity);
+	int maxDist = std::max(this->map->width, this->map->height);
+	for (int dist = 0; dist < maxDist; ++dist) {
+		for (int w = -dist; w < dist + 1; ++w) {
+			for (int h = -dist; h < dist + 1; ++h) {
+				if (w == -dist || h == -dist || w == dist || h == dist) {
+					tile.pos = sf::Vector2i(center.x + w, center.y + h);
+					if (this->buildingFits(tile)) {
+						tile.ppos = sf::Vector2f(tile.pos) * 32.0f + 16.0f;
+						for (sf::Vector2i const &p : this->tileSurface(tile)) {
+							this->map->objs.set(p.x, p.y, entity);
+						}
+						this->vault->factory.placeBuilding(this->vault->registry, entity);
+						return entity;
+					}
+				}
+			}
+		}
+	}
+
+	this->vault->factory.destroyEntity(this->vault->registry, entity);
+	return 0;
+}
+
+// whole surface on the map, free with a tile around to walk by
+bool GameGeneratorSystem::buildingFits(Tile &tile) {
+	if ((int)this->tileSurface(tile).size() != tile.size.x * tile.size.y)
+		return false;
+
+	for (sf::Vector2i const &p : this->tileSurfaceExtended(tile, 1)) {
+		if (this->map->objs.get(p.x, p.y) || this->map->staticBuildable.get(p.x, p.y) != 0)
+			return false;
+	}
+	return true;
+}
@@ -1,16 +1,37 @@
 #pragma once
 
 #include "GameSystem.hpp"
+#include "Scenario.hpp"
 
 #include "third_party/SimplexNoise.h"
 
 #define ALT_TILES 3
 
+// units of a scenario group waiting for their order
+struct ScenarioOrderedUnits {
+	EntityID player;
+	ScenarioOrder order;
+	std::vector<EntityID> units;
+};
+
 class GameGeneratorSystem : public GameSystem {
+	std::vector<ScenarioOrderedUnits> scenarioOrders;
+
 public:
-	EntityID generate(int mapWidth, int mapHeight, std::string playerTeam);
+	// neutral player team watches aiTeams players, two rebel and two neonaz if empty
+	// scenario players replace aiTeams and the starting units, player team controls the first scenario player of its team
+	EntityID generate(int mapWidth, int mapHeight, std::string playerTeam, std::vector<std::string> aiTeams = std::vector<std::string>(), const Scenario *scenario = nullptr);
+
+	// scenario orders need pathfinding and steering to be initialized
+	void orderScenarioUnits();
 
 private:
+	void populate(const Scenario &scenario, const std::vector<EntityID> &players, std::vector<sf::Vector2i> initialPositions);
+	sf::Vector2i clusterCenter(sf::Vector2i pos, int spread);
+	EntityID placeUnit(EntityID playerEnt, std::string name, sf::Vector2i center);
+	EntityID placeBuilding(EntityID playerEnt, std::string name, sf::Vector2i center);
+	bool buildingFits(Tile &tile);
+
 	void generateMap(unsigned int width, unsigned int height);
 	std::vector<int> generateColorIndices();
 	sf::Vector2i getInitialPosition(sf::Vector2i pos);
@@ -13,12 +13,25 @@ void GameSystem::setShared(GameVault *vault, Map *map, int screenWidth, int scre
 	this->screenHeight = screenHeight;
 }
 
+MatchRandom &GameSystem::matchRandom() {
+	return this->vault->registry.get<MatchRandom>();
+}
+
 sf::Vector2f GameSystem::tileDrawPosition(Tile &tile) const {
-	return sf::Vector2f(tile.ppos.x - (tile.centerRect.left + tile.centerRect.width / 2) + tile.offset.x * 32,
-	                    tile.ppos.y - (tile.centerRect.top + tile.centerRect.height / 2) + tile.offset.y * 32
+	sf::Vector2f ppos = this->tileInterpolatedPosition(tile);
+	return sf::Vector2f(ppos.x - (tile.centerRect.left + tile.centerRect.width / 2) + tile.offset.x * 32,
+	                    ppos.y - (tile.centerRect.top + tile.centerRect.height / 2) + tile.offset.y * 32
 	                   );
 }
 
+// pixel pos between the last two simulation steps, tiles not moved by the last step are drawn at ppos
+sf::Vector2f GameSystem::tileInterpolatedPosition(Tile &tile) const {
+	SimulationClock &clock = this->vault->registry.get<SimulationClock>();
+	if (tile.lastStep != clock.steps)
+		return tile.ppos;
+	return tile.lastPpos + (tile.ppos - tile.lastPpos) * clock.alpha;
+}
+
 
 sf::Vector2i GameSystem::tilePosition(Tile &tile, sf::Vector2i p) const {
 	return sf::Vector2i(tile.pos.x + (p.x - tile.size.x / 2) + tile.offset.x,
@@ -165,15 +178,16 @@ bool GameSystem::targetInRange(Tile &tile, sf::Vector2i targetPos, int range, in
 	return false;
 }
 
-void GameSystem::addPlayerFrontPoint(EntityID playerEnt, EntityID ent, sf::Vector2i pos) {
+// damage received by a player worth defending: buildings, or units near its base
+void GameSystem::addThreat(EntityID playerEnt, EntityID ent, sf::Vector2i pos, float damage) {
 	Player &player = this->vault->registry.get<Player>(playerEnt);
 	if (this->vault->registry.has<Unit>(ent)) {
 		if (distance(player.initialPos, pos) < distance(sf::Vector2i(0, 0), sf::Vector2i(this->map->width, this->map->height)) / 4) {
-			player.allFrontPoints.push_back(pos);
+			this->map->influence.addThreat(TeamIDStr(player.team.c_str()), pos, damage);
 		}
 	} else {
 		if (this->vault->registry.has<Building>(ent)) {
-			player.allFrontPoints.push_back(pos);
+			this->map->influence.addThreat(TeamIDStr(player.team.c_str()), pos, damage);
 		}
 	}
 }
@@ -227,7 +241,7 @@ void GameSystem::spendResources(EntityID playerEnt, std::string type, int val) {
 	}
 }
 
-void GameSystem::changeState(EntityID entity, std::string state) {
+void GameSystem::changeState(EntityID entity, TileState state) {
 	Tile &tile = this->vault->registry.get<Tile>(entity);
 	if (tile.state != state) {
 		this->vault->dispatcher.trigger<StateChanged>(entity, tile.state, tile.view, state);
@@ -244,18 +258,24 @@ void GameSystem::playRandomUnitSound(EntityID ent, std::string state) {
 
 void GameSystem::playRandomUnitSound(GameObject & obj, Unit & unit, std::string state) {
 	if (unit.soundActions[state] > 0) {
+		// not from the match random, sounds are also played on unrecorded selections
 		int rnd = rand() % unit.soundActions[state];
 		std::string sname = obj.name + "_" + state + "_" + std::to_string(rnd);
 		this->vault->dispatcher.trigger<SoundPlay>(sname, 3, true, sf::Vector2i{0, 0});
 	}
 }
 
+// player commands are applied by CommandSystem at the next step, to be recorded and replayed
+void GameSystem::issueCommand(CommandType type, EntityID playerEnt, std::vector<EntityID> entities, sf::Vector2i pos, std::string name) {
+	this->vault->dispatcher.trigger<CommandIssued>(type, playerEnt, entities, pos, name);
+}
+
 // action
 void GameSystem::seedResources(std::string type, EntityID entity) {
 	if (this->vault->registry.valid(entity) && this->vault->registry.has<Tile>(entity)) { // FIXME: weird
 		Tile &tile = this->vault->registry.get<Tile>(entity);
 		for (sf::Vector2i const &p : this->tileAround(tile, 1, 2)) {
-			float rnd = ((float) rand()) / (float) RAND_MAX;
+			float rnd = this->matchRandom().uniform();
 			if (rnd > 0.85) {
 				if (!this->map->resources.get(p.x, p.y) &&
 				        !this->map->objs.get(p.x, p.y) && this->map->staticBuildable.get(p.x, p.y) == 0) {
@@ -382,6 +402,18 @@ void GameSystem::groupGoTo(std::vector<EntityID> &group, sf::Vector2i destpos, G
 			}
 			break;
 		}
+
+		// one field for the whole group, formation positions are reached with per unit paths in the final sector
+		if (group.size() >= GROUP_FLOWFIELD_MIN_UNITS) {
+			std::shared_ptr<GroupFlowField> groupField = std::make_shared<GroupFlowField>(destpos);
+			for (EntityID entity : group) {
+				if (this->vault->registry.has<Unit>(entity)) {
+					Unit &unit = this->vault->registry.get<Unit>(entity);
+					unit.groupField = groupField;
+					unit.groupDest = unit.destpos;
+				}
+			}
+		}
 	}
 }
 
@@ -405,6 +437,7 @@ void GameSystem::goTo(Unit & unit, sf::Vector2i destpos) {
 	unit.pathUpdate = true;
 	unit.commanded = true;
 	unit.nopath = 0;
+	unit.groupField.reset();
 }
 
 void GameSystem::goTo(EntityID entity, sf::Vector2i destpos) {
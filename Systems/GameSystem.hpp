@@ -6,6 +6,7 @@
 #include "GameVault.hpp"
 #include "System.hpp"
 #include "Map.hpp"
+#include "Profiler.hpp"
 
 #include "third_party/entt/signal/dispatcher.hpp"
 
@@ -20,7 +21,10 @@ public:
 
 	void setShared(GameVault *vault, Map *map, int screenWidth, int screenHeight);
 
+	MatchRandom &matchRandom();
+
 	sf::Vector2f tileDrawPosition(Tile &tile) const;
+	sf::Vector2f tileInterpolatedPosition(Tile &tile) const;
 	sf::Vector2i tilePosition(Tile &tile, sf::Vector2i p) const;
 	std::vector<sf::Vector2i> tileSurface(Tile &tile) const;
 	std::vector<sf::Vector2i> vectorSurfaceExtended(sf::Vector2i pos, int dist) const;
@@ -32,18 +36,20 @@ public:
 	EntityID ennemyAtPosition(EntityID playerEnt, int x, int y);
 	bool targetInRange(Tile &tile, sf::Vector2i targetPos, int range, int maxRange);
 	bool ennemyInRange(Tile &tile, Tile &destTile, int range, int maxRange);
-	void addPlayerFrontPoint(EntityID playerEnt, EntityID ent, sf::Vector2i pos);
+	void addThreat(EntityID playerEnt, EntityID ent, sf::Vector2i pos, float damage);
 	std::vector<sf::Vector2i> canBuild(EntityID playerEnt, EntityID entity);
 
 	bool canSpendResources(EntityID playerEnt, std::string type, int val);
 
 	void spendResources(EntityID playerEnt, std::string type, int val);
 
-	void changeState(EntityID entity, std::string state);
+	void changeState(EntityID entity, TileState state);
 
 	void playRandomUnitSound(EntityID ent, std::string state);
 	void playRandomUnitSound(GameObject & obj, Unit & unit, std::string state);
 
+	void issueCommand(CommandType type, EntityID playerEnt, std::vector<EntityID> entities, sf::Vector2i pos, std::string name);
+
 // action
 	void seedResources(std::string type, EntityID entity);
 	bool trainUnit(std::string type, EntityID playerEnt, EntityID entity );
@@ -1,5 +1,22 @@
 #include "InterfaceSystem.hpp"
 
+// states are hashed, only known names can be shown back
+static const char *tileStateName(TileState state) {
+	switch (state) {
+	case TileStateStr("idle"):
+		return "idle";
+	case TileStateStr("move"):
+		return "move";
+	case TileStateStr("attack"):
+		return "attack";
+	case TileStateStr("die"):
+		return "die";
+	case TileStateStr("destroy"):
+		return "destroy";
+	default:
+		return "unknown";
+	}
+}
 
 void InterfaceSystem::init() {
 	GameController &controller = this->vault->registry.get<GameController>();
@@ -143,8 +160,8 @@ void InterfaceSystem::constructionProgressGui(EntityID consEnt) {
 			if (ImGui::ImageButtonAnim(this->vault->factory.texManager.getRef(objCons.name + "_icon_built"),
 			                           this->vault->factory.texManager.getRef(objCons.name + "_icon_built"),
 			                           this->vault->factory.texManager.getRef(objCons.name + "_icon_built_down"))) {
-				controller.action = Action::Build;
-				controller.currentBuild = this->vault->factory.finishBuilding(this->vault->registry, consEnt, controller.currentPlayer, 8, 8, false);
+				// controller builds it once the preview is created
+				this->issueCommand(CommandType::Preview, controller.currentPlayer, {consEnt}, sf::Vector2i(8, 8), "");
 			}
 			ImGui::SameLine();
 		}
@@ -224,8 +241,7 @@ void InterfaceSystem::actionGui() {
 						if (ImGui::ImageButtonAnim(this->vault->factory.texManager.getRef(player.team + "_cancel"),
 						                           this->vault->factory.texManager.getRef(player.team + "_cancel"),
 						                           this->vault->factory.texManager.getRef(player.team + "_cancel_down"))) {
-							this->vault->factory.destroyEntity(this->vault->registry, building.construction);
-							building.construction = 0;
+							this->issueCommand(CommandType::CancelBuild, controller.currentPlayer, {selectedObj}, sf::Vector2i(0, 0), "");
 						}
 					} else {
 						if (pnode->children.size() > 0) {
@@ -237,20 +253,15 @@ void InterfaceSystem::actionGui() {
 									switch (node.comp) {
 									case TechComponent::Building: {
 										if (!building.construction) {
-											EntityID newConsEnt = this->vault->factory.startBuilding(this->vault->registry, node.type, selectedObj);
-											// need to reload the parent building to assign construction
-											Building &pBuilding = this->vault->registry.get<Building>(selectedObj);
-											pBuilding.construction = newConsEnt;
+											this->issueCommand(CommandType::Build, controller.currentPlayer, {selectedObj}, sf::Vector2i(0, 0), node.type);
 										}
 									}
 									break;
 									case TechComponent::Character:
-										if (this->trainUnit(node.type, controller.currentPlayer, selectedObj)) {
-//											this->markUpdateLayer = true;
-										}
+										this->issueCommand(CommandType::Train, controller.currentPlayer, {selectedObj}, sf::Vector2i(0, 0), node.type);
 										break;
 									case TechComponent::Resource:
-										this->seedResources(player.resourceType, selectedObj);
+										this->issueCommand(CommandType::Seed, controller.currentPlayer, {selectedObj}, sf::Vector2i(0, 0), "");
 										break;
 									}
 								}
@@ -322,8 +333,7 @@ void InterfaceSystem::actionGui() {
 						                           this->vault->factory.texManager.getRef(player.team + "_cancel"),
 						                           this->vault->factory.texManager.getRef(player.team + "_cancel_down"))) {
 
-							this->vault->factory.destroyEntity(this->vault->registry, player.rootConstruction);
-							player.rootConstruction = 0;
+							this->issueCommand(CommandType::CancelBuild, controller.currentPlayer, {}, sf::Vector2i(0, 0), "");
 						}
 					} else {
 						TechNode *node = this->vault->factory.getTechRoot(player.team);
@@ -331,7 +341,7 @@ void InterfaceSystem::actionGui() {
 						                           this->vault->factory.texManager.getRef(node->type + "_icon"),
 						                           this->vault->factory.texManager.getRef(node->type + "_icon_down"))) {
 							if (!player.rootConstruction)
-								player.rootConstruction = this->vault->factory.startBuilding(this->vault->registry, node->type, 0);
+								this->issueCommand(CommandType::Build, controller.currentPlayer, {}, sf::Vector2i(0, 0), node->type);
 						}
 						if (ImGui::IsItemHovered()) {
 							ImGui::PushFont(ImGui::GetIO().Fonts->Fonts[1]);
@@ -351,7 +361,46 @@ void InterfaceSystem::actionGui() {
 }
 
 
-void InterfaceSystem::debugGui(sf::RenderWindow &window, sf::View &view, int *gameSpeed, float dt) {
+// zones grouped by category, last durations min/avg/p99
+void InterfaceSystem::profilerGui() {
+	Profiler &profiler = Profiler::get();
+
+	std::map<std::string, std::vector<std::pair<std::string, ProfileZoneStats>>> categories;
+	for (auto &pair : profiler.zoneStats()) {
+		categories[pair.second.category].push_back(pair);
+	}
+
+	for (auto &category : categories) {
+		ImGui::Text("%-16s %8s %8s %8s %8s", category.first.c_str(), "calls", "min ms", "avg ms", "p99 ms");
+		for (auto &pair : category.second) {
+			ProfileZoneStats &stats = pair.second;
+			ImGui::Text("  %-14s %8lu %8.3f %8.3f %8.3f", pair.first.c_str(), stats.calls, stats.min(), stats.avg(), stats.percentile(0.99f));
+		}
+	}
+
+	ImGui::Separator();
+	for (auto &pair : profiler.counterValues()) {
+		ImGui::Text("%s: %ld", pair.first.c_str(), pair.second);
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Trace: %d events", (int)profiler.traceSize());
+	ImGui::SameLine();
+	if (profiler.tracing) {
+		if (ImGui::Button("Stop trace"))
+			profiler.stopTrace();
+	} else {
+		if (ImGui::Button("Start trace"))
+			profiler.startTrace();
+		if (profiler.traceSize() > 0) {
+			ImGui::SameLine();
+			if (ImGui::Button("Save trace"))
+				profiler.writeTrace("bfr_trace.json");
+		}
+	}
+}
+
+void InterfaceSystem::debugGui(sf::RenderWindow &window, sf::View &view, int *gameSpeed, bool *turbo, float dt) {
 	GameController &controller = this->vault->registry.get<GameController>();
 	sf::Vector2f gamePos = (window.mapPixelToCoords(sf::Mouse::getPosition(window), view));
 	sf::Vector2f gameMapPos = gamePos;
@@ -368,6 +417,15 @@ void InterfaceSystem::debugGui(sf::RenderWindow &window, sf::View &view, int *ga
 	{
 		ImGui::Text("FPS: %.2f", 1 / dt);
 		ImGui::Text("Total Entities: %d", (int)this->vault->registry.size());
+
+		PathfindingStats &pathfindingStats = this->vault->registry.get<PathfindingStats>();
+		ImGui::Text("FlowFields cache: %d (hits %lu, misses %lu, invalidations %lu)", pathfindingStats.cacheSize,
+		            pathfindingStats.cacheHits, pathfindingStats.cacheMisses, pathfindingStats.cacheInvalidations);
+		ImGui::Text("Path requests: %d queued (latency p50 %u, p95 %u, p99 %u ticks)", pathfindingStats.queueDepth,
+		            pathfindingStats.latencyP50, pathfindingStats.latencyP95, pathfindingStats.latencyP99);
+		ImGui::Text("Path workers: %d (stale results %lu)", pathfindingStats.workers, pathfindingStats.staleResults);
+		if (ImGui::CollapsingHeader("Profiler"))
+			this->profilerGui();
 //		ImGui::Text("Drawn Entities: %d", (int)drawMap.entitiesDrawList.size());
 //		ImGui::Checkbox("Debug layer", &drawMap.showDebugLayer);
 
@@ -375,7 +433,9 @@ void InterfaceSystem::debugGui(sf::RenderWindow &window, sf::View &view, int *ga
 		ImGui::RadioButton("0", gameSpeed, 0); ImGui::SameLine();
 		ImGui::RadioButton("x1", gameSpeed, 1); ImGui::SameLine();
 		ImGui::RadioButton("x4", gameSpeed, 4); ImGui::SameLine();
-		ImGui::RadioButton("x16", gameSpeed, 16);
+		ImGui::RadioButton("x16", gameSpeed, 16); ImGui::SameLine();
+		ImGui::Checkbox("Turbo", turbo);
+		ImGui::Text("Simulation steps: %lu", this->vault->registry.get<SimulationClock>().steps);
 
 		if (controller.selectedDebugObj) {
 			EntityID selectedObj = controller.selectedDebugObj;
@@ -390,7 +450,7 @@ void InterfaceSystem::debugGui(sf::RenderWindow &window, sf::View &view, int *ga
 				ImGui::Text("Z: %d", tile.z);
 				ImGui::Text("Center: %dx%d:%dx%d", tile.centerRect.left, tile.centerRect.top, tile.centerRect.width, tile.centerRect.height);
 				ImGui::Text("View: %d", tile.view);
-				ImGui::Text("State: %s", tile.state.c_str());
+				ImGui::Text("State: %s (%llu)", tileStateName(tile.state), (unsigned long long)tile.state);
 
 				if (this->vault->registry.has<GameObject>(selectedObj)) {
 					GameObject &obj = this->vault->registry.get<GameObject>(selectedObj);
@@ -21,7 +21,7 @@ public:
 	void init() override;
 	void update(float dt) override;
 	void draw(sf::RenderWindow &window, sf::IntRect clip, float dt);
-	void debugGui(sf::RenderWindow &window, sf::View &view, int *gameSpeed, float dt);
+	void debugGui(sf::RenderWindow &window, sf::View &view, int *gameSpeed, bool *turbo, float dt);
 
 	void addSelected(EntityID entity);
 	void clearSelected() ;
@@ -31,5 +31,6 @@ private:
 	void gameStateGui();
 	void constructionProgressGui(EntityID consEnt);
 	void actionGui();
+	void profilerGui();
 
 };
\ No newline at end of file
@@ -1,8 +1,16 @@
 #include "MapLayersSystem.hpp"
 
+MapLayersSystem::MapLayersSystem() {
+	this->fogLayerPlayer = 0;
+}
+
 void MapLayersSystem::init() {
 	this->initTransitions();
 	this->updateAllTransitions();
+
+	this->sight.clear();
+	this->fogLayerPlayer = 0;
+	this->initSpectatorFog();
 }
 
 void MapLayersSystem::update(float dt) {
@@ -16,8 +24,12 @@ void MapLayersSystem::update(float dt) {
 void MapLayersSystem::updateFog(float dt) {
 	GameController &controller = this->vault->registry.get<GameController>();
 
-	this->updateSpectatorFog(controller.currentPlayer, dt);
 	this->updatePlayerFogLayer(controller.currentPlayer, dt);
+
+	auto playerView = this->vault->registry.view<Player>();
+	for (EntityID entity : playerView) {
+		playerView.get(entity).fog.clearChanged();
+	}
 }
 
 void MapLayersSystem::updateLayer(float dt) {
@@ -115,115 +127,95 @@ void MapLayersSystem::updateObjsLayer(float dt) {
 }
 
 void MapLayersSystem::updatePlayersFog(float dt) {
-	auto playerView = this->vault->registry.view<Player>();
+	auto fogOf = [this](EntityID playerEnt) -> Fog & {
+		return this->vault->registry.get<Player>(playerEnt).fog;
+	};
 
-	for (EntityID entity : playerView) {
-		Player &player = playerView.get(entity);
-//			for (FogState &state : player.fog.grid) {
-		for (int i = 0; i < player.fog.size(); ++i) {
-			FogState &state = player.fog.grid[i];
-			if (state == FogState::InSight)
-				state = FogState::Hidden;
-		}
-	}
+	this->sight.begin();
 
 	auto view = this->vault->registry.persistent<Tile, GameObject>();
 	for (EntityID entity : view) {
 		Tile &tile = view.get<Tile>(entity);
 		GameObject &obj = view.get<GameObject>(entity);
-		Player &player = this->vault->registry.get<Player>(obj.player);
 
-		if (obj.mapped) {
-//				sf::IntRect surfRect = this->tileSurfaceExtendedRect(tile, obj.view);
-
-			for (sf::Vector2i const &p : this->tileSurfaceExtended(tile, obj.view)) {
-				player.fog.set(p.x, p.y, FogState::InSight);
-			}
+		if (obj.mapped && !this->sight.keep(entity, obj.player, tile.pos, obj.view)) {
+			this->sight.see(entity, obj.player, tile.pos, obj.view, this->tileSurfaceExtended(tile, obj.view), fogOf);
 		}
-
 	}
+
+	this->sight.end(fogOf);
 }
 
-// spectator FOG concat all other players fog
-void MapLayersSystem::updateSpectatorFog(EntityID playerEnt, float dt) {
-	Player &player = this->vault->registry.get<Player>(playerEnt);
+void MapLayersSystem::initSpectatorFog() {
+	GameController &controller = this->vault->registry.get<GameController>();
+	Player &player = this->vault->registry.get<Player>(controller.currentPlayer);
 
 	if (player.team == "neutral") {
-		auto playerView = this->vault->registry.view<Player>();
 		for (int y = 0; y < this->map->height; ++y) {
 			for (int x = 0; x < this->map->width; ++x) {
 				player.fog.set(x, y, FogState::InSight);
 			}
 		}
 	}
-	/*
-	if (player.team == "neutral") {
-		auto playerView = this->vault->registry.view<Player>();
-		for (EntityID entity : playerView) {
-			if (entity != playerEnt) {
-				Player &otherPlayer = playerView.get(entity);
-				for (int y = 0; y < this->map->height; ++y) {
-					for (int x = 0; x < this->map->width; ++x) {
-						if (player.fog.get(x, y) == FogState::Hidden && otherPlayer.fog.get(x, y) != FogState::Unvisited) {
-							player.fog.set(x, y, otherPlayer.fog.get(x, y));
-						}
-						if (player.fog.get(x, y) == FogState::Unvisited) {
-							player.fog.set(x, y, otherPlayer.fog.get(x, y));
-						}
-					}
-				}
-			}
-		}
-	}
-	*/
 }
 
 void MapLayersSystem::updatePlayerFogLayer(EntityID playerEnt, float dt) {
 	Player &player = this->vault->registry.get<Player>(playerEnt);
 
-	for (int y = 0; y < this->map->height; ++y) {
-		for (int x = 0; x < this->map->width; ++x) {
-			sf::Vector2i p = sf::Vector2i(x, y);
-			FogState st = player.fog.get(x, y);
-			bool markUpdate = false;
-			int newEnt = 0;
-
-			if (st == FogState::Unvisited) {
-				newEnt = NotVisible;
-			} else {
-				newEnt = Visible;
+	if (playerEnt != this->fogLayerPlayer) {
+		this->fogLayerPlayer = playerEnt;
+		for (int y = 0; y < this->map->height; ++y) {
+			for (int x = 0; x < this->map->width; ++x) {
+				this->updateFogLayerCell(player.fog.get(x, y), x, y);
 			}
+		}
+	} else {
+		for (int idx : player.fog.changed) {
+			int x = idx % this->map->width;
+			int y = idx / this->map->width;
+			this->updateFogLayerCell(player.fog.get(x, y), x, y);
+		}
+	}
 
-			if (this->map->fogUnvisited.get(x, y) != newEnt)
-			{
-				markUpdate = true;
-			}
+#ifdef TRANSITIONS_DEBUG
+	std::cout << "Transitions: update " << this->map->markUpdateFogTransitions.size() << " FOG transitions" << std::endl;
+#endif
+}
 
-			this->map->fogUnvisited.set(x, y, newEnt);
+void MapLayersSystem::updateFogLayerCell(FogState st, int x, int y) {
+	bool markUpdate = false;
+	int newEnt = 0;
 
-			if (st == FogState::Hidden) {
-				newEnt = NotVisible;
-			} else {
-				newEnt = Visible;
-			}
+	if (st == FogState::Unvisited) {
+		newEnt = NotVisible;
+	} else {
+		newEnt = Visible;
+	}
 
-			if (this->map->fogHidden.get(x, y) != newEnt) {
-				markUpdate = true;
-			}
+	if (this->map->fogUnvisited.get(x, y) != newEnt)
+	{
+		markUpdate = true;
+	}
 
-			this->map->fogHidden.set(x, y, newEnt);
+	this->map->fogUnvisited.set(x, y, newEnt);
 
-			if (markUpdate) {
-				for (sf::Vector2i const &sp : this->vectorSurfaceExtended(p, 1)) {
-					this->map->markUpdateFogTransitions.insert(sp);
-				}
-			}
-		}
+	if (st == FogState::Hidden) {
+		newEnt = NotVisible;
+	} else {
+		newEnt = Visible;
 	}
 
-#ifdef TRANSITIONS_DEBUG
-	std::cout << "Transitions: update " << this->map->markUpdateFogTransitions.size() << " FOG transitions" << std::endl;
-#endif
+	if (this->map->fogHidden.get(x, y) != newEnt) {
+		markUpdate = true;
+	}
+
+	this->map->fogHidden.set(x, y, newEnt);
+
+	if (markUpdate) {
+		for (sf::Vector2i const &sp : this->vectorSurfaceExtended(sf::Vector2i(x, y), 1)) {
+			this->map->markUpdateFogTransitions.insert(sp);
+		}
+	}
 }
 
 // Terrains/Transitions
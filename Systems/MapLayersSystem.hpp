@@ -1,34 +1,44 @@
 #pragma once
 #include "Helpers.hpp"
 #include "GameSystem.hpp"
+#include "FogSight.hpp"
 
 class MapLayersSystem : public GameSystem {
 	std::map<int, int> terrainTransitionsMapping;
 	std::map<int, int> fogTransitionsMapping;
 
+	FogSight sight;
+	// player shown by the fog layers, they are rebuilt when it changes
+	EntityID fogLayerPlayer;
+
 //	std::vector<EntityID> debugTransitions;
 
 public:
+	MapLayersSystem();
+
 	void update(float dt) override;
 	void updateObjsLayer(float dt);
 	void updateFog(float dt);
 
 	void init() override;
 
+// https://gamedevelopment.tutsplus.com/tutorials/how-to-use-tile-bitmasking-to-auto-tile-your-level-layouts--cms-25673
+	int transitionBitmask(Layer<int> & layer, EntityID ent, int x, int y);
+
 private:
 	void updateLayer(float dt);
 	void updatePlayersFog(float dt);
 
+	// only the cells changed since last update, the whole map for another player
 	void updatePlayerFogLayer(EntityID playerEnt, float dt);
-	// spectator FOG concat all other players fog
-	void updateSpectatorFog(EntityID playerEnt, float dt);
+	void updateFogLayerCell(FogState st, int x, int y);
+	// spectator sees the whole map
+	void initSpectatorFog();
 
 // Terrains/Transitions
 	void updateAllTransitions();
 	void initTransitions();
 
-// https://gamedevelopment.tutsplus.com/tutorials/how-to-use-tile-bitmasking-to-auto-tile-your-level-layouts--cms-25673
-	int transitionBitmask(Layer<int> & layer, EntityID ent, int x, int y);
 	int voidTransitionBitmask(Layer<int> & layer, EntityID ent, int x, int y);
 	int pairTransitionBitmask(Layer<int> & layer, EntityID srcEnt, EntityID dstEnt, int x, int y);
 	int updateTransition(int bitmask, Layer<int> & outLayer, EntityID ent, std::map<int, int> &mapping, int x, int y);
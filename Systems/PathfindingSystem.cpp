@@ -1,14 +1,35 @@
 #include "PathfindingSystem.hpp"
 
 PathfindingSystem::PathfindingSystem() {
+	this->ticks = 0;
+	this->requestsCount = 0;
+	this->staleResults = 0;
+	this->nodeBudget = 0;
+	this->groupFieldsBuilt = 0;
+	this->connected = false;
 }
 
 PathfindingSystem::~PathfindingSystem() {
+	if (this->connected) {
+		this->vault->dispatcher.disconnect<ObstacleAdded>(this);
+		this->vault->dispatcher.disconnect<ObstacleRemoved>(this);
+		this->vault->dispatcher.disconnect<PathfindingChanged>(this);
+	}
 }
 
 void PathfindingSystem::init() {
 //		this->testDbscan();
+	this->initPathfindingLayer();
 	flowFieldPathFind.init(this->map);
+
+	this->vault->dispatcher.connect<ObstacleAdded>(this);
+	this->vault->dispatcher.connect<ObstacleRemoved>(this);
+	this->vault->dispatcher.connect<PathfindingChanged>(this);
+	this->connected = true;
+
+	// keep a core for the game loop
+	int cores = std::thread::hardware_concurrency();
+	this->workers.start(std::max(0, std::min(PATHFINDING_MAX_WORKERS, cores - 1)));
 }
 
 void PathfindingSystem::testDbscan() {
@@ -22,7 +43,7 @@ void PathfindingSystem::testDbscan() {
 		}
 	}
 
-	int num = dbscan(points, labels, 1.42, 8);
+	int num = gridDbscan(points, labels, 1.42, 8);
 
 	std::map<int, std::vector<Point>> clusters;
 	std::map<int, int> points_map_size;
@@ -42,34 +63,113 @@ void PathfindingSystem::testDbscan() {
 	}
 }
 
-void PathfindingSystem::updatePathfindingLayer(float dt) {
-	auto buildingView = this->vault->registry.persistent<Tile, Building>();
+// full pathfinding layer, then maintained by obstacle events
+void PathfindingSystem::initPathfindingLayer() {
 	this->map->pathfinding.clear();
 
+	auto buildingView = this->vault->registry.persistent<Tile, Building>();
 	for (EntityID entity : buildingView) {
-		Tile &tile = buildingView.get<Tile>(entity);
-
-		for (sf::Vector2i const &p : this->tileSurface(tile)) {
-
-			this->map->pathfinding.set(p.x, p.y, entity);
+		if (this->isObstacle(entity)) {
+			Tile &tile = buildingView.get<Tile>(entity);
+			for (sf::Vector2i const &p : this->tileSurface(tile)) {
+				this->map->pathfinding.set(p.x, p.y, entity);
+			}
 		}
 	}
 
 	auto decorView = this->vault->registry.persistent<Tile, Decor>();
 	for (EntityID entity : decorView) {
-		Tile &tile = decorView.get<Tile>(entity);
-		Decor &decor = decorView.get<Decor>(entity);
-
-		if (decor.blocking) {
+		if (this->isObstacle(entity)) {
+			Tile &tile = decorView.get<Tile>(entity);
 			for (sf::Vector2i const &p : this->tileSurface(tile)) {
 				this->map->pathfinding.set(p.x, p.y, entity);
 			}
 		}
 	}
+
+	this->map->updateWalkable();
+}
+
+// placed buildings and blocking decors
+bool PathfindingSystem::isObstacle(EntityID entity) {
+	if (!this->vault->registry.has<Tile>(entity))
+		return false;
+	if (this->vault->registry.has<Building>(entity))
+		return this->vault->registry.get<GameObject>(entity).mapped;
+	if (this->vault->registry.has<Decor>(entity))
+		return this->vault->registry.get<Decor>(entity).blocking;
+	return false;
+}
+
+void PathfindingSystem::setObstacle(EntityID entity, bool blocking) {
+	Tile &tile = this->vault->registry.get<Tile>(entity);
+	std::vector<sf::Vector2i> surface = this->tileSurface(tile);
+	if (surface.size() == 0)
+		return;
+
+	sf::Vector2i topLeft = surface.front();
+	sf::Vector2i bottomRight = surface.front();
+	bool changed = false;
+	for (sf::Vector2i const &p : surface) {
+		EntityID cur = this->map->pathfinding.get(p.x, p.y);
+		if (blocking) {
+			changed |= (cur == 0);
+			this->map->pathfinding.set(p.x, p.y, entity);
+		} else if (cur == entity) {
+			changed = true;
+			this->map->pathfinding.set(p.x, p.y, 0);
+		}
+		topLeft = sf::Vector2i(std::min(topLeft.x, p.x), std::min(topLeft.y, p.y));
+		bottomRight = sf::Vector2i(std::max(bottomRight.x, p.x), std::max(bottomRight.y, p.y));
+	}
+
+	if (changed) {
+#ifdef PATHFINDING_DEBUG
+		std::cout << "Pathfinding: obstacle " << entity << " " << blocking << " at " << topLeft << " " << bottomRight << std::endl;
+#endif
+		this->vault->dispatcher.trigger<PathfindingChanged>(sf::IntRect(topLeft, bottomRight - topLeft + sf::Vector2i(1, 1)));
+	}
+}
+
+void PathfindingSystem::receive(const ObstacleAdded &event) {
+	if (this->isObstacle(event.entity))
+		this->setObstacle(event.entity, true);
+}
+
+void PathfindingSystem::receive(const ObstacleRemoved &event) {
+	if (this->vault->registry.has<Tile>(event.entity))
+		this->setObstacle(event.entity, false);
+}
+
+void PathfindingSystem::receive(const PathfindingChanged &event) {
+	this->map->updateWalkable(event.rect);
+	this->flowFieldPathFind.markChanged(event.rect);
+}
+
+void PathfindingSystem::updateStats() {
+	PathfindingStats &stats = this->vault->registry.get<PathfindingStats>();
+	stats.cacheHits = this->flowFieldPathFind.cache.hits;
+	stats.cacheMisses = this->flowFieldPathFind.cache.misses;
+	stats.cacheInvalidations = this->flowFieldPathFind.cache.invalidations;
+	stats.cacheSize = this->flowFieldPathFind.cache.size();
+
+	stats.queueDepth = this->requests.size();
+	stats.workers = this->workers.size();
+	stats.staleResults = this->staleResults;
+	if (this->latencies.size() > 0) {
+		std::vector<unsigned int> sorted(this->latencies.begin(), this->latencies.end());
+		std::sort(sorted.begin(), sorted.end());
+		stats.latencyP50 = sorted[sorted.size() * 50 / 100];
+		stats.latencyP95 = sorted[sorted.size() * 95 / 100];
+		stats.latencyP99 = sorted[sorted.size() * 99 / 100];
+	}
 }
 
 void PathfindingSystem::update(float dt) {
-	this->updatePathfindingLayer(dt);
+	this->flowFieldPathFind.update();
+	this->applyResults();
+	this->groupFieldsBuilt = 0;
+
 	auto view = this->vault->registry.persistent<Tile, GameObject, Unit>();
 
 #if 0
@@ -121,58 +221,253 @@ void PathfindingSystem::update(float dt) {
 
 			if (tile.pos != unit.destpos) {
 				unit.flowFieldPath.setPathFind(&flowFieldPathFind);
-				bool found = unit.flowFieldPath.start(tile.pos.x, tile.pos.y, unit.destpos.x, unit.destpos.y);
+				if (unit.groupField && this->followGroup(entity, tile, unit)) {
+					// group field gives the direction
+				} else if (unit.flowFieldPath.getDest() != unit.destpos) {
+					// new destination, wait for a search
+					if (this->reachableDestination(entity, tile, unit)) {
+						this->requestPath(entity, obj, unit);
+						this->interimDirection(tile, unit);
+					}
+				} else {
+					bool found = unit.flowFieldPath.start(tile.pos.x, tile.pos.y, unit.destpos.x, unit.destpos.y);
+					this->followPath(entity, tile, unit, found);
+				}
+			} else {
+#ifdef PATHFINDING_DEBUG
+				std::cout << "Pathfinding: " << entity << " at destination" << std::endl;
+#endif
+				unit.direction = sf::Vector2i(0, 0);
+				unit.commanded = false;
+			}
+		}
+	}
+
+	this->dispatchRequests();
+
+	this->ticks++;
+	this->updateStats();
+}
+
+PathPriority PathfindingSystem::pathPriority(GameObject &obj, Unit &unit) {
+	if (obj.player && this->vault->registry.valid(obj.player) && this->vault->registry.has<Player>(obj.player)) {
+		Player &player = this->vault->registry.get<Player>(obj.player);
+		if (!player.ai)
+			return PathPriority::Command;
+	}
+	if (unit.targetType != TargetType::None)
+		return PathPriority::Combat;
+	return PathPriority::Explore;
+}
+
+void PathfindingSystem::requestPath(EntityID entity, GameObject &obj, Unit &unit) {
+	if (this->queued.count(entity) == 0) {
+		this->requests.push(PathRequest{entity, this->pathPriority(obj, unit), this->requestsCount++, this->ticks});
+		this->queued.insert(entity);
+		Profiler::get().count(PROFILE_COUNTER("path requests"));
+	}
+}
+
+// head straight to destination until the path is searched
+void PathfindingSystem::interimDirection(Tile &tile, Unit &unit) {
+	sf::Vector2i delta = unit.destpos - tile.pos;
+	sf::Vector2i dir((delta.x > 0) - (delta.x < 0), (delta.y > 0) - (delta.y < 0));
+	if (this->map->pathAvailable(tile.pos.x + dir.x, tile.pos.y + dir.y))
+		unit.direction = dir;
+	else
+		unit.direction = sf::Vector2i(0, 0);
+}
+
+// apply searches due this tick, dispatched PATHFINDING_RESULT_TICKS ticks ago
+void PathfindingSystem::applyResults() {
+	std::vector<PathResult> results;
+	std::vector<sf::IntRect> changed;
+	this->workers.drain(this->ticks, results);
+
+	for (PathResult &result : results) {
+		this->queued.erase(result.entity);
+		this->flowFieldPathFind.stepsDone += result.steps;
+		this->nodeBudget += (long)result.charged - (long)result.steps;
 
-				if (found)
-				{
-					sf::Vector2i cpos(tile.pos.x, tile.pos.y);
-					sf::Vector2i npos = unit.flowFieldPath.next(tile.pos.x, tile.pos.y);
+		if (!this->vault->registry.valid(result.entity) || !this->vault->registry.has<Unit>(result.entity))
+			continue;
 
+		Tile &tile = this->vault->registry.get<Tile>(result.entity);
+		GameObject &obj = this->vault->registry.get<GameObject>(result.entity);
+		Unit &unit = this->vault->registry.get<Unit>(result.entity);
+
+		if (obj.life <= 0 || tile.pos == unit.destpos)
+			continue;
+
+		if (unit.destpos != result.dest) {
+			// destination changed during search
+			this->requestPath(result.entity, obj, unit);
+			continue;
+		}
+
+		changed.clear();
+		if (result.version != this->flowFieldPathFind.version &&
+		        (!this->flowFieldPathFind.changedSince(result.version, changed) || !result.stillValid(*this->map, changed))) {
 #ifdef PATHFINDING_DEBUG
-					std::cout << "Pathfinding: " << entity << " at " << cpos << " next position " << npos << "(" << (npos - cpos) << ")" << std::endl;
+			std::cout << "Pathfinding: " << result.entity << " stale path " << result.version << " != " << this->flowFieldPathFind.version << std::endl;
 #endif
+			this->staleResults++;
+			this->requestPath(result.entity, obj, unit);
+			continue;
+		}
+
+		unit.flowFieldPath.setPathFind(&flowFieldPathFind);
+		unit.flowFieldPath.setPath(result.start.x, result.start.y, result.dest.x, result.dest.y, result.found, result.points, result.waypoints);
+		this->followPath(result.entity, tile, unit, result.found);
+
+		this->latencies.push_back(this->ticks - result.tick);
+		if (this->latencies.size() > PATHFINDING_LATENCIES)
+			this->latencies.pop_front();
+	}
+}
+
+// send queued searches to workers by priority, within the nodes budget of the tick
+void PathfindingSystem::dispatchRequests() {
+	int dispatched = 0;
+	// unspent nodes are not saved for later ticks, overspent ones are paid back
+	this->nodeBudget = std::min(this->nodeBudget + PATHFINDING_TICK_NODES, (long)PATHFINDING_TICK_NODES);
+
+	while (this->requests.size() > 0 && this->nodeBudget > 0) {
+		PathRequest request = this->requests.top();
+		this->requests.pop();
+
+		if (!this->vault->registry.valid(request.entity) || !this->vault->registry.has<Unit>(request.entity)) {
+			this->queued.erase(request.entity);
+			continue;
+		}
+
+		Tile &tile = this->vault->registry.get<Tile>(request.entity);
+		GameObject &obj = this->vault->registry.get<GameObject>(request.entity);
+		Unit &unit = this->vault->registry.get<Unit>(request.entity);
+
+		if (obj.life <= 0 || tile.pos == unit.destpos) {
+			this->queued.erase(request.entity);
+			continue;
+		}
 
-					if (npos != cpos) {
-						unit.direction = npos - cpos;
-					} else {
-						unit.direction = sf::Vector2i(0, 0);
+		if (!this->snapshot || this->snapshot->version != this->flowFieldPathFind.version)
+			this->snapshot = std::make_shared<const WalkabilitySnapshot>(*this->map, this->flowFieldPathFind.sectorGraph, this->flowFieldPathFind.version);
+
+		// a search expands at least its path length, the rest is charged with the result
+		sf::Vector2i delta = unit.destpos - tile.pos;
+		unsigned int charged = std::max(std::abs(delta.x), std::abs(delta.y));
+		this->workers.push(PathJob{request.entity, request.seq, request.tick, this->ticks + PATHFINDING_RESULT_TICKS, charged, tile.pos, unit.destpos, this->snapshot});
+		this->nodeBudget -= charged;
+		dispatched++;
+	}
 
 #ifdef PATHFINDING_DEBUG
-						std::cout << "Pathfinding: " << entity << " wait a moment " << std::endl;
+	std::cout << "Pathfinding: dispatched " << dispatched << " requests, " << this->requests.size() << " queued, " << this->nodeBudget << " nodes left" << std::endl;
 #endif
-					}
-				} else {
+}
+
+void PathfindingSystem::followPath(EntityID entity, Tile &tile, Unit &unit, bool found) {
+	if (found)
+	{
+		sf::Vector2i cpos(tile.pos.x, tile.pos.y);
+		sf::Vector2i npos = unit.flowFieldPath.next(tile.pos.x, tile.pos.y);
+
 #ifdef PATHFINDING_DEBUG
-					std::cout << "Pathfinding: " << entity << " no path found " << tile.pos << " -> " << unit.destpos << std::endl;
+		std::cout << "Pathfinding: " << entity << " at " << cpos << " next position " << npos << "(" << (npos - cpos) << ")" << std::endl;
 #endif
-					unit.direction = sf::Vector2i(0, 0);
-					unit.nopath++;
-					unit.reallyNopath++;
-
-					if (unit.reallyNopath > PATHFINDING_MAX_NO_PATH * 4) {
-						unit.nopath = 0;
-						unit.reallyNopath = 0;
-						unit.destpos = tile.pos;
-						unit.commanded = false;
-					}
 
-					if (unit.nopath > PATHFINDING_MAX_NO_PATH) {
-						sf::Vector2i fp = this->firstAvailablePosition(unit.destpos, 1, 16);
+		if (npos != cpos) {
+			unit.direction = npos - cpos;
+		} else {
+			unit.direction = sf::Vector2i(0, 0);
+
 #ifdef PATHFINDING_DEBUG
-						std::cout << "Pathfinding: " << entity << " go to first free position " << fp << std::endl;
+			std::cout << "Pathfinding: " << entity << " wait a moment " << std::endl;
 #endif
-						this->goTo(unit, fp);
-					}
+		}
+	} else {
+#ifdef PATHFINDING_DEBUG
+		std::cout << "Pathfinding: " << entity << " no path found " << tile.pos << " -> " << unit.destpos << std::endl;
+#endif
+		unit.direction = sf::Vector2i(0, 0);
+		unit.nopath++;
 
-				}
+		if (!this->reachableDestination(entity, tile, unit))
+			return;
 
-			} else {
+		// same region but the search failed, map changed since: search again a few times
+		if (unit.nopath > PATHFINDING_MAX_NO_PATH) {
+			this->stopPath(tile, unit);
+		} else {
+			unit.flowFieldPath.reset();
+			unit.pathUpdate = true;
+		}
+	}
+}
+
+// follow the group order field until the final sector, false if the unit must use its own path
+bool PathfindingSystem::followGroup(EntityID entity, Tile &tile, Unit &unit) {
+	GroupFlowField &group = *unit.groupField;
+
+	if (unit.destpos != unit.groupDest ||
+	        this->flowFieldPathFind.sectorGraph.sectorDistance(tile.pos, group.target) == 0 ||
+	        this->flowFieldPathFind.sectorGraph.sectorDistance(tile.pos, unit.destpos) == 0 ||
+	        !this->flowFieldPathFind.regions.sameRegion(tile.pos, unit.destpos)) {
+		unit.groupField.reset();
+		return false;
+	}
+
+	if (!group.built || group.version != this->flowFieldPathFind.version) {
+		if (this->groupFieldsBuilt >= PATHFINDING_TICK_GROUP_FIELDS) {
+			this->interimDirection(tile, unit);
+			return true;
+		}
 #ifdef PATHFINDING_DEBUG
-				std::cout << "Pathfinding: " << entity << " at destination" << std::endl;
+		std::cout << "Pathfinding: " << entity << " build group field to " << group.target << std::endl;
 #endif
-				unit.direction = sf::Vector2i(0, 0);
-				unit.commanded = false;
-			}
-		}
+		group.build(this->map, this->flowFieldPathFind.version);
+		this->groupFieldsBuilt++;
 	}
+
+	if (!group.field.found(tile.pos)) {
+		unit.groupField.reset();
+		return false;
+	}
+
+	sf::Vector2i npos = group.field.next(tile.pos);
+	unit.direction = npos - tile.pos;
+	unit.flowFieldPath.ffDest = npos;
+	return true;
+}
+
+// redirect to nearest cell of the unit region if destination cannot be reached, stop if none
+bool PathfindingSystem::reachableDestination(EntityID entity, Tile &tile, Unit &unit) {
+	RegionLabels &regions = this->flowFieldPathFind.regions;
+	if (regions.mayReach(tile.pos, unit.destpos))
+		return true;
+
+	unsigned int label = regions.get(tile.pos);
+
+	sf::Vector2i redirect = regions.nearest(label, unit.destpos, REGION_MAX_REDIRECT);
+	if (redirect == unit.destpos || redirect == tile.pos) {
+#ifdef PATHFINDING_DEBUG
+		std::cout << "Pathfinding: " << entity << " unreachable " << unit.destpos << " from region " << label << std::endl;
+#endif
+		this->stopPath(tile, unit);
+		return false;
+	}
+
+#ifdef PATHFINDING_DEBUG
+	std::cout << "Pathfinding: " << entity << " redirect " << unit.destpos << " -> " << redirect << std::endl;
+#endif
+	unit.destpos = redirect;
+	unit.nopath = 0;
+	return true;
+}
+
+void PathfindingSystem::stopPath(Tile &tile, Unit &unit) {
+	unit.nopath = 0;
+	unit.destpos = tile.pos;
+	unit.direction = sf::Vector2i(0, 0);
+	unit.commanded = false;
 }
@@ -1,17 +1,69 @@
 #pragma once
 
+#include <queue>
+#include <deque>
+#include <set>
+
 #include "third_party/JPS.h"
-#include "third_party/dbscan/dbscan.h"
+#include "GridDbscan.hpp"
 
 #include "GameSystem.hpp"
 #include "FlowField.hpp"
+#include "PathfindingWorkers.hpp"
 #include "Steering.hpp"
 
 #define PATHFINDING_MAX_NO_PATH 8
 
+// nodes searches may expand per tick, searches are charged their path length when sent then their expanded nodes when applied
+#define PATHFINDING_TICK_NODES 4096
+// ticks workers have to search before results are applied, a result not done by then is waited for
+#define PATHFINDING_RESULT_TICKS 2
+#define PATHFINDING_MAX_WORKERS 4
+// served requests kept for latency stats
+#define PATHFINDING_LATENCIES 256
+// group flow fields built per tick, other groups head straight to target meanwhile
+#define PATHFINDING_TICK_GROUP_FIELDS 2
+
+enum class PathPriority {
+	Command, // human player units
+	Combat, // AI units with a target
+	Explore // other AI moves
+};
+
+struct PathRequest {
+	EntityID entity;
+	PathPriority priority;
+	unsigned long seq;
+	unsigned long tick;
+
+	// std::priority_queue top is the highest priority, then the oldest request
+	bool operator<(const PathRequest &other) const {
+		if (priority != other.priority)
+			return priority > other.priority;
+		return seq > other.seq;
+	}
+};
+
 #define MIN_VELOCITY 0.01f
 
 class PathfindingSystem : public GameSystem {
+	std::priority_queue<PathRequest> requests;
+	std::set<EntityID> queued;
+	unsigned long requestsCount;
+	unsigned long ticks;
+	// latencies in ticks of last served requests
+	std::deque<unsigned int> latencies;
+	unsigned long staleResults;
+	// nodes left this tick, below zero when searches expanded more than charged
+	long nodeBudget;
+	// group fields built this tick
+	int groupFieldsBuilt;
+	// obstacle events come from the factory, which outlives the match
+	bool connected;
+
+	PathfindingWorkers workers;
+	std::shared_ptr<const WalkabilitySnapshot> snapshot;
+
 public:
 	FlowFieldPathFind flowFieldPathFind;
 
@@ -21,8 +73,25 @@ public:
 	void init() override;
 	void update(float dt) override;
 
+	void receive(const ObstacleAdded &event);
+	void receive(const ObstacleRemoved &event);
+	void receive(const PathfindingChanged &event);
+
 private:
-	void updatePathfindingLayer(float dt);
+	void initPathfindingLayer();
+	bool isObstacle(EntityID entity);
+	void setObstacle(EntityID entity, bool blocking);
+	void updateStats();
+
+	PathPriority pathPriority(GameObject &obj, Unit &unit);
+	void requestPath(EntityID entity, GameObject &obj, Unit &unit);
+	void interimDirection(Tile &tile, Unit &unit);
+	void applyResults();
+	void dispatchRequests();
+	bool followGroup(EntityID entity, Tile &tile, Unit &unit);
+	bool reachableDestination(EntityID entity, Tile &tile, Unit &unit);
+	void stopPath(Tile &tile, Unit &unit);
+	void followPath(EntityID entity, Tile &tile, Unit &unit, bool found);
 
 	void testDbscan();
 
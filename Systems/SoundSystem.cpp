@@ -11,7 +11,7 @@ void SoundSystem::receive(const SoundPlay &event) {
 }
 
 void SoundSystem::update(float dt) {
-	float pitch = 0.033 / dt;
+	float pitch = this->speed;
 
 #ifdef SOUND_SYSTEM_DEBUG
 	if (this->sounds.size() > 0)
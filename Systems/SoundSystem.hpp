@@ -16,6 +16,13 @@ class SoundSystem : public GameSystem {
 	std::priority_queue<SoundPlay, std::vector<SoundPlay>, SoundPlayCompare> sounds;
 	std::list<sf::Sound> playing;
 public:
+	// game speed factor, sounds are pitched with it
+	float speed;
+
+	SoundSystem() {
+		this->speed = 1.0f;
+	}
+
 	void init() override;
 	void update(float dt) override;
 
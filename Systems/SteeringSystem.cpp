@@ -1,13 +1,14 @@
 #include "SteeringSystem.hpp"
 
-#define OBSTACLE_RADIUS 1
 #define SURROUNDING_RADIUS 1
-#define MAX_SURROUNDING_OBJS 64
 
-#define MIN_VELOCITY 0.01f
+void SteeringSystem::init() {
+	// keep a core for the game loop
+	int cores = std::thread::hardware_concurrency();
+	this->workers.start(std::max(0, std::min(STEERING_MAX_WORKERS, cores - 1)));
+}
 
-void SteeringSystem::updateQuadtrees() {
-	this->map->units->clear();
+void SteeringSystem::updateSpatialHash() {
 	auto unitView = this->vault->registry.persistent<Tile, Unit>();
 
 	for (EntityID entity : unitView) {
@@ -15,11 +16,18 @@ void SteeringSystem::updateQuadtrees() {
 		Unit &unit = unitView.get<Unit>(entity);
 		this->map->units->add(PathfindingObject(entity, tile, unit));
 	}
-
+	this->map->units->build();
 }
 
 void SteeringSystem::update(float dt) {
-	this->updateQuadtrees();
+	this->updateSpatialHash();
+
+	this->batch.clear();
+	this->batchUnits.clear();
+	this->stateChanges.clear();
+
+	// serial pass, map position and units to steer
+	SimulationClock &clock = this->vault->registry.get<SimulationClock>();
 	auto view = this->vault->registry.persistent<Tile, GameObject, Unit>();
 	for (EntityID entity : view) {
 		Tile &tile = view.get<Tile>(entity);
@@ -28,9 +36,10 @@ void SteeringSystem::update(float dt) {
 
 		if (obj.life > 0)
 		{
+			tile.lastPpos = tile.ppos;
+			tile.lastStep = clock.steps;
 			tile.pos = sf::Vector2i(trunc(tile.ppos / 32.0f)); // trunc map pos
-
-			PathfindingObject curSteerObj = PathfindingObject(entity, tile, unit);//SteeringObject{entity, tile.ppos, unit.velocity, unit.speed, MAX_FORCE};
+			this->map->influence.move(entity, obj.teamId, tile.pos);
 
 			if (tile.pos != unit.pathPos) {
 				this->map->objs.set(unit.pathPos.x, unit.pathPos.y, 0); // mark map pos immediatly
@@ -44,145 +53,116 @@ void SteeringSystem::update(float dt) {
 				unit.destpos = tile.pos;
 			}
 
-			std::vector<PathfindingObject> surroundingObjects = this->getSurroundingSteeringObjects(entity, tile.ppos.x, tile.ppos.y);
-
-			std::vector<sf::Vector2f> cases;
-			for (int cx = tile.pos.x - OBSTACLE_RADIUS; cx <= tile.pos.x + OBSTACLE_RADIUS; ++cx) {
-				for (int cy = tile.pos.y - OBSTACLE_RADIUS; cy <= tile.pos.y + OBSTACLE_RADIUS; ++cy) {
-					if (!this->map->bound(cx, cy) || !this->map->pathAvailable(cx, cy)) {
-						cases.push_back(sf::Vector2f(cx * 32.0f, cy * 32.0f));
+			if (tile.state != TileStateStr("attack")) {
+				this->batch.add(tile.ppos, unit.velocity, unit.speed);
+				this->batchUnits.push_back(SteeringUnit{entity, &tile, &unit});
+			} else {
+				// face target
+				if (unit.targetType == TargetType::Attack) {
+					if (unit.targetEnt) {
+						Tile &ttile = this->vault->registry.get<Tile>(unit.targetEnt);
+						tile.view = getDirection(sf::Vector2i(ttile.ppos - tile.ppos));
 					}
+				} else {
+					tile.view = getDirection(sf::Vector2i(unit.targetPos - tile.pos));
 				}
 			}
+		} else {
+			this->map->influence.remove(entity);
+		}
+	}
 
-			sf::Vector2f accel(0, 0);
-
-			// escape from obstacle
-			if (!this->map->pathAvailable(tile.pos.x, tile.pos.y)) {
-				sf::Vector2i bestNextPos = tile.pos;
-				sf::Vector2i curDestPos = unit.destpos;
-				curDestPos = unit.flowFieldPath.ffDest;
-				float dist = std::numeric_limits<float>::max();
-				for (sf::Vector2i &fp : this->vectorSurfaceExtended(tile.pos, 1)) {
-					if (this->map->pathAvailable(fp.x, fp.y)) {
-						if (distance(fp, curDestPos) < dist) {
-							dist = distance(fp, curDestPos);
-							bestNextPos = fp;
-						}
-					}
-				}
-				accel += steering.seek(curSteerObj, sf::Vector2f(bestNextPos * 32) + 16.0f) * 2.0f;
-				accel += steering.flee(curSteerObj, sf::Vector2f(tile.pos * 32) + 16.0f);
+	// parallel pass, neighbours, obstacle field and forces from the state above, nothing is written but the batch
+	this->batch.run(this->workers, [this](unsigned int idx, SteeringPairs & pairs) {
+		const SteeringUnit &steerUnit = this->batchUnits[idx];
+		EntityID entity = steerUnit.entity;
+		Tile &tile = *steerUnit.tile;
+		Unit &unit = *steerUnit.unit;
+
+		PathfindingObject curSteerObj = PathfindingObject(entity, tile, unit);//SteeringObject{entity, tile.ppos, unit.velocity, unit.speed, MAX_FORCE};
+
+		// check if somebody move arround
+		sf::Vector2f sum(0, 0);
+		this->map->units->forEach(tile.ppos.x - SURROUNDING_RADIUS * 32.0f, tile.ppos.y - SURROUNDING_RADIUS * 32.0f, (SURROUNDING_RADIUS * 2) * 32.0f, (SURROUNDING_RADIUS * 2) * 32.0f, [&pairs, &sum, entity](const PathfindingObject & hashObj) {
+			if (hashObj.entity != entity) {
+				pairs.addNeighbor(hashObj.pos);
+				sum += hashObj.velocity;
 			}
+		});
+
+		float obstacleDist;
+		sf::Vector2f away;
+		if (this->map->obstacleField.sample(tile.ppos, obstacleDist, away)) {
+			if (obstacleDist < 0.0f) {
+				// escape from obstacle, away points to the nearest free cell
+				this->batch.addExtra(idx, steering.seek(curSteerObj, tile.ppos + away * 32.0f) * 2.0f);
+				this->batch.addExtra(idx, steering.flee(curSteerObj, tile.ppos - away));
+			} else if (obstacleDist < AVOID_DIST) {
+				this->batch.setAvoid(idx, away);
+			}
+		}
 
-			accel += steering.avoid(curSteerObj, cases) * 1.0f;
-
-			if (tile.state != "attack") {
-				bool seekTarget = false;
-				if (unit.targetEnt) {
-					Tile &ttile = this->vault->registry.get<Tile>(unit.targetEnt);
-					// if attacking and target is near, then seek it and avoid separate
-					if (distance(ttile.ppos, tile.ppos) < 64.0f) {
-						seekTarget = true;
-						accel += steering.seek(curSteerObj, ttile.ppos);
-					}
-				}
-
-				if (!seekTarget) {
-					// check if somebody move arround
-					sf::Vector2f sum(0, 0);
-					for (auto &obj : surroundingObjects) {
-						sum += obj.velocity;
-					}
+		bool seekTarget = false;
+		if (unit.targetEnt) {
+			Tile &ttile = this->vault->registry.get<Tile>(unit.targetEnt);
+			// if attacking and target is near, then seek it and avoid separate
+			if (distance(ttile.ppos, tile.ppos) < 64.0f) {
+				seekTarget = true;
+				this->batch.addExtra(idx, steering.seek(curSteerObj, ttile.ppos));
+			}
+		}
 
-					if (tile.pos == unit.destpos && length(sum) < 0.1f) {
-						sf::Vector2f center = sf::Vector2f(tile.pos) * 32.0f + 16.0f;
-						accel += steering.arrive(curSteerObj, center);
-//					accel += steering.seek(curSteerObj, center, 1.0f);
-					} else {
-						accel += steering.followFlowField(curSteerObj, unit.direction) * 1.5f;
-					}
-				}
-				accel += steering.separate(curSteerObj, surroundingObjects) * 2.0f;
-
-				// queue if other are already attacking
-				/*
-				for (SteeringObject &obj : surroundingObjects) {
-					Tile &stile = this->vault->registry.get<Tile>(obj.entity);
-					if (stile.state == "attack" && obj.entity != unit.targetEnt) {
-						accel += steering.queue(curSteerObj, surroundingObjects, accel);
-					}
-				}
-				*/
+		if (!seekTarget) {
+			if (tile.pos == unit.destpos && length(sum) < 0.1f) {
+				sf::Vector2f center = sf::Vector2f(tile.pos) * 32.0f + 16.0f;
+				this->batch.addExtra(idx, steering.arrive(curSteerObj, center));
+			} else {
+				this->batch.setFlow(idx, sf::Vector2f(unit.direction), 1.5f);
+			}
+		}
+	});
 
-//				accel = steering.capRotation(curSteerObj, accel, 90);
-				sf::Vector2f previousVelocity = unit.velocity;
+	// serial pass, apply, no event is sent while units are held
+	for (unsigned int i = 0; i < this->batchUnits.size(); ++i) {
+		EntityID entity = this->batchUnits[i].entity;
+		Tile &tile = *this->batchUnits[i].tile;
+		Unit &unit = *this->batchUnits[i].unit;
 
-				unit.velocity = unit.velocity + accel;
-				unit.velocity = limit(unit.velocity, curSteerObj.maxSpeed * MIN_VELOCITY, curSteerObj.maxSpeed);
-				tile.ppos += unit.velocity;
+		unit.velocity = sf::Vector2f(this->batch.outVx[i], this->batch.outVy[i]);
+		tile.ppos = sf::Vector2f(this->batch.outX[i], this->batch.outY[i]);
 
 #ifdef PATHFINDING_DEBUG
-				std::cout << "Pathfinding: " << entity << " steering accel:" << accel << " velocity:" << unit.velocity << " surrounding:" << surroundingObjects.size() << std::endl;
+		std::cout << "Pathfinding: " << entity << " steering velocity:" << unit.velocity << std::endl;
 #endif
 
+		if (unit.averageCount < 8) {
+			unit.averageVelocity += unit.velocity;
+			unit.averageCount++;
+		} else {
+			unit.averageVelocity = unit.velocity;
+			unit.averageCount = 1;
+		}
 
-				if (unit.averageCount < 8) {
-					unit.averageVelocity += unit.velocity;
-					unit.averageCount++;
-				} else {
-					unit.averageVelocity = unit.velocity;
-					unit.averageCount = 1;
-				}
-
-				sf::Vector2f avVel = unit.averageVelocity / (float)unit.averageCount;
+		sf::Vector2f avVel = unit.averageVelocity / (float)unit.averageCount;
 
-//				sf::Vector2f avVel = unit.velocity;
-				float velLen = length(avVel);
+//		sf::Vector2f avVel = unit.velocity;
+		float velLen = length(avVel);
 
-				if (velLen < unit.speed * 0.05f) {
-					unit.velocity = sf::Vector2f(0, 0);
-					this->changeState(entity, "idle");
-				} else {
-//						if (length(unit.velocity) * 1.5f >= unit.speed)
-					if (velLen >= unit.speed * 0.1f)
-						tile.view = getDirection(sf::Vector2i(round(avVel * 10.0f)));
-
-					this->changeState(entity, "move");
-				}
-			} else {
-				// face target
-				if (unit.targetType == TargetType::Attack) {
-					if (unit.targetEnt) {
-						Tile &ttile = this->vault->registry.get<Tile>(unit.targetEnt);
-						tile.view = getDirection(sf::Vector2i(ttile.ppos - tile.ppos));
-					}
-				} else {
-					tile.view = getDirection(sf::Vector2i(unit.targetPos - tile.pos));
-				}
-			}
+		TileState state = TileStateStr("move");
+		if (velLen < unit.speed * 0.05f) {
+			unit.velocity = sf::Vector2f(0, 0);
+			state = TileStateStr("idle");
+		} else {
+//			if (length(unit.velocity) * 1.5f >= unit.speed)
+			if (velLen >= unit.speed * 0.1f)
+				tile.view = getDirection(sf::Vector2i(round(avVel * 10.0f)));
 		}
+		if (tile.state != state)
+			this->stateChanges.push_back(SteeringStateChange{entity, state});
 	}
-}
 
-std::vector<PathfindingObject> SteeringSystem::getSurroundingSteeringObjects(EntityID currentEnt, float x, float y) {
-	std::vector<PathfindingObject> steerObjs;
-	steerObjs.reserve(MAX_SURROUNDING_OBJS);
-	std::vector<PathfindingObject> quadObjs;
-	quadObjs.reserve(MAX_SURROUNDING_OBJS); // guess we won't have more than MAX_SURROUNDING_OBJS objects in this 3x3 grid
-	this->map->units->retrieve(quadObjs, x - SURROUNDING_RADIUS * 32.0f, y - SURROUNDING_RADIUS * 32.0f, (SURROUNDING_RADIUS + 1) * 32.0f, (SURROUNDING_RADIUS + 1) * 32.0f);
-	if (quadObjs.size() > 0) {
-//		std::cout << "PathfindingSystem: got "<<quadObjs.size()<< " quadtree objects"<<std::endl;
-		for (auto &quadObj : quadObjs) {
-			if (quadObj.entity != currentEnt) {
-//					Tile &tile = this->vault->registry.get<Tile>(quadObj.entity);
-//					Unit &unit = this->vault->registry.get<Unit>(quadObj.entity);
-//					steerObjs.push_back(PathfindingObject(quadObj.entity, tile, unit));
-
-				quadObj.update(); // update from pointers
-				steerObjs.push_back(quadObj);
-			}
-		}
+	// handlers may change the registry, units pointers are not used anymore
+	for (SteeringStateChange const &change : this->stateChanges) {
+		this->changeState(change.entity, change.state);
 	}
-	return steerObjs;
 }
@@ -3,13 +3,34 @@
 #include "GameSystem.hpp"
 #include "FlowField.hpp"
 #include "Steering.hpp"
+#include "SteeringBatch.hpp"
+#include "ChunkWorkers.hpp"
+
+#define STEERING_MAX_WORKERS 8
+
+struct SteeringUnit {
+	EntityID entity;
+	Tile *tile;
+	Unit *unit;
+};
+
+struct SteeringStateChange {
+	EntityID entity;
+	TileState state;
+};
 
 class SteeringSystem : public GameSystem {
 	Steering<PathfindingObject> steering;
+	// moving units of the frame, in batch order
+	SteeringBatch batch;
+	std::vector<SteeringUnit> batchUnits;
+	// state changes of the apply pass, their events are sent once every unit is applied
+	std::vector<SteeringStateChange> stateChanges;
+	ChunkWorkers workers;
 
 public:
+	void init() override;
 	void update(float dt) override;
 private:
-	void updateQuadtrees();
-	std::vector<PathfindingObject> getSurroundingSteeringObjects(EntityID currentEnt, float x, float y);
+	void updateSpatialHash();
 };
\ No newline at end of file
@@ -18,9 +18,8 @@ void TileAnimSystem::receive(const StateChanged &event) {
 }
 
 void TileAnimSystem::update(float dt) {
-	float gameDt = 0.033 / dt * 0.033;
-	updateStaticSpritesheets(gameDt);
-	updateAnimatedSpritesheets(gameDt);
+	updateStaticSpritesheets(dt);
+	updateAnimatedSpritesheets(dt);
 }
 
 void TileAnimSystem::updateStaticSpritesheets(float dt) {
@@ -28,8 +27,9 @@ void TileAnimSystem::updateStaticSpritesheets(float dt) {
 	for (EntityID entity : view) {
 		Tile &tile = view.get<Tile>(entity);
 		StaticSpritesheet &spritesheet = view.get<StaticSpritesheet>(entity);
-		if (spritesheet.states.count(tile.state) > 0) {
-			SpriteView &staticView = spritesheet.states[tile.state][tile.view];
+		auto state = spritesheet.states.find(tile.state);
+		if (state != spritesheet.states.end()) {
+			SpriteView &staticView = state->second[tile.view];
 			sf::Vector2i pos(staticView.currentPosition.x * tile.psize.x, staticView.currentPosition.y * tile.psize.y);
 			sf::IntRect boundingRect(pos, sf::Vector2i(tile.psize));
 			tile.sprite.setTextureRect(boundingRect);
@@ -43,8 +43,9 @@ void TileAnimSystem::updateAnimatedSpritesheets(float dt) {
 		Tile &tile = view.get<Tile>(entity);
 		AnimatedSpritesheet &spritesheet = view.get<AnimatedSpritesheet>(entity);
 		Timer &timer = view.get<Timer>(entity);
-		if (spritesheet.states.count(tile.state) > 0) {
-			AnimatedSpriteView &animView = spritesheet.states[tile.state][tile.view];
+		auto state = spritesheet.states.find(tile.state);
+		if (state != spritesheet.states.end()) {
+			AnimatedSpriteView &animView = state->second[tile.view];
 			int frames = animView.frames.size();
 
 			if (int((timer.t + dt) / (timer.duration / frames)) > int(timer.t / (timer.duration / frames)))
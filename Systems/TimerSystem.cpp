@@ -4,7 +4,6 @@ void TimerSystem::init() {
 }
 
 void TimerSystem::update(float dt) {
-	float gameDt = 0.033 / dt * 0.033;
 	auto view = this->vault->registry.view<Timer>();
 
 	// destroy timers with non-valid emitter or ended
@@ -22,7 +21,7 @@ void TimerSystem::update(float dt) {
 			this->vault->dispatcher.trigger<TimerStarted>(timer.name, entity);
 
 		// increment the time elapsed
-		timer.t += gameDt;
+		timer.t += dt;
 
 		if (timer.t > timer.duration) {
 			// reset time and increment loop count if loop
@@ -5,7 +5,6 @@
 class VictorySystem : public GameSystem {
 	bool scoreBonus;
 	sf::Text scoreBonusText;
-	sf::Sound scoreSound;
 
 public:
 	void init() override;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+
+#include "Entity.hpp"
+#include "Helpers.hpp"
+#include "SpatialHash.hpp"
+
+// bucket size in map cells
+#define TEAM_INDEX_CELL 8.0f
+
+// unit or building cell, buildings are added once per cell
+class TeamObject : public sf::Vector2f {
+public:
+	EntityID entity;
+	sf::Vector2i pos;
+
+	TeamObject(EntityID ent, sf::Vector2i p) : sf::Vector2f(p), entity(ent), pos(p) {}
+};
+
+// per team buckets of game objects for combat queries, rebuilt once per tick
+// ranges are euclidean in map cells, compared with integer squared distances
+class TeamSpatialIndex {
+	std::vector<TeamID> teams;
+	std::vector<SpatialHash<TeamObject>> buckets;
+	unsigned int width;
+	unsigned int height;
+
+public:
+	TeamSpatialIndex() {
+		this->width = 0;
+		this->height = 0;
+	}
+
+	void setSize(unsigned int width, unsigned int height) {
+		this->width = width;
+		this->height = height;
+		this->teams.clear();
+		this->buckets.clear();
+	}
+
+	void add(TeamID team, EntityID entity, sf::Vector2i pos) {
+		this->bucket(team).add(TeamObject(entity, pos));
+	}
+
+	void build() {
+		for (SpatialHash<TeamObject> &bucket : this->buckets) {
+			bucket.build();
+		}
+	}
+
+	// same range than GameSystem::tileSurfaceExtended for a one cell tile
+	static inline int radius2(int radius) {
+		float r = radius + 0.7071f;
+		return (int)(r * r);
+	}
+
+	// call f(object, squared distance) for every object of other teams in range
+	template <typename F>
+	void forEachEnemy(TeamID team, sf::Vector2i pos, int radius, F f) const {
+		int maxDist2 = radius2(radius);
+		for (unsigned int i = 0; i < this->teams.size(); ++i) {
+			if (this->teams[i] == team)
+				continue;
+			this->buckets[i].forEach(pos.x - radius, pos.y - radius, radius * 2, radius * 2, [&](const TeamObject & object) {
+				sf::Vector2i d = object.pos - pos;
+				int dist2 = d.x * d.x + d.y * d.y;
+				if (dist2 <= maxDist2)
+					f(object, dist2);
+			});
+		}
+	}
+
+	// nearest object of other teams accepted by accept(object), 0 if none
+	template <typename F>
+	EntityID nearestEnemy(TeamID team, sf::Vector2i pos, int radius, F accept, sf::Vector2i *enemyPos = nullptr) const {
+		EntityID nearest = 0;
+		int nearestDist2 = std::numeric_limits<int>::max();
+		this->forEachEnemy(team, pos, radius, [&](const TeamObject & object, int dist2) {
+			if (dist2 < nearestDist2 && accept(object)) {
+				nearestDist2 = dist2;
+				nearest = object.entity;
+				if (enemyPos)
+					*enemyPos = object.pos;
+			}
+		});
+		return nearest;
+	}
+
+	EntityID nearestEnemy(TeamID team, sf::Vector2i pos, int radius, sf::Vector2i *enemyPos = nullptr) const {
+		return this->nearestEnemy(team, pos, radius, [](const TeamObject & object) {
+			return true;
+		}, enemyPos);
+	}
+
+private:
+	SpatialHash<TeamObject> &bucket(TeamID team) {
+		for (unsigned int i = 0; i < this->teams.size(); ++i) {
+			if (this->teams[i] == team)
+				return this->buckets[i];
+		}
+		this->teams.push_back(team);
+		this->buckets.push_back(SpatialHash<TeamObject>(this->width, this->height, TEAM_INDEX_CELL));
+		return this->buckets.back();
+	}
+};
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+
+#include "third_party/JPS.h"
+
+#if defined(__GNUC__)
+inline int bitmapCtz(uint64_t v) {
+	return __builtin_ctzll(v);
+}
+inline int bitmapClz(uint64_t v) {
+	return __builtin_clzll(v);
+}
+#else
+inline int bitmapCtz(uint64_t v) {
+	int n = 0;
+	while (!(v & 1)) {
+		v >>= 1;
+		n++;
+	}
+	return n;
+}
+inline int bitmapClz(uint64_t v) {
+	int n = 0;
+	while (!(v & (1ull << 63))) {
+		v <<= 1;
+		n++;
+	}
+	return n;
+}
+#endif
+
+// 1 bit per cell walkability, kept in both row and column order so JPS straight jumps scan 64 cells per word
+class WalkabilityBitmap {
+	std::vector<uint64_t> rows;
+	std::vector<uint64_t> cols;
+
+public:
+	int width;
+	int height;
+	int rowWords;
+	int colWords;
+
+	WalkabilityBitmap() {
+		this->width = 0;
+		this->height = 0;
+		this->rowWords = 0;
+		this->colWords = 0;
+	}
+
+	void setSize(unsigned int width, unsigned int height) {
+		this->width = width;
+		this->height = height;
+		this->rowWords = (width + 63) / 64;
+		this->colWords = (height + 63) / 64;
+		this->rows.assign(this->rowWords * height, 0);
+		this->cols.assign(this->colWords * width, 0);
+	}
+
+	inline void set(int x, int y, bool walkable) {
+		uint64_t &r = this->rows[y * this->rowWords + (x >> 6)];
+		uint64_t &c = this->cols[x * this->colWords + (y >> 6)];
+		if (walkable) {
+			r |= 1ull << (x & 63);
+			c |= 1ull << (y & 63);
+		} else {
+			r &= ~(1ull << (x & 63));
+			c &= ~(1ull << (y & 63));
+		}
+	}
+
+	// pathfinding blocking method
+	inline bool operator()(unsigned x, unsigned y) const {
+		if (x < (unsigned)this->width && y < (unsigned)this->height) // Unsigned will wrap if < 0
+			return (this->rows[y * this->rowWords + (x >> 6)] >> (x & 63)) & 1;
+		return false;
+	}
+
+	// 64 cells of row y from x, out of map cells are not walkable
+	inline uint64_t rowBits(int y, int x) const {
+		if (y < 0 || y >= this->height)
+			return 0;
+		return bits(&this->rows[y * this->rowWords], this->rowWords, x);
+	}
+
+	// 64 cells of column x from y
+	inline uint64_t colBits(int x, int y) const {
+		if (x < 0 || x >= this->width)
+			return 0;
+		return bits(&this->cols[x * this->colWords], this->colWords, y);
+	}
+
+private:
+	static inline uint64_t word(const uint64_t *line, int words, int w) {
+		return (w >= 0 && w < words) ? line[w] : 0;
+	}
+
+	static inline uint64_t bits(const uint64_t *line, int words, int start) {
+		int w = start >> 6; // arithmetic shift, floor for negative starts
+		int off = start & 63;
+		uint64_t lo = word(line, words, w);
+		if (off == 0)
+			return lo;
+		return (lo >> off) | (word(line, words, w + 1) << (64 - off));
+	}
+};
+
+namespace JPS {
+
+// word parallel versions of straight jumps, same jump points than the generic scans
+// a forced neighbour appears when the next cell of a side line is free while the current one is blocked
+// searches on WalkabilityBitmap always use a skip of 1
+
+template <> inline Position Searcher<WalkabilityBitmap>::jumpX(Position p, int dx)
+{
+	JPS_ASSERT(dx);
+	JPS_ASSERT(grid(p.x, p.y));
+	JPS_ASSERT(skip == 1);
+
+	const int y = p.y;
+	const int x0 = p.x;
+	const int endX = endNode->pos.y == p.y ? int(endNode->pos.x) : std::numeric_limits<int>::min();
+	int x;
+	bool jump;
+
+	if (dx > 0) {
+		for (int base = x0; ; base += 64) {
+			uint64_t u0 = grid.rowBits(y + 1, base);
+			uint64_t u1 = grid.rowBits(y + 1, base + 1);
+			uint64_t d0 = grid.rowBits(y - 1, base);
+			uint64_t d1 = grid.rowBits(y - 1, base + 1);
+			uint64_t forced = (u1 & ~u0) | (d1 & ~d0);
+			if (endX >= base && endX < base + 64)
+				forced |= 1ull << (endX - base);
+			uint64_t stop = forced | ~grid.rowBits(y, base + 1);
+			if (stop) {
+				int bit = bitmapCtz(stop);
+				x = base + bit;
+				jump = (forced >> bit) & 1;
+				break;
+			}
+		}
+	} else {
+		for (int base = x0 - 63; ; base -= 64) {
+			uint64_t u0 = grid.rowBits(y + 1, base);
+			uint64_t u1 = grid.rowBits(y + 1, base - 1);
+			uint64_t d0 = grid.rowBits(y - 1, base);
+			uint64_t d1 = grid.rowBits(y - 1, base - 1);
+			uint64_t forced = (u1 & ~u0) | (d1 & ~d0);
+			if (endX >= base && endX < base + 64)
+				forced |= 1ull << (endX - base);
+			uint64_t stop = forced | ~grid.rowBits(y, base - 1);
+			if (stop) {
+				int bit = 63 - bitmapClz(stop);
+				x = base + bit;
+				jump = (forced >> bit) & 1;
+				break;
+			}
+		}
+	}
+
+	int steps = x > x0 ? x - x0 : x0 - x;
+	stepsDone += (unsigned)steps;
+	stepsRemain -= steps;
+	return jump ? Pos(x, y) : npos;
+}
+
+template <> inline Position Searcher<WalkabilityBitmap>::jumpY(Position p, int dy)
+{
+	JPS_ASSERT(dy);
+	JPS_ASSERT(grid(p.x, p.y));
+	JPS_ASSERT(skip == 1);
+
+	const int x = p.x;
+	const int y0 = p.y;
+	const int endY = endNode->pos.x == p.x ? int(endNode->pos.y) : std::numeric_limits<int>::min();
+	int y;
+	bool jump;
+
+	if (dy > 0) {
+		for (int base = y0; ; base += 64) {
+			uint64_t r0 = grid.colBits(x + 1, base);
+			uint64_t r1 = grid.colBits(x + 1, base + 1);
+			uint64_t l0 = grid.colBits(x - 1, base);
+			uint64_t l1 = grid.colBits(x - 1, base + 1);
+			uint64_t forced = (r1 & ~r0) | (l1 & ~l0);
+			if (endY >= base && endY < base + 64)
+				forced |= 1ull << (endY - base);
+			uint64_t stop = forced | ~grid.colBits(x, base + 1);
+			if (stop) {
+				int bit = bitmapCtz(stop);
+				y = base + bit;
+				jump = (forced >> bit) & 1;
+				break;
+			}
+		}
+	} else {
+		for (int base = y0 - 63; ; base -= 64) {
+			uint64_t r0 = grid.colBits(x + 1, base);
+			uint64_t r1 = grid.colBits(x + 1, base - 1);
+			uint64_t l0 = grid.colBits(x - 1, base);
+			uint64_t l1 = grid.colBits(x - 1, base - 1);
+			uint64_t forced = (r1 & ~r0) | (l1 & ~l0);
+			if (endY >= base && endY < base + 64)
+				forced |= 1ull << (endY - base);
+			uint64_t stop = forced | ~grid.colBits(x, base - 1);
+			if (stop) {
+				int bit = 63 - bitmapClz(stop);
+				y = base + bit;
+				jump = (forced >> bit) & 1;
+				break;
+			}
+		}
+	}
+
+	int steps = y > y0 ? y - y0 : y0 - y;
+	stepsDone += (unsigned)steps;
+	stepsRemain -= steps;
+	return jump ? Pos(x, y) : npos;
+}
+
+}
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "Entity.hpp"
+#include "Map.hpp"
+#include "Replay.hpp"
+#include "Components/Components.hpp"
+
+#define WORLDHASH_VERSION 1
+
+enum WorldHashPart {
+	ObjectsHash,
+	UnitsHash,
+	BuildingsHash,
+	ResourcesHash,
+	PlayersHash,
+	LayersHash,
+	WorldHashParts
+};
+
+static const char *worldHashPartNames[] = {
+	"objects",
+	"units",
+	"buildings",
+	"resources",
+	"players",
+	"layers"
+};
+
+// FNV-1a 64 bits
+class Checksum {
+public:
+	uint64_t value;
+
+	Checksum() {
+		this->value = 14695981039346656037ULL;
+	}
+
+	void add(const void *data, size_t size) {
+		const unsigned char *bytes = (const unsigned char *)data;
+		for (size_t i = 0; i < size; ++i) {
+			this->value ^= bytes[i];
+			this->value *= 1099511628211ULL;
+		}
+	}
+
+	void add(unsigned long long v) {
+		uint64_t bits = v;
+		this->add(&bits, sizeof(bits));
+	}
+
+	void add(long long v) {
+		this->add((unsigned long long)v);
+	}
+
+	void add(unsigned long v) {
+		this->add((unsigned long long)v);
+	}
+
+	void add(long v) {
+		this->add((long long)v);
+	}
+
+	void add(unsigned int v) {
+		this->add((unsigned long long)v);
+	}
+
+	void add(int v) {
+		this->add((long long)v);
+	}
+
+	void add(bool v) {
+		this->add((unsigned long long)v);
+	}
+
+	// exact bits, -0 same as 0
+	void add(float v) {
+		if (v == 0.0f)
+			v = 0.0f;
+		uint32_t bits;
+		memcpy(&bits, &v, sizeof(bits));
+		this->add((unsigned int)bits);
+	}
+
+	void add(const std::string &v) {
+		this->add((unsigned long long)v.size());
+		this->add(v.data(), v.size());
+	}
+
+	void add(sf::Vector2i v) {
+		this->add(v.x);
+		this->add(v.y);
+	}
+
+	void add(sf::Vector2f v) {
+		this->add(v.x);
+		this->add(v.y);
+	}
+};
+
+struct WorldHash {
+	unsigned long tick;
+	uint64_t parts[WorldHashParts];
+
+	uint64_t total() const {
+		Checksum sum;
+		for (int i = 0; i < WorldHashParts; ++i) {
+			sum.add(this->parts[i]);
+		}
+		return sum.value;
+	}
+};
+
+// checksum of the simulation state, split by parts so a divergence tells what drifted
+// game objects are taken by serial and entities referenced by serial or map position,
+// entity ids depend on effects created when drawing
+class WorldHasher {
+	entt::Registry<EntityID> &registry;
+	Map &map;
+	// players by creation order
+	std::map<EntityID, int> playerIdx;
+
+public:
+	WorldHasher(entt::Registry<EntityID> &registry, Map &map) : registry(registry), map(map) {
+	}
+
+	WorldHash hash(unsigned long tick) {
+		WorldHash hash;
+		hash.tick = tick;
+
+		std::vector<EntityID> players;
+		auto playerView = this->registry.view<Player>();
+		for (EntityID entity : playerView) {
+			players.push_back(entity);
+		}
+		std::sort(players.begin(), players.end());
+		this->playerIdx.clear();
+		for (size_t i = 0; i < players.size(); ++i) {
+			this->playerIdx[players[i]] = i;
+		}
+
+		std::vector<std::pair<unsigned long, EntityID>> objs;
+		auto objView = this->registry.view<GameObject>();
+		for (EntityID entity : objView) {
+			objs.push_back(std::make_pair(objView.get(entity).serial, entity));
+		}
+		std::sort(objs.begin(), objs.end());
+
+		Checksum objSum, unitSum, buildingSum;
+		for (auto &pair : objs) {
+			EntityID entity = pair.second;
+			GameObject &obj = this->registry.get<GameObject>(entity);
+			objSum.add(obj.serial);
+			objSum.add(obj.name);
+			objSum.add(obj.team);
+			objSum.add(obj.life);
+			objSum.add(obj.maxLife);
+			objSum.add(obj.view);
+			objSum.add(obj.mapped);
+			objSum.add(this->ref(obj.player));
+
+			if (this->registry.has<Tile>(entity)) {
+				Tile &tile = this->registry.get<Tile>(entity);
+				objSum.add(tile.pos);
+				objSum.add(tile.ppos);
+				objSum.add(tile.size);
+				objSum.add(tile.state);
+				objSum.add(tile.view);
+			}
+
+			if (this->registry.has<Unit>(entity)) {
+				Unit &unit = this->registry.get<Unit>(entity);
+				unitSum.add(obj.serial);
+				unitSum.add(unit.speed);
+				unitSum.add((int)unit.targetType);
+				unitSum.add(this->ref(unit.targetEnt));
+				unitSum.add(unit.targetPos);
+				unitSum.add(unit.destpos);
+				unitSum.add(unit.velocity);
+				unitSum.add(unit.averageVelocity);
+				unitSum.add(unit.direction);
+				unitSum.add(unit.pathPos);
+				unitSum.add(unit.pathUpdate);
+				unitSum.add(unit.commanded);
+				unitSum.add(unit.nopath);
+				unitSum.add(unit.groupDest);
+				unitSum.add(unit.special);
+			}
+
+			if (this->registry.has<Building>(entity)) {
+				Building &building = this->registry.get<Building>(entity);
+				buildingSum.add(obj.serial);
+				buildingSum.add(building.buildTime);
+				buildingSum.add(building.maxBuildTime);
+				buildingSum.add(this->ref(building.construction));
+				buildingSum.add(this->ref(building.constructedBy));
+			}
+		}
+		hash.parts[ObjectsHash] = objSum.value;
+		hash.parts[UnitsHash] = unitSum.value;
+		hash.parts[BuildingsHash] = buildingSum.value;
+
+		// resources by map position
+		std::vector<std::pair<int, EntityID>> resources;
+		auto resView = this->registry.view<Resource, Tile>();
+		for (EntityID entity : resView) {
+			Tile &tile = resView.get<Tile>(entity);
+			resources.push_back(std::make_pair(this->map.objs.index(tile.pos.x, tile.pos.y), entity));
+		}
+		std::sort(resources.begin(), resources.end());
+
+		Checksum resSum;
+		for (auto &pair : resources) {
+			Resource &resource = this->registry.get<Resource>(pair.second);
+			resSum.add(pair.first);
+			resSum.add(resource.type);
+			resSum.add(resource.level);
+			resSum.add(resource.grow);
+			resSum.add(resource.growRate);
+		}
+		hash.parts[ResourcesHash] = resSum.value;
+
+		Checksum playerSum;
+		for (EntityID entity : players) {
+			Player &player = this->registry.get<Player>(entity);
+			playerSum.add(this->ref(entity));
+			playerSum.add(player.team);
+			playerSum.add(player.ai);
+			playerSum.add(player.resourceType);
+			playerSum.add(player.resources);
+			playerSum.add((unsigned long)player.kills.size());
+			playerSum.add(player.butchery);
+			playerSum.add(player.enemyFound);
+			playerSum.add(player.enemyPos);
+			playerSum.add(this->ref(player.rootConstruction));
+			for (auto &stat : player.stats) {
+				playerSum.add(stat.first);
+				playerSum.add(stat.second);
+			}
+			for (auto &objsType : player.objsByType) {
+				playerSum.add(objsType.first);
+				for (EntityID obj : objsType.second) {
+					playerSum.add(this->ref(obj));
+				}
+			}
+			for (int i = 0; i < player.fog.size(); ++i) {
+				playerSum.add((int)player.fog.grid[i]);
+			}
+		}
+		hash.parts[PlayersHash] = playerSum.value;
+
+		Checksum layerSum;
+		for (Layer<int> &layer : this->map.terrains) {
+			this->addLayer(layerSum, layer);
+		}
+		this->addRefLayer(layerSum, this->map.objs);
+		this->addRefLayer(layerSum, this->map.resources);
+		this->addRefLayer(layerSum, this->map.decors);
+		this->addRefLayer(layerSum, this->map.corpses);
+		this->addRefLayer(layerSum, this->map.staticBuildable);
+		this->addRefLayer(layerSum, this->map.staticPathfinding);
+		this->addRefLayer(layerSum, this->map.pathfinding);
+		hash.parts[LayersHash] = layerSum.value;
+
+		return hash;
+	}
+
+private:
+	// stable reference of an entity : serial of game objects, index of players, map position of others
+	uint64_t ref(EntityID entity) {
+		if (!entity || !this->registry.valid(entity))
+			return 0;
+		if (this->registry.has<GameObject>(entity))
+			return this->registry.get<GameObject>(entity).serial;
+		if (this->registry.has<Player>(entity))
+			return (1ULL << 32) | this->playerIdx[entity];
+		if (this->registry.has<Tile>(entity)) {
+			Tile &tile = this->registry.get<Tile>(entity);
+			return (2ULL << 32) | (uint32_t)this->map.objs.index(tile.pos.x, tile.pos.y);
+		}
+		return 3ULL << 32;
+	}
+
+	void addLayer(Checksum &sum, Layer<int> &layer) {
+		sum.add(layer.grid.data(), layer.grid.size() * sizeof(int));
+	}
+
+	void addRefLayer(Checksum &sum, Layer<EntityID> &layer) {
+		for (int i = 0; i < layer.size(); ++i) {
+			sum.add(this->ref(layer.grid[i]));
+		}
+	}
+};
+
+// match settings followed by one line per tick
+// <tick> <total> <parts...>
+class WorldHashStream {
+public:
+	MatchSettings settings;
+	std::vector<WorldHash> hashes;
+
+	bool load(std::string filename) {
+		std::ifstream file(filename);
+		if (!file) {
+			std::cerr << "ERROR: cannot read world hashes " << filename << std::endl;
+			return false;
+		}
+
+		std::string magic;
+		int version;
+		file >> magic >> version;
+		if (magic != "bfr_worldhash" || version != WORLDHASH_VERSION) {
+			std::cerr << "ERROR: " << filename << " is not a version " << WORLDHASH_VERSION << " world hash file" << std::endl;
+			return false;
+		}
+
+		this->hashes.clear();
+
+		std::string line;
+		while (std::getline(file, line)) {
+			std::istringstream in(line);
+			std::string key;
+			if (!(in >> key))
+				continue;
+
+			if (this->settings.read(key, in)) {
+				continue;
+			} else if (isdigit(key[0])) {
+				WorldHash hash;
+				uint64_t total;
+				hash.tick = std::stoul(key);
+				in >> std::hex >> total;
+				for (int i = 0; i < WorldHashParts; ++i) {
+					in >> hash.parts[i];
+				}
+				if (!in || total != hash.total()) {
+					std::cerr << "ERROR: invalid world hash line " << line << std::endl;
+					return false;
+				}
+				this->hashes.push_back(hash);
+			} else {
+				std::cerr << "ERROR: unknown world hash line " << line << std::endl;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void writeSettings(std::ostream &out, const MatchSettings &settings) {
+		out << "bfr_worldhash " << WORLDHASH_VERSION << std::endl;
+		settings.write(out);
+	}
+
+	static void writeHash(std::ostream &out, const WorldHash &hash) {
+		out << hash.tick << std::hex << std::setfill('0');
+		out << " " << std::setw(16) << hash.total();
+		for (int i = 0; i < WorldHashParts; ++i) {
+			out << " " << std::setw(16) << hash.parts[i];
+		}
+		out << std::dec << std::setfill(' ') << std::endl;
+	}
+
+	// index of the first hash differing from golden, -1 if none
+	static int compare(const std::vector<WorldHash> &golden, const std::vector<WorldHash> &hashes, std::ostream &out) {
+		size_t count = std::min(golden.size(), hashes.size());
+		for (size_t i = 0; i < count; ++i) {
+			if (golden[i].tick != hashes[i].tick || golden[i].total() != hashes[i].total()) {
+				out << "WorldHash: diverged at tick " << hashes[i].tick << ":";
+				for (int p = 0; p < WorldHashParts; ++p) {
+					if (golden[i].parts[p] != hashes[i].parts[p])
+						out << " " << worldHashPartNames[p];
+				}
+				out << std::endl;
+				return i;
+			}
+		}
+		if (golden.size() != hashes.size()) {
+			out << "WorldHash: " << hashes.size() << " ticks hashed, golden has " << golden.size() << std::endl;
+			return count;
+		}
+		return -1;
+	}
+};
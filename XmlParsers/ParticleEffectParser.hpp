@@ -55,11 +55,25 @@ static std::map<std::string, VelocityGeneratorMode> velGenModes =
 
 
 class ParticleEffectParser {
-	sf::Shader metaballShader;
+	// compiled on first metaball effect, shaders need a GL context
+	sf::Shader *metaballShader;
 public:
 
 	ParticleEffectParser() {
-		metaballShader.loadFromMemory(particles::metaballVertexShader, particles::metaballFragmentShader);
+		metaballShader = nullptr;
+	}
+
+	~ParticleEffectParser() {
+		if (metaballShader)
+			delete metaballShader;
+	}
+
+	sf::Shader *getMetaballShader() {
+		if (!metaballShader) {
+			metaballShader = new sf::Shader();
+			metaballShader->loadFromMemory(particles::metaballVertexShader, particles::metaballFragmentShader);
+		}
+		return metaballShader;
 	}
 
 	sf::Color parseColor(tinyxml2::XMLElement *element) {
@@ -164,7 +178,7 @@ public:
 			break;
 			case ParticleSystemMode::Metaball: {
 				// FIXME size == screen size
-				auto metaball = new particles::MetaballParticleSystem(max, &(options.texMgr->getRef(particleEl->Attribute("name"))), &metaballShader);
+				auto metaball = new particles::MetaballParticleSystem(max, &(options.texMgr->getRef(particleEl->Attribute("name"))), this->getMetaballShader());
 				metaball->color = this->parseColor(particleEl);
 				effect.particleSystem = metaball;
 			}
@@ -77,7 +77,7 @@ public:
 		if (element->Attribute("count"))
 			count = element->IntAttribute("count");
 
-		std::string stateNm = element->Attribute("name");
+		TileState stateNm = TileStateStr(element->Attribute("name"));
 		spritesheet.states[stateNm] = std::vector<AnimatedSpriteView>();
 
 		for (tinyxml2::XMLElement *viewEl : element) {
@@ -99,7 +99,7 @@ public:
 	}
 
 	void parseStaticSpritesheet(StaticSpritesheet &spritesheet, tinyxml2::XMLElement *element) {
-		std::string stateNm = element->Attribute("name");
+		TileState stateNm = TileStateStr(element->Attribute("name"));
 
 		for (tinyxml2::XMLElement *viewEl : element) {
 			SpriteView view;
@@ -150,6 +150,7 @@ public:
 		obj.maxLife = obj.life;
 		obj.name = element->FirstChildElement("name")->Attribute("value");
 		obj.team = element->FirstChildElement("team")->Attribute("value");
+		obj.teamId = TeamIDStr(obj.team.c_str());
 
 	}
 };
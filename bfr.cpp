@@ -4,9 +4,12 @@
 #include "Stages/Settings.hpp"
 #include "Stages/PlayMenu.hpp"
 #include "Stages/GameOver.hpp"
+#include "Headless.hpp"
 
 #include "third_party/argagg.hpp"
 
+#include <sstream>
+
 int main(int argc, char *argv[])
 {
 #ifdef WITHGPERFTOOLS
@@ -35,6 +38,45 @@ int main(int argc, char *argv[])
 			},
 			{	"version", {"-v", "--version"},
 				"version", 0
+			},
+			{	"headless", {"--headless"},
+				"run AI players without window and report simulation performances", 0
+			},
+			{	"map_width", {"--map-width"},
+				"headless map width (default: 64)", 1
+			},
+			{	"map_height", {"--map-height"},
+				"headless map height (default: 64)", 1
+			},
+			{	"teams", {"--teams"},
+				"headless AI teams, up to 4 (default: rebel,neonaz,rebel,neonaz)", 1
+			},
+			{	"seed", {"--seed"},
+				"headless random seed (default: 0)", 1
+			},
+			{	"ticks", {"--ticks"},
+				"headless game ticks to run (default: 1000)", 1
+			},
+			{	"output", {"-o", "--output"},
+				"headless JSON report file", 1
+			},
+			{	"hashes", {"--hashes"},
+				"headless world state hashes file, one line per tick", 1
+			},
+			{	"golden", {"--golden"},
+				"headless world state hashes to compare with, settings and ticks are read from it", 1
+			},
+			{	"trace", {"--trace"},
+				"headless chrome trace JSON file", 1
+			},
+			{	"record", {"--record"},
+				"write games commands to a replay file", 1
+			},
+			{	"replay", {"--replay"},
+				"play a replay file", 1
+			},
+			{	"scenario", {"--scenario"},
+				"play a scenario file, its map, seed and players, as scenarios/stress_500.xml", 1
 			}
 		}};
 
@@ -62,6 +104,66 @@ int main(int argc, char *argv[])
 		return EXIT_SUCCESS;
 	}
 
+	if (args["headless"]) {
+		HeadlessRun headless;
+		if (args["scenario"]) {
+			Scenario scenario;
+			std::string filename = args["scenario"].as<std::string>();
+			if (!scenario.load(filename))
+				return EXIT_FAILURE;
+			if (args["teams"]) {
+				std::cerr << "teams are given by the scenario" << std::endl;
+				return EXIT_FAILURE;
+			}
+			scenario.apply(headless.settings, filename);
+		}
+		if (args["map_width"])
+			headless.settings.mapWidth = args["map_width"];
+		if (args["map_height"])
+			headless.settings.mapHeight = args["map_height"];
+		if (args["seed"])
+			headless.settings.seed = args["seed"];
+		if (args["ticks"])
+			headless.ticks = args["ticks"].as<unsigned long>();
+		if (args["output"])
+			headless.output = args["output"].as<std::string>();
+		if (args["record"])
+			headless.record = args["record"].as<std::string>();
+		if (args["replay"])
+			headless.replay = args["replay"].as<std::string>();
+		if (args["hashes"])
+			headless.hashes = args["hashes"].as<std::string>();
+		if (args["golden"])
+			headless.golden = args["golden"].as<std::string>();
+		if (args["trace"])
+			headless.trace = args["trace"].as<std::string>();
+		if (args["teams"]) {
+			std::stringstream teams(args["teams"].as<std::string>());
+			std::string team;
+			while (std::getline(teams, team, ',')) {
+				if (team != "rebel" && team != "neonaz") {
+					std::cerr << "unknown team " << team << std::endl;
+					return EXIT_FAILURE;
+				}
+				headless.settings.aiTeams.push_back(team);
+			}
+			if (headless.settings.aiTeams.size() == 0 || headless.settings.aiTeams.size() > 4) {
+				std::cerr << "1 to 4 teams expected" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		if (headless.settings.mapWidth < 32 || headless.settings.mapHeight < 32) {
+			std::cerr << "map must be at least 32x32" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		int status = headless.run();
+#ifdef WITHGPERFTOOLS
+		ProfilerStop();
+#endif
+		return status;
+	}
+
 	if (args["fullscreen"]) {
 		fullscreen = true;
 		customSettings = true;
@@ -89,6 +191,9 @@ int main(int argc, char *argv[])
 	game.registerStage("play_menu", new PlayMenu(&game));
 	game.registerStage("game_over", new GameOver(&game));
 
+	if (args["record"])
+		game.replayRecord = args["record"].as<std::string>();
+
 	/*
 		Player p;
 		p.resources = 1034;
@@ -97,7 +202,27 @@ int main(int argc, char *argv[])
 		go->player = p;
 	    game.pushRegisteredStage("game_over");
 	*/
-	game.pushRegisteredStage("main_menu");
+	if (args["replay"]) {
+		Replay replay;
+		if (!replay.load(args["replay"].as<std::string>()))
+			return EXIT_FAILURE;
+		GameEngine *engine = new GameEngine(&game, replay.settings);
+		engine->commands.play(replay);
+		game.registerStage("game", engine);
+		game.pushRegisteredStage("game");
+	} else if (args["scenario"]) {
+		Scenario scenario;
+		MatchSettings settings;
+		std::string filename = args["scenario"].as<std::string>();
+		if (!scenario.load(filename))
+			return EXIT_FAILURE;
+		scenario.apply(settings, filename);
+		GameEngine *engine = new GameEngine(&game, settings);
+		game.registerStage("game", engine);
+		game.pushRegisteredStage("game");
+	} else {
+		game.pushRegisteredStage("main_menu");
+	}
 
 	game.loop();
 
@@ -0,0 +1,529 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "Components/Components.hpp"
+#include "MatchRandom.hpp"
+#include "Map.hpp"
+#include "FlowField.hpp"
+#include "Quadtree.hpp"
+#include "GridDbscan.hpp"
+#include "SpatialHash.hpp"
+#include "SteeringBatch.hpp"
+#include "ObstacleField.hpp"
+#include "InfluenceMap.hpp"
+#include "FogSight.hpp"
+#include "third_party/JPS.h"
+#include "Systems/MapLayersSystem.hpp"
+#include "tests/wanderers.hpp"
+
+// engine kernels on generated fixtures, one JSON result per kernel and fixture
+// usage: bench [-o results.json] [-r repeats] [name filter]
+
+#define BENCH_VERSION 1
+
+// results the optimizer must not drop
+static volatile long benchSink = 0;
+
+struct BenchResult {
+	std::string name;
+	std::string fixture;
+	int iterations;
+	// per iteration, microseconds
+	double min;
+	double median;
+	double mean;
+};
+
+class Bench {
+public:
+	std::vector<BenchResult> results;
+	// timed samples of each benchmark
+	int repeats;
+	std::string filter;
+
+	Bench() {
+		this->repeats = 7;
+	}
+
+	// fn is called iterations times per sample, after one untimed warmup sample
+	template <typename F>
+	void run(std::string name, std::string fixture, int iterations, F fn) {
+		if (this->filter.size() > 0 && name.find(this->filter) == std::string::npos)
+			return;
+
+		for (int i = 0; i < iterations; ++i) {
+			fn(i);
+		}
+
+		std::vector<double> samples;
+		for (int r = 0; r < this->repeats; ++r) {
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; ++i) {
+				fn(i);
+			}
+			double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+			samples.push_back(us / iterations);
+		}
+		std::sort(samples.begin(), samples.end());
+
+		BenchResult result;
+		result.name = name;
+		result.fixture = fixture;
+		result.iterations = iterations;
+		result.min = samples.front();
+		result.median = samples[samples.size() / 2];
+		result.mean = 0.0;
+		for (double sample : samples) {
+			result.mean += sample;
+		}
+		result.mean /= samples.size();
+		this->results.push_back(result);
+
+		std::cout << std::left << std::setw(24) << name << std::setw(12) << fixture << std::right
+		          << std::setw(12) << std::fixed << std::setprecision(3) << result.median << "us"
+		          << std::setw(12) << result.min << "us min" << std::endl;
+	}
+
+	void writeJson(std::ostream &out) {
+		out << "{" << std::endl;
+		out << "  \"version\": " << BENCH_VERSION << "," << std::endl;
+#ifdef __VERSION__
+		out << "  \"compiler\": \"" << __VERSION__ << "\"," << std::endl;
+#endif
+		out << "  \"repeats\": " << this->repeats << "," << std::endl;
+		out << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << "," << std::endl;
+		out << "  \"results\": [";
+		for (size_t i = 0; i < this->results.size(); ++i) {
+			BenchResult &result = this->results[i];
+			out << (i > 0 ? "," : "") << std::endl << "    {\"name\": \"" << result.name << "\", \"fixture\": \"" << result.fixture
+			    << "\", \"iterations\": " << result.iterations << std::fixed << std::setprecision(3)
+			    << ", \"min_us\": " << result.min << ", \"median_us\": " << result.median << ", \"mean_us\": " << result.mean << "}";
+		}
+		out << std::endl << "  ]" << std::endl;
+		out << "}" << std::endl;
+	}
+};
+
+// map of a PlayMenu size, lakes and scattered decors block the way, terrains in blobs
+struct MapFixture {
+	std::string name;
+	Map map;
+
+	MapFixture(unsigned int size, uint32_t seed) {
+		std::stringstream ss;
+		ss << size << "x" << size;
+		this->name = ss.str();
+		this->map.setSize(size, size);
+
+		MatchRandom rnd;
+		rnd.seed(seed);
+
+		int lakes = size * size / 600;
+		for (int i = 0; i < lakes; ++i) {
+			int cx = rnd.range(size);
+			int cy = rnd.range(size);
+			int radius = 2 + rnd.range(5);
+			for (int y = cy - radius; y <= cy + radius; ++y) {
+				for (int x = cx - radius; x <= cx + radius; ++x) {
+					if (this->map.bound(x, y) && (x - cx) * (x - cx) + (y - cy) * (y - cy) <= radius * radius) {
+						this->map.staticPathfinding.set(x, y, 1);
+						this->map.terrains[Terrain].set(x, y, Water);
+					}
+				}
+			}
+		}
+
+		int decors = size * size / 12;
+		for (int i = 0; i < decors; ++i) {
+			this->map.staticPathfinding.set(rnd.range(size), rnd.range(size), 1);
+		}
+
+		int blobs = size * size / 200;
+		for (int i = 0; i < blobs; ++i) {
+			int cx = rnd.range(size);
+			int cy = rnd.range(size);
+			int radius = 1 + rnd.range(6);
+			int terrain = rnd.range(2) ? Grass : Concrete;
+			for (int y = cy - radius; y <= cy + radius; ++y) {
+				for (int x = cx - radius; x <= cx + radius; ++x) {
+					if (this->map.bound(x, y) && this->map.terrains[Terrain].get(x, y) != Water)
+						this->map.terrains[Terrain].set(x, y, terrain);
+				}
+			}
+		}
+
+		this->map.updateWalkable();
+	}
+
+	sf::Vector2i randomWalkable(MatchRandom &rnd) {
+		sf::Vector2i p;
+		do {
+			p = sf::Vector2i(rnd.range(this->map.width), rnd.range(this->map.height));
+		} while (!this->map.pathAvailable(p.x, p.y));
+		return p;
+	}
+};
+
+class QuadtreeObject : public sf::Vector2f {
+public:
+	EntityID entity;
+
+	QuadtreeObject(EntityID ent, float x, float y) : sf::Vector2f(x, y), entity(ent) {}
+};
+
+// units gathered in a few groups as armies, pixel positions
+std::vector<Point> unitCloud(int count, int groups, float mapPixels, uint32_t seed) {
+	MatchRandom rnd;
+	rnd.seed(seed);
+	std::vector<Point> centers;
+	for (int i = 0; i < groups; ++i) {
+		centers.push_back(Point{rnd.uniform() * mapPixels, rnd.uniform() * mapPixels});
+	}
+	std::vector<Point> points;
+	for (int i = 0; i < count; ++i) {
+		Point &center = centers[rnd.range(groups)];
+		points.push_back(Point{center.x + (rnd.uniform() - 0.5f) * 320.0f, center.y + (rnd.uniform() - 0.5f) * 320.0f});
+	}
+	return points;
+}
+
+// exposes the map kernels of the systems
+class BenchMapLayers : public MapLayersSystem {
+public:
+	BenchMapLayers(Map *map) {
+		this->setShared(nullptr, map, 0, 0);
+	}
+};
+
+void benchMap(Bench &bench, MapFixture &fixture) {
+	Map &map = fixture.map;
+	MatchRandom rnd;
+	rnd.seed(7);
+
+	std::vector<sf::Vector2i> targets;
+	for (int i = 0; i < 64; ++i) {
+		targets.push_back(fixture.randomWalkable(rnd));
+	}
+
+	FlowField sectorField;
+	sectorField.setGrid(&map, sf::IntRect(map.width / 2, map.height / 2, PER_SECTOR, PER_SECTOR));
+	bench.run("flowfield.build.sector", fixture.name, 1000, [&](int i) {
+		sectorField.build(sf::Vector2i(i % PER_SECTOR, (i / PER_SECTOR) % PER_SECTOR));
+		benchSink += sectorField.get(0, 0);
+	});
+
+	FlowField mapField;
+	mapField.setGrid(&map);
+	bench.run("flowfield.build.map", fixture.name, 10, [&](int i) {
+		mapField.build(targets[i % targets.size()]);
+		benchSink += mapField.get(0, 0);
+	});
+
+	JPS::Searcher<WalkabilityBitmap> searcher(map.walkable);
+	bench.run("jps.findPath", fixture.name, 32, [&](int i) {
+		JPS::PathVector path;
+		sf::Vector2i start = targets[i % targets.size()];
+		sf::Vector2i end = targets[(i * 7 + 3) % targets.size()];
+		searcher.findPath(path, JPS::Pos(start.x, start.y), JPS::Pos(end.x, end.y), 1);
+		benchSink += path.size();
+	});
+
+	BenchMapLayers layers(&map);
+	bench.run("transitionBitmask", fixture.name, 4, [&](int i) {
+		long sum = 0;
+		for (unsigned int y = 0; y < map.height; ++y) {
+			for (unsigned int x = 0; x < map.width; ++x) {
+				sum += layers.transitionBitmask(map.terrains[Terrain], Grass, x, y);
+			}
+		}
+		benchSink += sum;
+	});
+
+	Tile tile;
+	tile.size = sf::Vector2i(1, 1);
+	bench.run("tileSurfaceExtended", fixture.name, 1000, [&](int i) {
+		tile.pos = targets[i % targets.size()];
+		benchSink += layers.tileSurfaceExtended(tile, 2 + i % 6).size();
+	});
+
+	ObstacleField field;
+	field.setSize(map.width, map.height);
+	bench.run("obstaclefield.build", fixture.name, 4, [&](int i) {
+		field.update(map.walkable, sf::IntRect(0, 0, map.width, map.height));
+	});
+
+	// a building placed then removed
+	bench.run("obstaclefield.update", fixture.name, 100, [&](int i) {
+		sf::Vector2i p = targets[i % targets.size()];
+		sf::IntRect rect(p.x, p.y, 3, 3);
+		bool open = (i / targets.size()) % 2;
+		for (int y = rect.top; y < std::min((int)map.height, rect.top + rect.height); ++y) {
+			for (int x = rect.left; x < std::min((int)map.width, rect.left + rect.width); ++x) {
+				map.walkable.set(x, y, open);
+			}
+		}
+		field.update(map.walkable, rect);
+	});
+	map.updateWalkable();
+	field.update(map.walkable, sf::IntRect(0, 0, map.width, map.height));
+
+	std::vector<sf::Vector2f> positions;
+	for (int i = 0; i < 1000; ++i) {
+		positions.push_back(sf::Vector2f(rnd.uniform() * map.width * 32.0f, rnd.uniform() * map.height * 32.0f));
+	}
+
+	// the per unit 3x3 cells probe the field replaces
+	bench.run("obstacle.probe", fixture.name, 10, [&](int i) {
+		sf::Vector2f total(0, 0);
+		for (sf::Vector2f &ppos : positions) {
+			sf::Vector2i pos(ppos / 32.0f);
+			std::vector<sf::Vector2f> cases;
+			for (int cx = pos.x - 1; cx <= pos.x + 1; ++cx) {
+				for (int cy = pos.y - 1; cy <= pos.y + 1; ++cy) {
+					if (!map.walkable(cx, cy))
+						cases.push_back(sf::Vector2f(cx * 32.0f, cy * 32.0f));
+				}
+			}
+			for (sf::Vector2f &c : cases) {
+				if (distance(ppos, c) <= 16.0f)
+					total += normalize(ppos - c);
+			}
+		}
+		benchSink += (long)(total.x + total.y);
+	});
+
+	bench.run("obstaclefield.sample", fixture.name, 10, [&](int i) {
+		sf::Vector2f total(0, 0);
+		for (sf::Vector2f &ppos : positions) {
+			float dist;
+			sf::Vector2f gradient;
+			if (field.sample(ppos, dist, gradient) && dist < 16.0f)
+				total += gradient;
+		}
+		benchSink += (long)(total.x + total.y);
+	});
+
+	Layer<EntityID> layer;
+	bench.run("layer.fill", fixture.name, 100, [&](int i) {
+		layer.setSize(map.width, map.height);
+		benchSink += layer.size();
+	});
+	bench.run("layer.clear", fixture.name, 100, [&](int i) {
+		layer.clear();
+		benchSink += layer.get(i % map.width, 0);
+	});
+}
+
+void benchCloud(Bench &bench, int count, float mapPixels) {
+	std::stringstream ss;
+	ss << count << "units";
+	std::string fixture = ss.str();
+	std::vector<Point> cloud = unitCloud(count, 8, mapPixels, count);
+
+	Quadtree<QuadtreeObject> qt(0, 0, mapPixels, mapPixels, 16);
+	bench.run("quadtree.insert", fixture, 10, [&](int i) {
+		qt.clear();
+		for (size_t p = 0; p < cloud.size(); ++p) {
+			qt.add(QuadtreeObject(p, cloud[p].x, cloud[p].y));
+		}
+	});
+
+	std::vector<QuadtreeObject> found;
+	bench.run("quadtree.retrieve", fixture, 1000, [&](int i) {
+		Point &p = cloud[i % cloud.size()];
+		found.clear();
+		qt.retrieve(found, p.x - 128.0f, p.y - 128.0f, 256.0f, 256.0f);
+		benchSink += found.size();
+	});
+
+	std::vector<int> labels;
+	bench.run("dbscan", fixture, 4, [&](int i) {
+		benchSink += dbscan(cloud, labels, 48.0, 3);
+	});
+
+	GridDbscan grid;
+	bench.run("dbscan.grid", fixture, 10, [&](int i) {
+		benchSink += grid.run(cloud, labels, 48.0, 3);
+	});
+}
+
+// units of 4 players wandering on a square map, each iteration is a tick moving them first
+void benchWanderers(Bench &bench, int count, int mapSize) {
+	std::stringstream ss;
+	ss << count << "units";
+	std::string fixture = ss.str();
+	const int players = 4;
+
+	Wanderers fogWanderers(count, players, mapSize, count);
+	Fog fogs[players];
+	for (int i = 0; i < players; ++i) {
+		fogs[i].setSize(mapSize, mapSize);
+	}
+	auto fogOf = [&fogs](EntityID player) -> Fog & {
+		return fogs[player];
+	};
+	FogSight sight;
+	bench.run("fogsight.update", fixture, 50, [&](int i) {
+		fogWanderers.step(2000);
+		sight.begin();
+		for (Wanderer &unit : fogWanderers.units) {
+			if (unit.alive && !sight.keep(unit.entity, unit.player, unit.pos, unit.view))
+				sight.see(unit.entity, unit.player, unit.pos, unit.view, fogWanderers.viewCells(unit), fogOf);
+		}
+		sight.end(fogOf);
+		for (int p = 0; p < players; ++p) {
+			fogs[p].clearChanged();
+		}
+	});
+
+	// every InSight cell hidden then every unit stamped, as before FogSight
+	Wanderers stampWanderers(count, players, mapSize, count);
+	Fog stamped[players];
+	for (int i = 0; i < players; ++i) {
+		stamped[i].setSize(mapSize, mapSize);
+	}
+	bench.run("fog.restamp", fixture, 50, [&](int i) {
+		stampWanderers.step(2000);
+		for (int p = 0; p < players; ++p) {
+			for (int c = 0; c < stamped[p].size(); ++c) {
+				if (stamped[p].grid[c] == FogState::InSight)
+					stamped[p].grid[c] = FogState::Hidden;
+			}
+		}
+		for (Wanderer &unit : stampWanderers.units) {
+			if (unit.alive) {
+				for (sf::Vector2i const &p : stampWanderers.viewCells(unit)) {
+					stamped[unit.player].set(p.x, p.y, FogState::InSight);
+				}
+			}
+		}
+	});
+
+	TeamID teams[players] = {TeamIDStr("rebel"), TeamIDStr("neonaz"), TeamIDStr("other"), TeamIDStr("more")};
+	Wanderers influenceWanderers(count, players, mapSize, count);
+	InfluenceMap influence;
+	influence.setSize(mapSize, mapSize);
+	bench.run("influence.update", fixture, 50, [&](int i) {
+		influenceWanderers.step(2000);
+		influence.tick();
+		for (Wanderer &unit : influenceWanderers.units) {
+			if (unit.alive)
+				influence.move(unit.entity, teams[unit.player], unit.pos);
+			else
+				influence.remove(unit.entity);
+		}
+	});
+}
+
+class SteeringObject : public sf::Vector2f {
+public:
+	unsigned int idx;
+
+	SteeringObject(unsigned int i, sf::Vector2f p) : sf::Vector2f(p), idx(i) {}
+};
+
+// steering batch of a unit cloud on 1 to 8 threads, the caller included
+// neighbours are gathered in the workers like SteeringSystem does, speedups are against one thread
+void benchSteering(Bench &bench, int count, float mapPixels) {
+	std::stringstream ss;
+	ss << count << "units";
+	std::string fixture = ss.str();
+	std::vector<Point> cloud = unitCloud(count, 8, mapPixels, count);
+
+	MatchRandom rnd;
+	rnd.seed(count);
+	SpatialHash<SteeringObject> hash(mapPixels, mapPixels);
+	std::vector<sf::Vector2f> velocities;
+	std::vector<sf::Vector2i> directions;
+	for (int i = 0; i < count; ++i) {
+		hash.add(SteeringObject(i, sf::Vector2f(cloud[i].x, cloud[i].y)));
+		velocities.push_back(sf::Vector2f(rnd.uniform() * 2.0f - 1.0f, rnd.uniform() * 2.0f - 1.0f));
+		directions.push_back(sf::Vector2i(rnd.range(3) - 1, rnd.range(3) - 1));
+	}
+	hash.build();
+
+	double single = 0.0;
+	for (int threads = 1; threads <= 8; threads *= 2) {
+		ChunkWorkers workers;
+		workers.start(threads - 1);
+		SteeringBatch batch;
+		std::stringstream name;
+		name << "steering.batch.t" << threads;
+		size_t done = bench.results.size();
+		bench.run(name.str(), fixture, 10, [&](int i) {
+			batch.clear();
+			for (int u = 0; u < count; ++u) {
+				batch.add(sf::Vector2f(cloud[u].x, cloud[u].y), velocities[u], 1.5f);
+			}
+			batch.run(workers, [&](unsigned int u, SteeringPairs & pairs) {
+				hash.forEach(cloud[u].x - 32.0f, cloud[u].y - 32.0f, 64.0f, 64.0f, [&pairs, u](const SteeringObject & other) {
+					if (other.idx != u)
+						pairs.addNeighbor(other);
+				});
+				batch.setFlow(u, sf::Vector2f(directions[u]), 1.5f);
+			});
+			benchSink += batch.outX.size();
+		});
+
+		if (bench.results.size() > done) {
+			if (threads == 1)
+				single = bench.results.back().median;
+			else if (single > 0.0)
+				std::cout << "  speedup " << single / bench.results.back().median << " on " << threads << " threads" << std::endl;
+		}
+	}
+}
+
+int main(int argc, char *argv[]) {
+	Bench bench;
+	std::string output;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output = argv[++i];
+		} else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+			bench.repeats = std::max(1, atoi(argv[++i]));
+		} else {
+			bench.filter = argv[i];
+		}
+	}
+
+	// PlayMenu map sizes
+	unsigned int sizes[] = {48, 72, 96, 120, 144};
+	for (unsigned int size : sizes) {
+		MapFixture fixture(size, size);
+		benchMap(bench, fixture);
+	}
+
+	int clouds[] = {100, 500, 2000};
+	for (int count : clouds) {
+		benchCloud(bench, count, 96 * 32.0f);
+	}
+
+	benchWanderers(bench, 4000, 256);
+
+	// the sweep only tells something with as many hardware threads
+	std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+	int crowds[] = {2000, 10000};
+	for (int count : crowds) {
+		benchSteering(bench, count, 128 * 32.0f);
+	}
+
+	if (output.size() > 0) {
+		std::ofstream file(output);
+		if (!file) {
+			std::cerr << "ERROR: cannot write " << output << std::endl;
+			return EXIT_FAILURE;
+		}
+		bench.writeJson(file);
+	}
+	return EXIT_SUCCESS;
+}
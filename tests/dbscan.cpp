@@ -0,0 +1,117 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "GridDbscan.hpp"
+
+double elapsed(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// front points like CombatSystem: attacked cells around a few battles
+void bench(int count, double eps, int min) {
+	std::vector<Point> points;
+	for (int i = 0; i < count; ++i) {
+		double cx = (rand() % 8) * 32.0;
+		double cy = (rand() % 8) * 32.0;
+		points.push_back(Point{cx + rand() % 24, cy + rand() % 24});
+	}
+
+	std::vector<int> refLabels;
+	auto start = std::chrono::high_resolution_clock::now();
+	int refClusters = dbscan(points, refLabels, eps, min);
+	double refTime = elapsed(start);
+
+	GridDbscan grid;
+	std::vector<int> labels;
+	start = std::chrono::high_resolution_clock::now();
+	int clusters = grid.run(points, labels, eps, min);
+	double gridTime = elapsed(start);
+
+	// buffers of the previous pass reused
+	start = std::chrono::high_resolution_clock::now();
+	grid.run(points, labels, eps, min);
+	double reuseTime = elapsed(start);
+
+	int mismatches = (clusters != refClusters);
+	for (int i = 0; i < count; ++i) {
+		if (labels[i] != refLabels[i])
+			mismatches++;
+	}
+
+	std::cout << "DBSCAN " << count << " points eps " << eps
+	          << " reference: " << refTime << "ms"
+	          << " grid: " << gridTime << "ms"
+	          << " reused: " << reuseTime << "ms"
+	          << " speedup: " << refTime / gridTime
+	          << " clusters: " << clusters
+	          << " mismatches: " << mismatches << std::endl;
+}
+
+// a few points move, appear or vanish between passes, clusters of the previous pass are reused
+int drift(int count, double eps, int min, int passes) {
+	std::vector<Point> points;
+	for (int i = 0; i < count; ++i) {
+		double cx = (rand() % 8) * 32.0;
+		double cy = (rand() % 8) * 32.0;
+		points.push_back(Point{cx + rand() % 24, cy + rand() % 24});
+	}
+
+	GridDbscan grid;
+	std::vector<int> labels;
+	std::vector<int> refLabels;
+	int mismatches = 0;
+	long reused = 0;
+	long cores = 0;
+	double gridTime = 0.0;
+	double freshTime = 0.0;
+	for (int pass = 0; pass < passes; ++pass) {
+		for (int i = 0; i < count / 50; ++i) {
+			Point &p = points[rand() % points.size()];
+			p.x += rand() % 3 - 1;
+			p.y += rand() % 3 - 1;
+		}
+		if (rand() % 2)
+			points.erase(points.begin() + rand() % points.size());
+		else
+			points.insert(points.begin() + rand() % points.size(), Point{(double)(rand() % 256), (double)(rand() % 256)});
+
+		auto start = std::chrono::high_resolution_clock::now();
+		int clusters = grid.run(points, labels, eps, min);
+		gridTime += elapsed(start);
+
+		GridDbscan fresh;
+		start = std::chrono::high_resolution_clock::now();
+		fresh.run(points, refLabels, eps, min);
+		freshTime += elapsed(start);
+		int refClusters = dbscan(points, refLabels, eps, min);
+
+		mismatches += (clusters != refClusters);
+		for (size_t i = 0; i < points.size(); ++i) {
+			if (labels[i] != refLabels[i])
+				mismatches++;
+			if (labels[i] > 0)
+				cores++;
+		}
+		reused += grid.reused;
+	}
+
+	std::cout << "DBSCAN drift " << count << " points eps " << eps << " " << passes << " passes"
+	          << " reused: " << gridTime / passes << "ms"
+	          << " full: " << freshTime / passes << "ms"
+	          << " reused cores: " << 100.0 * reused / cores << "%"
+	          << " mismatches: " << mismatches << std::endl;
+	return mismatches;
+}
+
+int main() {
+	srand(42);
+	bench(1000, 10.0, 3);
+	bench(10000, 10.0, 3);
+	bench(10000, 1.42, 8);
+
+	int mismatches = drift(2000, 10.0, 3, 20);
+	mismatches += drift(10000, 1.42, 8, 10);
+	mismatches += drift(2000, 3.0, 1, 20);
+	return mismatches > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "Components/Components.hpp"
+#include "FlowField.hpp"
+
+// previous std::list based build, kept as reference for output and timing comparison
+class LegacyFlowField {
+public:
+	std::vector<field_t> _fields;
+	std::vector<dir_t> _dir;
+	Grid _grid;
+
+	LegacyFlowField(Grid grid) : _grid(grid) {}
+
+	bool checkIfContains(unsigned int idx, const std::list<unsigned int>& lst) const {
+		for (unsigned int i : lst) {
+			if (i == idx)
+				return true;
+		}
+		return false;
+	}
+
+	int getNeighbors(int x, int y, int * ret) {
+		int cnt = 0;
+		if (_grid.bound(x, y - 1) && _grid.pathAvailable(x, y - 1))
+			ret[cnt++] = x + (y - 1) * _grid.width;
+		if (_grid.bound(x, y + 1) && _grid.pathAvailable(x, y + 1))
+			ret[cnt++] = x + (y + 1) * _grid.width;
+		if (_grid.bound(x - 1, y) && _grid.pathAvailable(x - 1, y))
+			ret[cnt++] = x - 1 + y * _grid.width;
+		if (_grid.bound(x + 1, y) && _grid.pathAvailable(x + 1, y))
+			ret[cnt++] = x + 1 + y * _grid.width;
+		return cnt;
+	}
+
+	int findLowestCost(int x, int y) {
+		int m = std::numeric_limits<field_t>::max();
+		int ret = 14;
+		for (int i = 0; i < 8; ++i) {
+			sf::Vector2i c = sf::Vector2i(x, y) + DIRECTIONS[i];
+			if (_grid.pathAvailable(c.x, c.y)) {
+				int idx = c.x + c.y * _grid.width;
+				if (_fields[idx] < m) {
+					ret = i;
+					m = _fields[idx];
+				}
+			}
+		}
+		return ret;
+	}
+
+	void build(const sf::Vector2i & end) {
+		unsigned int targetID = end.y * _grid.width + end.x;
+		_fields.assign(_grid.width * _grid.height, std::numeric_limits<field_t>::max());
+		_dir.assign(_grid.width * _grid.height, -1);
+		std::list<unsigned int> openList;
+		_fields[targetID] = 0;
+		openList.push_back(targetID);
+		int neighbors[4];
+		while (openList.size() > 0)	{
+			unsigned currentID = openList.front();
+			openList.pop_front();
+			int neighborCount = getNeighbors(currentID % _grid.width, currentID / _grid.width, neighbors);
+			for (int i = 0; i < neighborCount; ++i) {
+				unsigned int endNodeCost = _fields[currentID] + 1;
+				if (endNodeCost < _fields[neighbors[i]]) {
+					if (!checkIfContains(neighbors[i], openList))
+						openList.push_back(neighbors[i]);
+					_fields[neighbors[i]] = endNodeCost;
+				}
+			}
+		}
+		for (int x = 0; x < _grid.width; ++x) {
+			for (int y = 0; y < _grid.height; ++y) {
+				if (_grid.pathAvailable(x, y))
+					_dir[x + _grid.width * y] = findLowestCost(x, y);
+				else
+					_dir[x + _grid.width * y] = 16;
+			}
+		}
+	}
+};
+
+double elapsed(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main() {
+	const int mapSize = 144;
+	Map map;
+	map.setSize(mapSize, mapSize);
+
+	srand(42);
+	for (int i = 0; i < mapSize * mapSize / 5; ++i) {
+		map.staticPathfinding.set(rand() % mapSize, rand() % mapSize, 1);
+	}
+
+	int sizes[] = {12, 64, mapSize};
+	int iterations[] = {2000, 100, 10};
+
+	for (int s = 0; s < 3; ++s) {
+		int size = sizes[s];
+		Grid grid(&map, sf::IntRect(0, 0, size, size));
+		FlowField field;
+		field.setGrid(grid);
+		LegacyFlowField legacy(grid);
+
+		double legacyTime = 0.0;
+		double fieldTime = 0.0;
+		int mismatches = 0;
+
+		for (int i = 0; i < iterations[s]; ++i) {
+			sf::Vector2i target(rand() % size, rand() % size);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			legacy.build(target);
+			legacyTime += elapsed(start);
+
+			start = std::chrono::high_resolution_clock::now();
+			field.build(target);
+			fieldTime += elapsed(start);
+
+			for (int y = 0; y < size; ++y) {
+				for (int x = 0; x < size; ++x) {
+					int idx = x + y * size;
+					if (legacy._dir[idx] != field.get(x, y) || legacy._fields[idx] != field.getCost(x, y))
+						mismatches++;
+				}
+			}
+		}
+
+		std::cout << "FlowField " << size << "x" << size
+		          << " legacy: " << legacyTime / iterations[s] << "us"
+		          << " build: " << fieldTime / iterations[s] << "us"
+		          << " speedup: " << legacyTime / fieldTime
+		          << " mismatches: " << mismatches << std::endl;
+	}
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <cstdlib>
+
+#include "Entity.hpp"
+#include "Helpers.hpp"
+#include "Map.hpp"
+#include "FogSight.hpp"
+#include "tests/wanderers.hpp"
+
+// units wander and die, incremental fog must match a full restamp
+int main() {
+	const int players = 4;
+	const int ticks = 200;
+	Wanderers wanderers(600, players, 64, 42);
+
+	Fog fogs[players];
+	Fog stamped[players];
+	for (int i = 0; i < players; ++i) {
+		fogs[i].setSize(wanderers.mapSize, wanderers.mapSize);
+		stamped[i].setSize(wanderers.mapSize, wanderers.mapSize);
+	}
+	auto fogOf = [&fogs](EntityID player) -> Fog & {
+		return fogs[player];
+	};
+
+	FogSight sight;
+	int mismatches = 0;
+	for (int t = 0; t < ticks; ++t) {
+		wanderers.step(500);
+
+		sight.begin();
+		for (Wanderer &unit : wanderers.units) {
+			if (unit.alive && !sight.keep(unit.entity, unit.player, unit.pos, unit.view))
+				sight.see(unit.entity, unit.player, unit.pos, unit.view, wanderers.viewCells(unit), fogOf);
+		}
+		sight.end(fogOf);
+
+		// every InSight cell hidden then every unit stamped
+		for (int i = 0; i < players; ++i) {
+			for (int c = 0; c < stamped[i].size(); ++c) {
+				if (stamped[i].grid[c] == FogState::InSight)
+					stamped[i].grid[c] = FogState::Hidden;
+			}
+		}
+		for (Wanderer &unit : wanderers.units) {
+			if (unit.alive) {
+				for (sf::Vector2i const &p : wanderers.viewCells(unit)) {
+					stamped[unit.player].set(p.x, p.y, FogState::InSight);
+				}
+			}
+		}
+
+		for (int i = 0; i < players; ++i) {
+			for (int c = 0; c < fogs[i].size(); ++c) {
+				if (fogs[i].grid[c] != stamped[i].grid[c])
+					mismatches++;
+			}
+			fogs[i].clearChanged();
+		}
+	}
+
+	// every unit dead, nothing stays in sight
+	for (Wanderer &unit : wanderers.units) {
+		unit.alive = false;
+	}
+	sight.begin();
+	sight.end(fogOf);
+	for (int i = 0; i < players; ++i) {
+		for (int c = 0; c < fogs[i].size(); ++c) {
+			if (fogs[i].grid[c] == FogState::InSight || fogs[i].sight[c] != 0)
+				mismatches++;
+		}
+	}
+
+	std::cout << "FogSight mismatches: " << mismatches << std::endl;
+	return mismatches > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
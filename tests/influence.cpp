@@ -0,0 +1,88 @@
+#include <iostream>
+#include <cstdlib>
+#include <map>
+
+#include "Entity.hpp"
+#include "Helpers.hpp"
+#include "InfluenceMap.hpp"
+#include "tests/wanderers.hpp"
+
+// units wander and die, incremental presence must match a full recount
+int main() {
+	const int ticks = 200;
+	TeamID teams[3] = {TeamIDStr("rebel"), TeamIDStr("neonaz"), TeamIDStr("other")};
+	Wanderers wanderers(1000, 3, 128, 42);
+	const int mapSize = wanderers.mapSize;
+
+	InfluenceMap influence;
+	influence.setSize(mapSize, mapSize);
+
+	for (int t = 0; t < ticks; ++t) {
+		wanderers.step(500);
+
+		influence.tick();
+		for (Wanderer &unit : wanderers.units) {
+			if (unit.alive)
+				influence.move(unit.entity, teams[unit.player], unit.pos);
+			else
+				influence.remove(unit.entity);
+		}
+	}
+
+	// full recount
+	std::map<std::pair<TeamID, int>, int> counts;
+	for (Wanderer &unit : wanderers.units) {
+		if (unit.alive)
+			counts[std::make_pair(teams[unit.player], unit.pos.x / INFLUENCE_CELL + unit.pos.y / INFLUENCE_CELL * (mapSize / INFLUENCE_CELL))]++;
+	}
+
+	int mismatches = 0;
+	for (int y = 0; y < mapSize; y += INFLUENCE_CELL) {
+		for (int x = 0; x < mapSize; x += INFLUENCE_CELL) {
+			int cell = x / INFLUENCE_CELL + y / INFLUENCE_CELL * (mapSize / INFLUENCE_CELL);
+			int total = 0;
+			for (TeamID team : teams) {
+				total += counts[std::make_pair(team, cell)];
+			}
+			for (TeamID team : teams) {
+				int own = counts[std::make_pair(team, cell)];
+				if (influence.presence(team, sf::Vector2i(x, y)) != own || influence.enemyPresence(team, sf::Vector2i(x, y)) != total - own)
+					mismatches++;
+			}
+		}
+	}
+
+	// threat decays, the hottest cell stays the most attacked
+	influence.addThreat(teams[0], sf::Vector2i(10, 10), 1.0f);
+	influence.addThreat(teams[0], sf::Vector2i(100, 100), 2.0f);
+	for (int t = 0; t < 50; ++t) {
+		influence.tick();
+	}
+	influence.addThreat(teams[0], sf::Vector2i(10, 10), 0.5f);
+	sf::Vector2i hottest;
+	if (!influence.hottestThreat(teams[0], hottest) || hottest != sf::Vector2i(102, 102))
+		mismatches++;
+	for (int t = 0; t < 1000; ++t) {
+		influence.tick();
+	}
+	if (influence.hottestThreat(teams[0], hottest))
+		mismatches++;
+
+	// weakest enemy among accepted cells only, as cells a player explored
+	sf::Vector2i weakest;
+	if (influence.weakestEnemy(teams[0], weakest, [](sf::Vector2i center) { return false; }))
+		mismatches++;
+	if (influence.weakestEnemy(teams[0], weakest, [](sf::Vector2i center) { return center.x < 64 && center.y < 64; })
+	        && (weakest.x >= 64 || weakest.y >= 64 || influence.enemyPresence(teams[0], weakest) == 0))
+		mismatches++;
+
+	// threatened cells are listed with their decayed threat
+	std::vector<std::pair<sf::Vector2i, float>> threatCells;
+	influence.addThreat(teams[1], sf::Vector2i(40, 40), 3.0f);
+	influence.threatCells(teams[1], threatCells);
+	if (threatCells.size() != 1 || threatCells[0].first != sf::Vector2i(42, 42) || threatCells[0].second != 3.0f)
+		mismatches++;
+
+	std::cout << "InfluenceMap mismatches: " << mismatches << std::endl;
+	return mismatches > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "Components/Components.hpp"
+#include "Map.hpp"
+#include "third_party/JPS.h"
+
+double elapsed(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// same searches on the layers and on the walkable bitmap, paths must be identical
+void compare(const char *name, Map &map, int iterations) {
+	map.updateWalkable();
+
+	JPS::Searcher<Map> layerSearch(map);
+	JPS::Searcher<WalkabilityBitmap> bitmapSearch(map.walkable);
+
+	double layerTime = 0.0;
+	double bitmapTime = 0.0;
+	int mismatches = 0;
+	int found = 0;
+
+	for (int i = 0; i < iterations; ++i) {
+		JPS::Position start = JPS::Pos(rand() % map.width, rand() % map.height);
+		JPS::Position end = JPS::Pos(rand() % map.width, rand() % map.height);
+		if (!map.pathAvailable(start.x, start.y) || !map.pathAvailable(end.x, end.y))
+			continue;
+
+		JPS::PathVector layerPath;
+		JPS::PathVector bitmapPath;
+
+		auto t = std::chrono::high_resolution_clock::now();
+		bool layerFound = layerSearch.findPath(layerPath, start, end, 1);
+		layerTime += elapsed(t);
+
+		t = std::chrono::high_resolution_clock::now();
+		bool bitmapFound = bitmapSearch.findPath(bitmapPath, start, end, 1);
+		bitmapTime += elapsed(t);
+
+		if (layerFound != bitmapFound || layerPath != bitmapPath)
+			mismatches++;
+		if (layerFound)
+			found++;
+	}
+
+	std::cout << "JPS " << name << " " << map.width << "x" << map.height
+	          << " layers: " << layerTime / 1000.0 << "ms"
+	          << " bitmap: " << bitmapTime / 1000.0 << "ms"
+	          << " speedup: " << layerTime / bitmapTime
+	          << " found: " << found
+	          << " mismatches: " << mismatches << std::endl;
+}
+
+int main() {
+	srand(42);
+
+	{
+		// scattered obstacles
+		Map map;
+		map.setSize(256, 256);
+		for (int i = 0; i < 256 * 256 / 5; ++i) {
+			map.staticPathfinding.set(rand() % 256, rand() % 256, 1);
+		}
+		compare("random", map, 500);
+	}
+
+	{
+		// long open corridors
+		Map map;
+		map.setSize(512, 512);
+		for (int y = 0; y < 512; y += 8) {
+			for (int x = 0; x < 512; ++x) {
+				if (x != (y * 37) % 512)
+					map.staticPathfinding.set(x, y, 1);
+			}
+		}
+		compare("corridors", map, 200);
+	}
+
+	{
+		// open field with few rocks
+		Map map;
+		map.setSize(512, 512);
+		for (int i = 0; i < 400; ++i) {
+			map.staticPathfinding.set(rand() % 512, rand() % 512, 1);
+		}
+		compare("open", map, 200);
+	}
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+#include "Helpers.hpp"
+#include "MatchRandom.hpp"
+#include "WalkabilityBitmap.hpp"
+#include "ObstacleField.hpp"
+
+void setRect(WalkabilityBitmap &walkable, sf::IntRect rect, bool open) {
+	for (int y = rect.top; y < rect.top + rect.height; ++y) {
+		for (int x = rect.left; x < rect.left + rect.width; ++x) {
+			walkable.set(x, y, open);
+		}
+	}
+}
+
+// distance from ppos to the nearest cell of the other kind in the search window, out of map cells block
+bool bruteDistance(const WalkabilityBitmap &walkable, sf::Vector2f ppos, float &dist) {
+	int x = (int)floor(ppos.x / 32.0f);
+	int y = (int)floor(ppos.y / 32.0f);
+	bool open = walkable(x, y);
+	float best = -1.0f;
+	for (int ny = y - OBSTACLE_FIELD_RADIUS; ny <= y + OBSTACLE_FIELD_RADIUS; ++ny) {
+		for (int nx = x - OBSTACLE_FIELD_RADIUS; nx <= x + OBSTACLE_FIELD_RADIUS; ++nx) {
+			if ((nx != x || ny != y) && open != walkable(nx, ny)) {
+				sf::Vector2f closest(std::min(nx * 32.0f + 32.0f, std::max(nx * 32.0f, ppos.x)),
+				                     std::min(ny * 32.0f + 32.0f, std::max(ny * 32.0f, ppos.y)));
+				float d = length(ppos - closest);
+				if (best < 0.0f || d < best)
+					best = d;
+			}
+		}
+	}
+	dist = open ? best : -best;
+	return best >= 0.0f;
+}
+
+// buildings placed and removed, incremental field must match a full rebuild
+int main() {
+	MatchRandom rnd;
+	rnd.seed(42);
+	const int mapSize = 128;
+
+	WalkabilityBitmap walkable;
+	walkable.setSize(mapSize, mapSize);
+	setRect(walkable, sf::IntRect(0, 0, mapSize, mapSize), true);
+	for (int i = 0; i < 80; ++i) {
+		setRect(walkable, sf::IntRect(rnd.range(mapSize - 8), rnd.range(mapSize - 8), 1 + rnd.range(8), 1 + rnd.range(8)), false);
+	}
+
+	ObstacleField field;
+	field.setSize(mapSize, mapSize);
+	field.update(walkable, sf::IntRect(0, 0, mapSize, mapSize));
+	for (int i = 0; i < 500; ++i) {
+		sf::IntRect rect(rnd.range(mapSize - 4), rnd.range(mapSize - 4), 2 + rnd.range(3), 2 + rnd.range(3));
+		setRect(walkable, rect, rnd.range(2));
+		field.update(walkable, rect);
+	}
+
+	ObstacleField rebuilt;
+	rebuilt.setSize(mapSize, mapSize);
+	rebuilt.update(walkable, sf::IntRect(0, 0, mapSize, mapSize));
+
+	int mismatches = 0;
+	for (int i = 0; i < 50000; ++i) {
+		sf::Vector2f ppos(rnd.range(mapSize * 320) / 10.0f, rnd.range(mapSize * 320) / 10.0f);
+		float dist, rebuiltDist;
+		sf::Vector2f gradient, rebuiltGradient;
+		bool found = field.sample(ppos, dist, gradient);
+		if (found != rebuilt.sample(ppos, rebuiltDist, rebuiltGradient) || (found && (dist != rebuiltDist || gradient != rebuiltGradient)))
+			mismatches++;
+
+		// exact under a cell, farther the nearest cell is searched from the cell center
+		float brute;
+		if (found != bruteDistance(walkable, ppos, brute))
+			mismatches++;
+		if (found && fabs(brute) < 32.0f && fabs(dist - brute) > 0.001f)
+			mismatches++;
+	}
+
+	std::cout << "ObstacleField mismatches: " << mismatches << std::endl;
+	return mismatches > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
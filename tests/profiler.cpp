@@ -0,0 +1,81 @@
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+
+// zones stats from several threads, min/avg/p99 on the last durations, trace export
+int main() {
+	int errors = 0;
+	Profiler &profiler = Profiler::get();
+
+	ProfileZoneStats stats;
+	for (int i = 1; i <= 1000; ++i) {
+		stats.add((float)i);
+	}
+	// only the last PROFILER_WINDOW durations are kept
+	if (stats.calls != 1000 || stats.min() != 1000 - PROFILER_WINDOW + 1)
+		errors++;
+	if (stats.percentile(0.99f) < 997.0f || stats.avg() < 800.0f)
+		errors++;
+	std::cout << "ProfileZoneStats: min " << stats.min() << " avg " << stats.avg() << " p99 " << stats.percentile(0.99f) << std::endl;
+
+	profiler.startTrace();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.push_back(std::thread([]() {
+			for (int i = 0; i < 1000; ++i) {
+				ProfileZone zone(PROFILE_SITE("work", "test"));
+				Profiler::get().count(PROFILE_COUNTER("work items"));
+			}
+		}));
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	{
+		ProfileZone zone(PROFILE_SITE("main", "test"));
+		profiler.setCount(PROFILE_COUNTER("threads"), 4);
+	}
+	profiler.stopTrace();
+
+	std::map<std::string, ProfileZoneStats> zones = profiler.zoneStats();
+	std::map<std::string, long> counters = profiler.counterValues();
+	if (zones["work"].calls != 4000 || zones["work"].category != "test" || zones["main"].calls != 1)
+		errors++;
+	if (counters["work items"] != 4000 || counters["threads"] != 4)
+		errors++;
+	// counter sites of the same name share their id
+	if (PROFILE_COUNTER("work items") != PROFILE_COUNTER("work items") || PROFILE_COUNTER("work items") == PROFILE_COUNTER("threads"))
+		errors++;
+	// 4000 zones, 4000 counts, 1 zone, 1 count
+	if (profiler.traceSize() != 8002)
+		errors++;
+
+	std::stringstream out;
+	profiler.writeTrace(out);
+	std::string json = out.str();
+	size_t events = 0;
+	for (size_t pos = json.find("\"ph\""); pos != std::string::npos; pos = json.find("\"ph\"", pos + 1)) {
+		events++;
+	}
+	if (events != 8002 || json.find("{\"traceEvents\":[") != 0)
+		errors++;
+
+	// disabled zones are not recorded
+	profiler.enabled = false;
+	{
+		ProfileZone zone(PROFILE_SITE("main", "test"));
+	}
+	profiler.enabled = true;
+	if (profiler.zoneStats()["main"].calls != 1)
+		errors++;
+
+	profiler.reset();
+	if (profiler.zoneStats().size() != 0 || profiler.counterValues().size() != 0 || profiler.traceSize() != 0)
+		errors++;
+
+	std::cout << "Profiler errors: " << errors << std::endl;
+	return errors > 0;
+}
@@ -0,0 +1,83 @@
+#include <iostream>
+#include <cstdlib>
+#include <map>
+
+#include "Regions.hpp"
+#include "MatchRandom.hpp"
+
+struct Grid {
+	int width;
+	int height;
+	std::vector<bool> walkable;
+
+	bool operator()(int x, int y) const {
+		return this->walkable[x + y * this->width];
+	}
+};
+
+// same partition of the walkable cells, labels may differ
+int mismatches(const RegionLabels &regions, const RegionLabels &full) {
+	int count = 0;
+	std::map<unsigned int, unsigned int> toFull;
+	std::map<unsigned int, unsigned int> fromFull;
+	for (int y = 0; y < full.height; ++y) {
+		for (int x = 0; x < full.width; ++x) {
+			unsigned int label = regions.get(x, y);
+			unsigned int fullLabel = full.get(x, y);
+			if ((label == 0) != (fullLabel == 0)) {
+				count++;
+			} else if (label != 0) {
+				if (toFull.count(label) == 0)
+					toFull[label] = fullLabel;
+				if (fromFull.count(fullLabel) == 0)
+					fromFull[fullLabel] = label;
+				if (toFull[label] != fullLabel || fromFull[fullLabel] != label)
+					count++;
+			}
+		}
+	}
+	return count;
+}
+
+// walls and buildings added and removed, incremental labels must match a full labelling
+int main() {
+	const int size = 96;
+	const int changes = 2000;
+	MatchRandom rnd;
+	rnd.seed(7);
+
+	Grid grid{size, size, std::vector<bool>(size * size, true)};
+	// walls with gaps, so changes join and split regions
+	for (int i = 0; i < 40; ++i) {
+		int x = rnd.range(size);
+		int y = rnd.range(size);
+		bool horizontal = rnd.range(2) == 0;
+		for (int l = 0; l < 4 + rnd.range(40); ++l) {
+			int wx = horizontal ? x + l : x;
+			int wy = horizontal ? y : y + l;
+			if (wx < size && wy < size)
+				grid.walkable[wx + wy * size] = false;
+		}
+	}
+
+	RegionLabels regions;
+	regions.build(grid, size, size);
+	int errors = 0;
+	for (int i = 0; i < changes; ++i) {
+		sf::IntRect rect(rnd.range(size - 1), rnd.range(size - 1), 1 + rnd.range(4), 1 + rnd.range(4));
+		bool walkable = rnd.range(3) == 0;
+		for (int y = rect.top; y < std::min(size, rect.top + rect.height); ++y) {
+			for (int x = rect.left; x < std::min(size, rect.left + rect.width); ++x) {
+				grid.walkable[x + y * size] = walkable;
+			}
+		}
+		regions.update(grid, rect);
+
+		RegionLabels full;
+		full.build(grid, size, size);
+		errors += mismatches(regions, full);
+	}
+
+	std::cout << "RegionLabels: " << changes << " changes, " << regions.splits << " split floods, mismatches: " << errors << std::endl;
+	return errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+
+#include "MatchRandom.hpp"
+#include "Replay.hpp"
+#include "GameEngine.hpp"
+#include "WorldHash.hpp"
+
+// plays unit sounds as the interface does on selection, not a command so never recorded
+class Selection : public GameSystem {
+public:
+	Selection(GameVault *vault, Map *map) {
+		this->setShared(vault, map, 0, 0);
+	}
+
+	void select(EntityID player) {
+		auto view = this->vault->registry.persistent<Unit, GameObject>();
+		for (EntityID entity : view) {
+			if (view.get<GameObject>(entity).player == player)
+				this->playRandomUnitSound(entity, "select");
+		}
+	}
+};
+
+// world hash totals per tick of a headless match, recorded or replayed
+// with a recording, the units of the player are ordered to move at tick 5
+// selecting, the player units are selected every few ticks
+std::vector<uint64_t> headlessTotals(const MatchSettings &settings, unsigned long ticks, std::string record, const Replay *replay, bool selecting) {
+	GameVault vault;
+	GameEngine *engine = new GameEngine(&vault, settings);
+	Selection selection(&vault, engine->map);
+	if (record.size() > 0)
+		engine->commands.startRecord(record, settings);
+	if (replay)
+		engine->commands.play(*replay);
+
+	WorldHasher hasher(vault.registry, *engine->map);
+	std::vector<uint64_t> totals;
+	bool ordered = false;
+	while (engine->ticks < ticks && !engine->nextStage) {
+		unsigned long tick = engine->ticks;
+		if (record.size() > 0 && tick == 5 && !ordered) {
+			EntityID player = vault.registry.get<GameController>().currentPlayer;
+			std::vector<EntityID> units;
+			auto view = vault.registry.persistent<Unit, GameObject>();
+			for (EntityID entity : view) {
+				if (view.get<GameObject>(entity).player == player)
+					units.push_back(entity);
+			}
+			vault.dispatcher.trigger<CommandIssued>(CommandType::Move, player, units, sf::Vector2i(settings.mapWidth / 2, settings.mapHeight / 2), "");
+			ordered = true;
+		}
+		if (selecting && tick % 4 == 1)
+			selection.select(vault.registry.get<GameController>().currentPlayer);
+		engine->step();
+		if (engine->ticks != tick)
+			totals.push_back(hasher.hash(engine->ticks).total());
+	}
+	delete engine;
+	return totals;
+}
+
+// same seed same sequence, replay written then loaded back unchanged, replayed match hashes as recorded
+int main() {
+	int errors = 0;
+
+	MatchRandom a, b;
+	a.seed(1234);
+	b.seed(1234);
+	for (int i = 0; i < 100000; ++i) {
+		if (a.next() != b.next())
+			errors++;
+	}
+
+	// pcg32 reference sequence, independent of the platform rand()
+	const uint32_t expected[4] = {79146399u, 1485350530u, 300913445u, 1132500397u};
+	MatchRandom ref;
+	ref.seed(42);
+	std::cout << "MatchRandom seed 42:";
+	for (int i = 0; i < 4; ++i) {
+		uint32_t value = ref.next();
+		std::cout << " " << value;
+		if (value != expected[i])
+			errors++;
+	}
+	std::cout << std::endl;
+
+	MatchRandom r;
+	r.seed(7);
+	int counts[6] = {0};
+	float minU = 1.0f, maxU = 0.0f;
+	for (int i = 0; i < 600000; ++i) {
+		counts[r.range(6)]++;
+		float u = r.uniform();
+		minU = std::min(minU, u);
+		maxU = std::max(maxU, u);
+	}
+	for (int i = 0; i < 6; ++i) {
+		if (counts[i] < 95000 || counts[i] > 105000)
+			errors++;
+	}
+	if (minU < 0.0f || maxU >= 1.0f)
+		errors++;
+
+	std::vector<int> v, w;
+	for (int i = 0; i < 32; ++i) {
+		v.push_back(i);
+	}
+	w = v;
+	a.seed(99);
+	b.seed(99);
+	a.shuffle(v.begin(), v.end());
+	b.shuffle(w.begin(), w.end());
+	if (v != w)
+		errors++;
+
+	Replay replay;
+	replay.settings.mapWidth = 96;
+	replay.settings.mapHeight = 72;
+	replay.settings.playerTeam = "rebel";
+	replay.settings.seed = 1539000000;
+	Command move = {120, CommandType::Move, 3, {12, 13, 14}, sf::Vector2i(40, 18), ""};
+	Command train = {300, CommandType::Train, 3, {27}, sf::Vector2i(0, 0), "zork"};
+	Command root = {301, CommandType::Build, 3, {}, sf::Vector2i(0, 0), "taverne"};
+
+	std::stringstream out;
+	Replay::writeSettings(out, replay.settings);
+	Replay::writeCommand(out, move);
+	Replay::writeCommand(out, train);
+	Replay::writeCommand(out, root);
+
+	const char *filename = "/tmp/bfr_replay_test.txt";
+	{
+		std::ofstream file(filename);
+		file << out.str();
+	}
+
+	Replay loaded;
+	if (!loaded.load(filename))
+		errors++;
+	std::remove(filename);
+
+	if (loaded.settings.mapWidth != 96 || loaded.settings.mapHeight != 72 || loaded.settings.playerTeam != "rebel" || loaded.settings.seed != 1539000000 || loaded.settings.aiTeams.size() != 0)
+		errors++;
+	if (loaded.commands.size() != 3) {
+		errors++;
+	} else {
+		std::stringstream again;
+		Replay::writeSettings(again, loaded.settings);
+		for (Command const &command : loaded.commands) {
+			Replay::writeCommand(again, command);
+		}
+		if (again.str() != out.str())
+			errors++;
+	}
+
+	std::cout << out.str();
+
+	// match recorded with a player command and selections then replayed from the file without them
+	MatchSettings settings;
+	settings.seed = 1;
+	settings.playerTeam = "rebel";
+	settings.aiTeams.push_back("neonaz");
+	const char *recordname = "/tmp/bfr_replay_record.txt";
+	std::vector<uint64_t> recorded = headlessTotals(settings, 50, recordname, nullptr, true);
+
+	Replay record;
+	if (!record.load(recordname) || record.commands.size() != 1) {
+		errors++;
+	} else {
+		std::vector<uint64_t> replayed = headlessTotals(record.settings, 50, "", &record, false);
+		if (recorded.size() != 50 || replayed != recorded)
+			errors++;
+		std::cout << "Replay: " << replayed.size() << " ticks, last world hash " << std::hex << (replayed.size() > 0 ? replayed.back() : 0) << std::dec << std::endl;
+	}
+	std::remove(recordname);
+
+	std::cout << "Replay errors: " << errors << std::endl;
+	return errors > 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "Entity.hpp"
+#include "Helpers.hpp"
+#include "Quadtree.hpp"
+#include "SpatialHash.hpp"
+
+class BenchObject : public sf::Vector2f {
+public:
+	EntityID entity;
+
+	BenchObject(EntityID ent, float x, float y) : sf::Vector2f(x, y), entity(ent) {}
+};
+
+double elapsed(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// units clustered like in a game, query the 64x64px around each unit like SteeringSystem
+void bench(int count, int frames) {
+	const float mapSize = 256 * 32.0f;
+	std::vector<BenchObject> units;
+	for (int i = 0; i < count; ++i) {
+		float cx = (rand() % 16) * mapSize / 16.0f;
+		float cy = (rand() % 16) * mapSize / 16.0f;
+		units.push_back(BenchObject(i + 1, cx + rand() % 512, cy + rand() % 512));
+	}
+
+	Quadtree<BenchObject> quadtree(0.0, 0.0, mapSize, mapSize, 16);
+	SpatialHash<BenchObject> hash(mapSize, mapSize);
+
+	double quadtreeTime = 0.0;
+	double hashTime = 0.0;
+	unsigned long quadtreeFound = 0;
+	unsigned long hashFound = 0;
+	int missed = 0;
+
+	std::vector<BenchObject> found;
+	for (int f = 0; f < frames; ++f) {
+		for (BenchObject &unit : units) {
+			unit.x = std::min(mapSize - 1.0f, std::max(0.0f, unit.x + (rand() % 5 - 2)));
+			unit.y = std::min(mapSize - 1.0f, std::max(0.0f, unit.y + (rand() % 5 - 2)));
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		quadtree.clear();
+		for (BenchObject &unit : units) {
+			quadtree.add(unit);
+		}
+		for (BenchObject &unit : units) {
+			std::vector<BenchObject> quadObjs;
+			quadObjs.reserve(64);
+			quadtree.retrieve(quadObjs, unit.x - 32.0f, unit.y - 32.0f, 64.0f, 64.0f);
+			quadtreeFound += quadObjs.size();
+		}
+		quadtreeTime += elapsed(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (BenchObject &unit : units) {
+			hash.add(unit);
+		}
+		hash.build();
+		for (BenchObject &unit : units) {
+			found.clear();
+			hash.retrieve(found, unit.x - 32.0f, unit.y - 32.0f, 64.0f, 64.0f);
+			hashFound += found.size();
+		}
+		hashTime += elapsed(start);
+
+		// every unit closer than 32px must be found
+		for (int i = 0; i < 10; ++i) {
+			BenchObject &unit = units[rand() % count];
+			found.clear();
+			hash.retrieve(found, unit.x - 32.0f, unit.y - 32.0f, 64.0f, 64.0f);
+			for (BenchObject &other : units) {
+				if (distance(unit, other) < 32.0f) {
+					bool in = false;
+					for (BenchObject &o : found) {
+						in |= o.entity == other.entity;
+					}
+					missed += !in;
+				}
+			}
+		}
+	}
+
+	std::cout << "Spatial index " << count << " units"
+	          << " quadtree: " << quadtreeTime / frames << "ms/frame (" << quadtreeFound / frames << " found)"
+	          << " hash: " << hashTime / frames << "ms/frame (" << hashFound / frames << " found)"
+	          << " speedup: " << quadtreeTime / hashTime
+	          << " missed: " << missed << std::endl;
+}
+
+int main() {
+	srand(42);
+	bench(500, 100);
+	bench(2000, 50);
+	bench(10000, 20);
+}
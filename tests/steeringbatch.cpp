@@ -0,0 +1,147 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+
+#include "Entity.hpp"
+#include "Helpers.hpp"
+#include "SpatialHash.hpp"
+#include "SteeringBatch.hpp"
+
+class BenchObject : public sf::Vector2f {
+public:
+	EntityID entity;
+	sf::Vector2f pos;
+	sf::Vector2f velocity;
+	float maxSpeed;
+	float maxForce;
+
+	BenchObject(EntityID ent, sf::Vector2f p, sf::Vector2f v, float speed) : sf::Vector2f(p), entity(ent), pos(p), velocity(v), maxSpeed(speed), maxForce(MAX_FORCE) {}
+};
+
+struct BenchUnit {
+	BenchObject obj;
+	sf::Vector2i direction;
+	sf::Vector2f away; // obstacle field gradient
+};
+
+double elapsed(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// neighbours are queried from the hash each frame, like SteeringSystem
+double runBatch(SteeringBatch &batch, ChunkWorkers &workers, const SpatialHash<BenchObject> &hash, std::vector<BenchUnit> &units, int frames) {
+	double time = 0.0;
+	for (int f = 0; f < frames; ++f) {
+		auto t = std::chrono::high_resolution_clock::now();
+		batch.clear();
+		for (BenchUnit &unit : units) {
+			batch.add(unit.obj.pos, unit.obj.velocity, unit.obj.maxSpeed);
+		}
+		batch.run(workers, [&batch, &hash, &units](unsigned int i, SteeringPairs & pairs) {
+			BenchUnit &unit = units[i];
+			hash.forEach(unit.obj.pos.x - 32.0f, unit.obj.pos.y - 32.0f, 64.0f, 64.0f, [&unit, &pairs](const BenchObject & other) {
+				if (other.entity != unit.obj.entity)
+					pairs.addNeighbor(other.pos);
+			});
+			if (unit.away != sf::Vector2f(0, 0))
+				batch.setAvoid(i, unit.away);
+			batch.setFlow(i, sf::Vector2f(unit.direction), 1.5f);
+		});
+		time += elapsed(t);
+	}
+	return time;
+}
+
+// units clustered like in a game, per unit Steering<T> against the batch kernels
+// batch times include copying units and pairs, like the game does each frame
+void bench(int count, int frames) {
+	const float mapSize = 128 * 32.0f;
+	SpatialHash<BenchObject> hash(mapSize, mapSize);
+	std::vector<BenchUnit> units;
+	for (int i = 0; i < count; ++i) {
+		float cx = (rand() % 8) * mapSize / 8.0f;
+		float cy = (rand() % 8) * mapSize / 8.0f;
+		BenchObject obj(i + 1, sf::Vector2f(cx + rand() % 384, cy + rand() % 384),
+		                sf::Vector2f((rand() % 200 - 100) / 100.0f, (rand() % 200 - 100) / 100.0f), 1.0f + (rand() % 3) * 0.5f);
+		units.push_back(BenchUnit{obj, sf::Vector2i(rand() % 3 - 1, rand() % 3 - 1)});
+		hash.add(obj);
+	}
+	hash.build();
+
+	for (BenchUnit &unit : units) {
+		if (rand() % 3 == 0)
+			unit.away = normalize(sf::Vector2f(rand() % 200 - 100, rand() % 200 - 100));
+	}
+
+	Steering<BenchObject> steering;
+	std::vector<BenchObject> neighbors;
+	std::vector<sf::Vector2f> refPos(count);
+	std::vector<sf::Vector2f> refVel(count);
+
+	auto t = std::chrono::high_resolution_clock::now();
+	for (int f = 0; f < frames; ++f) {
+		for (int i = 0; i < count; ++i) {
+			BenchUnit &unit = units[i];
+			neighbors.clear();
+			hash.forEach(unit.obj.pos.x - 32.0f, unit.obj.pos.y - 32.0f, 64.0f, 64.0f, [&unit, &neighbors](const BenchObject & other) {
+				if (other.entity != unit.obj.entity)
+					neighbors.push_back(other);
+			});
+			sf::Vector2f accel(0, 0);
+			accel += steering.avoid(unit.obj, unit.away) * AVOID_WEIGHT;
+			accel += steering.followFlowField(unit.obj, unit.direction) * 1.5f;
+			accel += steering.separate(unit.obj, neighbors) * SEPARATE_WEIGHT;
+			refVel[i] = limit(unit.obj.velocity + accel, unit.obj.maxSpeed * MIN_VELOCITY, unit.obj.maxSpeed);
+			refPos[i] = unit.obj.pos + refVel[i];
+		}
+	}
+	double refTime = elapsed(t);
+
+	ChunkWorkers serial;
+	SteeringBatch scalar;
+	scalar.setSimd(false);
+	double scalarTime = runBatch(scalar, serial, hash, units, frames);
+
+	SteeringBatch simd;
+	double simdTime = runBatch(simd, serial, hash, units, frames);
+
+	// workers scaling, the caller thread takes chunks too
+	std::vector<double> parallelTimes;
+	for (int threads = 1; threads <= 7; threads = threads * 2 + 1) {
+		ChunkWorkers workers;
+		workers.start(threads);
+		SteeringBatch parallel;
+		parallelTimes.push_back(runBatch(parallel, workers, hash, units, frames));
+		for (int i = 0; i < count; ++i) {
+			if (parallel.outX[i] != simd.outX[i] || parallel.outY[i] != simd.outY[i])
+				parallelTimes.back() = -1.0;
+		}
+	}
+
+	float maxError = 0.0f;
+	for (int i = 0; i < count; ++i) {
+		maxError = std::max(maxError, length(refVel[i] - sf::Vector2f(simd.outVx[i], simd.outVy[i])));
+		maxError = std::max(maxError, length(refPos[i] - sf::Vector2f(simd.outX[i], simd.outY[i])));
+		maxError = std::max(maxError, length(refVel[i] - sf::Vector2f(scalar.outVx[i], scalar.outVy[i])));
+	}
+
+	std::cout << "Steering " << count << " units"
+	          << " per unit: " << count * frames / refTime << " units/ms"
+	          << " batch scalar: " << count * frames / scalarTime << " units/ms"
+	          << " batch simd: " << count * frames / simdTime << " units/ms"
+	          << " max error: " << maxError << std::endl;
+	for (unsigned int i = 0; i < parallelTimes.size(); ++i) {
+		std::cout << "  " << (2 << i) << " threads: ";
+		if (parallelTimes[i] < 0)
+			std::cout << "results differ from one thread" << std::endl;
+		else
+			std::cout << count * frames / parallelTimes[i] << " units/ms" << std::endl;
+	}
+}
+
+int main() {
+	srand(42);
+	bench(500, 200);
+	bench(2000, 100);
+	bench(10000, 20);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "Entity.hpp"
+#include "MatchRandom.hpp"
+
+// units of a few players scattered on a square map, used by map layers checks and the bench
+struct Wanderer {
+	EntityID entity;
+	int player;
+	sf::Vector2i pos;
+	unsigned int view;
+	bool alive;
+};
+
+class Wanderers {
+	MatchRandom rnd;
+
+public:
+	std::vector<Wanderer> units;
+	int mapSize;
+
+	Wanderers(int count, int players, int mapSize, uint32_t seed) {
+		this->mapSize = mapSize;
+		this->rnd.seed(seed);
+		for (int i = 0; i < count; ++i) {
+			sf::Vector2i pos(this->rnd.range(mapSize), this->rnd.range(mapSize));
+			this->units.push_back(Wanderer{(EntityID)(i + 1), i % players, pos, (unsigned int)(2 + this->rnd.range(5)), true});
+		}
+	}
+
+	// a quarter of the units move by one cell, one in dieEvery dies
+	void step(int dieEvery) {
+		for (Wanderer &unit : this->units) {
+			if (this->rnd.range(4) == 0)
+				unit.pos = sf::Vector2i(std::min(this->mapSize - 1, std::max(0, unit.pos.x + this->rnd.range(3) - 1)),
+				                        std::min(this->mapSize - 1, std::max(0, unit.pos.y + this->rnd.range(3) - 1)));
+			if (this->rnd.range(dieEvery) == 0)
+				unit.alive = false;
+		}
+	}
+
+	// square of view cells around a unit, clipped to the map
+	std::vector<sf::Vector2i> viewCells(const Wanderer &unit) const {
+		std::vector<sf::Vector2i> cells;
+		for (int y = unit.pos.y - (int)unit.view; y <= unit.pos.y + (int)unit.view; ++y) {
+			for (int x = unit.pos.x - (int)unit.view; x <= unit.pos.x + (int)unit.view; ++x) {
+				if (x >= 0 && y >= 0 && x < this->mapSize && y < this->mapSize)
+					cells.push_back(sf::Vector2i(x, y));
+			}
+		}
+		return cells;
+	}
+};
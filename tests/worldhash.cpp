@@ -0,0 +1,163 @@
+#include <iostream>
+#include <sstream>
+#include <cstdio>
+
+#include "WorldHash.hpp"
+
+// same world built in another entity order hashes the same, a change only alters its part
+EntityID createObj(entt::Registry<EntityID> &registry, Map &map, EntityID playerEnt, unsigned long serial, std::string name, int x, int y, bool unit) {
+	EntityID entity = registry.create();
+	Tile tile;
+	tile.pos = sf::Vector2i(x, y);
+	tile.ppos = sf::Vector2f(tile.pos) * 32.0f + 16.0f;
+	tile.size = sf::Vector2i(1, 1);
+	tile.state = TileStateStr("idle");
+	registry.assign<Tile>(entity, tile);
+
+	GameObject obj;
+	obj.name = name;
+	obj.team = "rebel";
+	obj.life = 100.0f;
+	obj.maxLife = 100.0f;
+	obj.view = 4;
+	obj.mapped = true;
+	obj.player = playerEnt;
+	obj.serial = serial;
+	registry.assign<GameObject>(entity, obj);
+
+	if (unit) {
+		Unit u;
+		u.speed = 2.0f;
+		registry.assign<Unit>(entity, u);
+	} else {
+		Building building;
+		building.buildTime = 0.0f;
+		building.maxBuildTime = 10.0f;
+		building.construction = 0;
+		building.constructedBy = 0;
+		registry.assign<Building>(entity, building);
+	}
+	map.objs.set(x, y, entity);
+	return entity;
+}
+
+EntityID createResource(entt::Registry<EntityID> &registry, Map &map, int x, int y) {
+	EntityID entity = registry.create();
+	Tile tile;
+	tile.pos = sf::Vector2i(x, y);
+	registry.assign<Tile>(entity, tile);
+	Resource resource;
+	resource.type = "nature";
+	registry.assign<Resource>(entity, resource);
+	map.resources.set(x, y, entity);
+	return entity;
+}
+
+struct World {
+	entt::Registry<EntityID> registry;
+	Map map;
+	EntityID playerEnt;
+	EntityID unitEnt;
+
+	World(bool reversed) {
+		this->map.setSize(32, 32);
+		// entity 0 stands for none, as the game empty entity
+		this->registry.create();
+		// entities unrelated to the simulation shift ids, as effects do
+		if (reversed) {
+			for (int i = 0; i < 7; ++i) {
+				this->registry.create();
+			}
+		}
+
+		this->playerEnt = this->registry.create();
+		Player player;
+		player.team = "rebel";
+		player.ai = true;
+		player.resources = 10;
+		player.butchery = 0;
+		player.enemyFound = false;
+		player.rootConstruction = 0;
+		player.fog.setSize(32, 32);
+		this->registry.assign<Player>(this->playerEnt, player);
+
+		if (reversed) {
+			createResource(this->registry, this->map, 20, 3);
+			createResource(this->registry, this->map, 5, 6);
+			createObj(this->registry, this->map, this->playerEnt, 3, "taverne", 10, 10, false);
+			this->unitEnt = createObj(this->registry, this->map, this->playerEnt, 2, "zork", 4, 7, true);
+			createObj(this->registry, this->map, this->playerEnt, 1, "zork", 3, 7, true);
+		} else {
+			createObj(this->registry, this->map, this->playerEnt, 1, "zork", 3, 7, true);
+			this->unitEnt = createObj(this->registry, this->map, this->playerEnt, 2, "zork", 4, 7, true);
+			createObj(this->registry, this->map, this->playerEnt, 3, "taverne", 10, 10, false);
+			createResource(this->registry, this->map, 5, 6);
+			createResource(this->registry, this->map, 20, 3);
+		}
+	}
+
+	WorldHash hash(unsigned long tick) {
+		WorldHasher hasher(this->registry, this->map);
+		return hasher.hash(tick);
+	}
+};
+
+int main() {
+	int errors = 0;
+
+	World a(false), b(true);
+	WorldHash ha = a.hash(1);
+	WorldHash hb = b.hash(1);
+	if (ha.total() != hb.total()) {
+		std::cout << "WorldHash: same world, different hashes" << std::endl;
+		errors++;
+	}
+
+	b.registry.get<Unit>(b.unitEnt).velocity = sf::Vector2f(0.5f, 0.0f);
+	WorldHash changed = b.hash(2);
+	for (int p = 0; p < WorldHashParts; ++p) {
+		if ((changed.parts[p] != ha.parts[p]) != (p == UnitsHash)) {
+			std::cout << "WorldHash: unexpected change in " << worldHashPartNames[p] << std::endl;
+			errors++;
+		}
+	}
+
+	b.registry.get<Unit>(b.unitEnt).velocity = sf::Vector2f(0.0f, 0.0f);
+	b.registry.get<Tile>(b.unitEnt).ppos.x += 1.0f;
+	if (b.hash(3).parts[ObjectsHash] == ha.parts[ObjectsHash])
+		errors++;
+
+	std::vector<WorldHash> golden;
+	golden.push_back(a.hash(1));
+	golden.push_back(a.hash(2));
+	golden.push_back(a.hash(3));
+
+	MatchSettings settings;
+	settings.seed = 1;
+	const char *filename = "/tmp/bfr_worldhash_test.txt";
+	{
+		std::ofstream file(filename);
+		WorldHashStream::writeSettings(file, settings);
+		for (WorldHash const &hash : golden) {
+			WorldHashStream::writeHash(file, hash);
+		}
+	}
+	WorldHashStream stream;
+	if (!stream.load(filename) || stream.hashes.size() != 3 || stream.settings.seed != 1)
+		errors++;
+	std::remove(filename);
+
+	if (WorldHashStream::compare(stream.hashes, golden, std::cout) != -1)
+		errors++;
+
+	std::vector<WorldHash> drifted = golden;
+	drifted[2] = b.hash(3);
+	if (WorldHashStream::compare(stream.hashes, drifted, std::cout) != 2)
+		errors++;
+
+	std::stringstream out;
+	WorldHashStream::writeHash(out, ha);
+	std::cout << out.str();
+	std::cout << "WorldHash errors: " << errors << std::endl;
+	return errors > 0;
+}